@@ -0,0 +1,208 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GPUCulling.h"
+#include "IndirectDrawBuilder.h"
+#include "RenderingContext/RenderingContext.h"
+#include "Shader/Shader.h"
+#include "Shader/ShaderObjectInfo.h"
+#include "Shader/Uniform.h"
+#include "Texture/Texture.h"
+#include "GLHeader.h"
+#include "Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Util/Macros.h>
+#include <cstdint>
+#include <string>
+
+namespace Rendering {
+
+static_assert(sizeof(GPUCulling::ObjectBounds) == 32, "Unexpected std430 size of ObjectBounds.");
+
+static const std::string cullingProgram(R"***(#version 430
+layout(local_size_x = 64) in;
+
+struct Command {
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+struct DrawData {
+	mat4 modelMatrix;
+	uint materialIndex;
+};
+struct ObjectBounds {
+	vec4 minCorner;
+	vec4 maxCorner;
+};
+
+layout(std430, binding = 0) readonly buffer InputCommands { Command inputCommands[]; };
+layout(std430, binding = 1) readonly buffer InputDrawData { DrawData drawData[]; };
+layout(std430, binding = 2) readonly buffer InputBounds { ObjectBounds bounds[]; };
+layout(std430, binding = 3) writeonly buffer OutputCommands { Command outputCommands[]; };
+layout(binding = 0, offset = 0) uniform atomic_uint visibleCount;
+
+uniform mat4 worldToClipping;
+uniform int drawCount;
+uniform bool frustumCulling;
+uniform bool occlusionCulling;
+uniform sampler2D depthPyramid;
+
+bool isOccluded(vec3 ndcMin, vec3 ndcMax) {
+	vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0);
+	vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0);
+	float nearestDepth = ndcMin.z * 0.5 + 0.5;
+
+	// choose the level where the box covers at most 2x2 texels
+	vec2 size = (uvMax - uvMin) * vec2(textureSize(depthPyramid, 0));
+	int maxLevel = textureQueryLevels(depthPyramid) - 1;
+	int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, maxLevel);
+
+	ivec2 levelSize = textureSize(depthPyramid, level);
+	ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+	ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+	float farthestDepth = max(max(texelFetch(depthPyramid, texelMin, level).r, texelFetch(depthPyramid, ivec2(texelMax.x, texelMin.y), level).r),
+							max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(depthPyramid, texelMax, level).r));
+	return nearestDepth > farthestDepth;
+}
+
+void main() {
+	uint drawId = gl_GlobalInvocationID.x;
+	if(int(drawId) >= drawCount || inputCommands[drawId].instanceCount == 0)
+		return;
+
+	mat4 modelToClipping = worldToClipping * drawData[drawId].modelMatrix;
+	vec3 boxMin = bounds[drawId].minCorner.xyz;
+	vec3 boxMax = bounds[drawId].maxCorner.xyz;
+
+	// bits of the frustum planes (-x, +x, -y, +y, -z, +z) all corners are outside of
+	uint outside = 0x3fu;
+	bool behindCamera = false;
+	vec3 ndcMin = vec3(1.0);
+	vec3 ndcMax = vec3(-1.0);
+	for(int i = 0; i < 8; ++i) {
+		vec3 corner = vec3((i & 1) != 0 ? boxMax.x : boxMin.x, (i & 2) != 0 ? boxMax.y : boxMin.y, (i & 4) != 0 ? boxMax.z : boxMin.z);
+		vec4 clipPos = modelToClipping * vec4(corner, 1.0);
+		uint cornerOutside = 0u;
+		cornerOutside |= clipPos.x < -clipPos.w ? 0x01u : 0u;
+		cornerOutside |= clipPos.x > clipPos.w ? 0x02u : 0u;
+		cornerOutside |= clipPos.y < -clipPos.w ? 0x04u : 0u;
+		cornerOutside |= clipPos.y > clipPos.w ? 0x08u : 0u;
+		cornerOutside |= clipPos.z < -clipPos.w ? 0x10u : 0u;
+		cornerOutside |= clipPos.z > clipPos.w ? 0x20u : 0u;
+		outside &= cornerOutside;
+		if(clipPos.w <= 0.0) {
+			behindCamera = true;
+		} else {
+			vec3 ndc = clipPos.xyz / clipPos.w;
+			ndcMin = min(ndcMin, ndc);
+			ndcMax = max(ndcMax, ndc);
+		}
+	}
+	if(frustumCulling && outside != 0)
+		return;
+	// boxes intersecting the camera plane are never occluded
+	if(occlusionCulling && !behindCamera && isOccluded(ndcMin, ndcMax))
+		return;
+
+	outputCommands[atomicCounterIncrement(visibleCount)] = inputCommands[drawId];
+}
+)***");
+
+//! (static)
+bool GPUCulling::isSupported() {
+	#if defined(LIB_GL) && defined(GL_VERSION_4_3)
+		static const bool support = isExtensionSupported("GL_VERSION_4_3");
+		return support;
+	#else
+		return false;
+	#endif
+}
+
+GPUCulling::GPUCulling() : capacity(0), lastDrawCount(0), frustumCulling(true) {
+}
+
+GPUCulling::~GPUCulling() = default;
+
+void GPUCulling::cull(RenderingContext & context, const Geometry::Matrix4x4 & worldToClipping, uint32_t drawCount,
+						BufferObject & commands, BufferObject & drawData, BufferObject & bounds, Texture * depthPyramid) {
+	if(!isSupported()) {
+		WARN("GPUCulling: Compute shaders are not supported.");
+		return;
+	}
+	if(shader.isNull()) {
+		shader = Shader::createShader(Shader::USE_UNIFORMS);
+		shader->attachShaderObject(ShaderObjectInfo::createCompute(cullingProgram));
+		if(!shader->init()) {
+			WARN("GPUCulling: The culling shader could not be created.");
+			shader = nullptr;
+			return;
+		}
+	}
+	if(drawCount > capacity || !culledCommands.isValid()) {
+		capacity = drawCount;
+		culledCommands.allocateData<DrawElementsIndirectCommand>(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, capacity, BufferObject::USAGE_DYNAMIC_DRAW);
+	}
+	const uint32_t zero = 0;
+	if(!visibleCount.isValid())
+		visibleCount.uploadData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, reinterpret_cast<const uint8_t*>(&zero), sizeof(zero), BufferObject::USAGE_DYNAMIC_DRAW);
+	else
+		visibleCount.uploadSubData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, reinterpret_cast<const uint8_t*>(&zero), sizeof(zero));
+	lastDrawCount = drawCount;
+	if(drawCount == 0)
+		return;
+
+	context.pushAndSetShader(shader.get());
+	if(depthPyramid)
+		context.pushAndSetTexture(0, depthPyramid);
+	shader->setUniform(context, Uniform("worldToClipping", worldToClipping));
+	shader->setUniform(context, Uniform("drawCount", static_cast<int32_t>(drawCount)));
+	shader->setUniform(context, Uniform("frustumCulling", frustumCulling));
+	shader->setUniform(context, Uniform("occlusionCulling", depthPyramid != nullptr));
+	shader->setUniform(context, Uniform("depthPyramid", 0), false);
+
+	commands.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+	drawData.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	bounds.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 2);
+	culledCommands.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 3);
+	visibleCount.bind(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, 0);
+
+	context.dispatchCompute((drawCount + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE);
+	context.barrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	visibleCount.unbind(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, 0);
+	culledCommands.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 3);
+	bounds.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 2);
+	drawData.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 1);
+	commands.unbind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, 0);
+
+	if(depthPyramid)
+		context.popTexture(0);
+	context.popShader();
+}
+
+uint32_t GPUCulling::downloadVisibleCount() const {
+	if(!visibleCount.isValid())
+		return 0;
+	uint32_t count = 0;
+	visibleCount.downloadData(BufferObject::TARGET_ATOMIC_COUNTER_BUFFER, sizeof(count), reinterpret_cast<uint8_t*>(&count));
+	return count;
+}
+
+void GPUCulling::draw(RenderingContext & context, Mesh * mesh) {
+	if(lastDrawCount == 0)
+		return;
+	if(RenderingContext::isMultiDrawIndirectCountSupported())
+		context.multiDrawIndirectCount(mesh, culledCommands, visibleCount, lastDrawCount);
+	else
+		context.multiDrawIndirect(mesh, culledCommands, downloadVisibleCount());
+}
+
+}
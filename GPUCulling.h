@@ -0,0 +1,100 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_GPUCULLING_H_
+#define RENDERING_GPUCULLING_H_
+
+#include "BufferObject.h"
+#include <Util/References.h>
+#include <cstdint>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Shader;
+class Texture;
+
+/**
+ * Compute shader culling of the draws of a multi draw indirect call (see RenderingContext::multiDrawIndirect()).
+ *
+ * Every draw is tested against the view frustum and, if a depth pyramid is given, against the depth pyramid
+ * of the previous frame. The commands of the visible draws are compacted into getCulledCommands() and their
+ * number is counted in an atomic counter in getVisibleCountBuffer(). The base instance of a compacted command is
+ * not changed, so shaders have to access the per-draw data by gl_BaseInstanceARB (as set by IndirectDrawBuilder)
+ * instead of gl_DrawIDARB.
+ *
+ * Inputs (all indexed by the draw id):
+ * - commands: DrawElementsIndirectCommand array (see IndirectDrawBuilder::uploadCommands())
+ * - drawData: IndirectDrawData array containing the model matrices (see IndirectDrawBuilder::uploadDrawData())
+ * - bounds: ObjectBounds array with the bounding boxes in model space
+ *
+ * Depth pyramid: single channel float texture with mipmaps, where every texel of level i+1 contains the maximum
+ * (farthest) depth of the corresponding 2x2 texels of level i and level 0 contains the depth buffer in [0,1].
+ *
+ * During culling, the shader storage buffer binding points 0 to 3 and the atomic counter buffer binding point 0
+ * are overwritten.
+ * @ingroup rendering_helper
+ */
+class GPUCulling {
+	public:
+		//! Axis aligned bounding box in model space (std430 layout; w is ignored).
+		struct ObjectBounds {
+			float minCorner[4];
+			float maxCorner[4];
+		};
+
+		//! Number of draws processed by one work group of the culling shader.
+		static constexpr uint32_t WORK_GROUP_SIZE = 64;
+
+		//! Returns true if the culling shader can be executed (OpenGL 4.3).
+		RENDERINGAPI static bool isSupported();
+
+		RENDERINGAPI GPUCulling();
+		RENDERINGAPI ~GPUCulling();
+
+		void setFrustumCullingEnabled(bool enabled)		{	frustumCulling = enabled;	}
+		bool isFrustumCullingEnabled() const			{	return frustumCulling;	}
+
+		/*! Cull @p drawCount draws.
+			@param worldToClipping Matrix used for the frustum test and the projection into the depth pyramid
+				(normally the camera-to-clipping matrix multiplied by the world-to-camera matrix of the previous frame
+				for the occlusion test, which usually differs only slightly from the current one).
+			@param depthPyramid Optional depth pyramid of the previous frame; if nullptr, only frustum culling is done. */
+		RENDERINGAPI void cull(RenderingContext & context, const Geometry::Matrix4x4 & worldToClipping, uint32_t drawCount,
+								BufferObject & commands, BufferObject & drawData, BufferObject & bounds,
+								Texture * depthPyramid = nullptr);
+
+		//! Compacted commands of the visible draws of the last cull() call.
+		BufferObject & getCulledCommands()				{	return culledCommands;	}
+		//! Buffer containing the number of visible draws of the last cull() call (uint32_t at offset 0).
+		BufferObject & getVisibleCountBuffer()			{	return visibleCount;	}
+
+		//! Read back the number of visible draws (stalls until the culling has been finished).
+		RENDERINGAPI uint32_t downloadVisibleCount() const;
+
+		/*! Draw the visible draws of the last cull() call. If ARB_indirect_parameters is supported, the draw count is
+			read directly from the visible count buffer; otherwise, it is read back first. */
+		RENDERINGAPI void draw(RenderingContext & context, Mesh * mesh);
+
+	private:
+		Util::Reference<Shader> shader;
+		BufferObject culledCommands;
+		BufferObject visibleCount;
+		uint32_t capacity;
+		uint32_t lastDrawCount;
+		bool frustumCulling;
+};
+
+}
+
+#endif /* RENDERING_GPUCULLING_H_ */
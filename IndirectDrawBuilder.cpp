@@ -0,0 +1,56 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "IndirectDrawBuilder.h"
+#include "BufferObject.h"
+#include <Geometry/Matrix4x4.h>
+#include <algorithm>
+
+namespace Rendering {
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "Unexpected size of DrawElementsIndirectCommand.");
+static_assert(sizeof(IndirectDrawData) == 80, "Unexpected std430 size of IndirectDrawData.");
+
+uint32_t IndirectDrawBuilder::addDraw(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex, uint32_t instanceCount) {
+	Geometry::Matrix4x4 identity;
+	identity.setIdentity();
+	return addDraw(indexCount, firstIndex, baseVertex, identity, 0, instanceCount);
+}
+
+uint32_t IndirectDrawBuilder::addDraw(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex,
+										const Geometry::Matrix4x4 & modelMatrix, uint32_t materialIndex, uint32_t instanceCount) {
+	const uint32_t drawId = getDrawCount();
+	// the base instance is set to the draw id, so that the per-draw data is also reachable without gl_DrawIDARB
+	commands.push_back({indexCount, instanceCount, firstIndex, baseVertex, drawId});
+
+	IndirectDrawData data;
+	const Geometry::Matrix4x4 transposed = modelMatrix.getTransposed();
+	std::copy(transposed.getData(), transposed.getData() + 16, data.modelMatrix);
+	data.materialIndex = materialIndex;
+	std::fill(data.padding, data.padding + 3, 0);
+	drawData.push_back(data);
+	return drawId;
+}
+
+void IndirectDrawBuilder::uploadCommands(BufferObject & buffer, uint32_t usageHint) const {
+	buffer.uploadData(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, commands, usageHint);
+}
+
+void IndirectDrawBuilder::uploadCommands(BufferObject & buffer) const {
+	uploadCommands(buffer, BufferObject::USAGE_STREAM_DRAW);
+}
+
+void IndirectDrawBuilder::uploadDrawData(BufferObject & buffer, uint32_t usageHint) const {
+	buffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, drawData, usageHint);
+}
+
+void IndirectDrawBuilder::uploadDrawData(BufferObject & buffer) const {
+	uploadDrawData(buffer, BufferObject::USAGE_STREAM_DRAW);
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_INDIRECTDRAWBUILDER_H_
+#define RENDERING_INDIRECTDRAWBUILDER_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+
+namespace Rendering {
+class BufferObject;
+
+//! Command of glMultiDrawElementsIndirect (same layout as in OpenGL).
+struct DrawElementsIndirectCommand {
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
+/**
+ * Per-draw data of an indirect draw (std430 layout).
+ * In the shader, the data is accessed by the draw id gl_DrawIDARB (ARB_shader_draw_parameters).
+ * Without the extension, the draw id can be read from an instanced vertex attribute (divisor 1) containing
+ * 0, 1, 2, ...: such an attribute is sourced at the command's baseInstance, which the builder sets to the draw id.
+ * \code
+ * struct sg_DrawData {
+ *   mat4 modelMatrix;
+ *   uint materialIndex;
+ * };
+ * layout(std430, binding = ...) readonly buffer sg_DrawDataBuffer { sg_DrawData sg_drawData[]; };
+ * \endcode
+ */
+struct IndirectDrawData {
+	//! Column major
+	float modelMatrix[16];
+	uint32_t materialIndex;
+	uint32_t padding[3];
+};
+
+/**
+ * CPU-side builder of the commands of RenderingContext::multiDrawIndirect() for meshes that are stored in a
+ * shared mesh (e.g. combined with MeshBuilder::merge()).
+ * Every draw gets an entry in the per-draw data, which can be uploaded into a shader storage buffer.
+ *
+ * Example:
+ * \code
+ * IndirectDrawBuilder builder;
+ * builder.addDraw(indexCountA, firstIndexA, baseVertexA, matrixA, materialA);
+ * builder.addDraw(indexCountB, firstIndexB, baseVertexB, matrixB, materialB);
+ * builder.uploadCommands(commandBuffer);
+ * builder.uploadDrawData(drawDataBuffer);
+ * drawDataBuffer.bind(BufferObject::TARGET_SHADER_STORAGE_BUFFER, binding);
+ * rc.multiDrawIndirect(sharedMesh, commandBuffer, builder.getDrawCount());
+ * \endcode
+ * @ingroup rendering_helper
+ */
+class IndirectDrawBuilder {
+	public:
+		//! Add a draw with an identity model matrix and material index 0; returns the draw id.
+		RENDERINGAPI uint32_t addDraw(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex = 0, uint32_t instanceCount = 1);
+		//! Add a draw with the given per-draw data; returns the draw id.
+		RENDERINGAPI uint32_t addDraw(uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex,
+										const Geometry::Matrix4x4 & modelMatrix, uint32_t materialIndex, uint32_t instanceCount = 1);
+
+		const std::vector<DrawElementsIndirectCommand> & getCommands() const	{	return commands;	}
+		const std::vector<IndirectDrawData> & getDrawData() const				{	return drawData;	}
+		uint32_t getDrawCount() const	{	return static_cast<uint32_t>(commands.size());	}
+
+		//! Upload the commands into the given buffer (BufferObject::TARGET_DRAW_INDIRECT_BUFFER).
+		RENDERINGAPI void uploadCommands(BufferObject & buffer, uint32_t usageHint) const;
+		RENDERINGAPI void uploadCommands(BufferObject & buffer) const;
+		//! Upload the per-draw data into the given buffer (BufferObject::TARGET_SHADER_STORAGE_BUFFER).
+		RENDERINGAPI void uploadDrawData(BufferObject & buffer, uint32_t usageHint) const;
+		RENDERINGAPI void uploadDrawData(BufferObject & buffer) const;
+
+		void reserve(uint32_t drawCount) {
+			commands.reserve(drawCount);
+			drawData.reserve(drawCount);
+		}
+		void clear() {
+			commands.clear();
+			drawData.clear();
+		}
+
+	private:
+		std::vector<DrawElementsIndirectCommand> commands;
+		std::vector<IndirectDrawData> drawData;
+};
+
+}
+
+#endif /* RENDERING_INDIRECTDRAWBUILDER_H_ */
@@ -0,0 +1,585 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ClusterLOD.h"
+#include "Meshlets.h"
+#include "internal/Parallel.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+namespace Rendering {
+namespace MeshUtils {
+using Geometry::Vec3;
+
+static const uint32_t CLUSTER_LOD_HEADER = 0x0d686c63; // = "clh\r"
+static const uint32_t CLUSTER_LOD_VERSION = 0x01;
+static const uint32_t HEADER_SIZE = 5 * sizeof(uint32_t);
+static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+static const uint32_t MAX_LEVELS = 32;
+//! A group is only replaced by its simplification if this fraction of the triangles (or less) remains.
+static const float MAX_REMAINING_TRIANGLES = 0.85f;
+
+// -----------------------------------------------------------------------------
+// bounds
+
+//! Bounding sphere of the vertices referenced by the given indices
+static void computeBoundingSphere(const std::vector<Vec3> & positions, const uint32_t * indices, size_t count, float sphere[4]) {
+	Vec3 min = positions[indices[0]], max = positions[indices[0]];
+	for(size_t i = 1; i < count; ++i) {
+		const Vec3 & p = positions[indices[i]];
+		min = Vec3(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
+		max = Vec3(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
+	}
+	const Vec3 center = (min + max) * 0.5f;
+	float radius = 0.0f;
+	for(size_t i = 0; i < count; ++i)
+		radius = std::max(radius, (positions[indices[i]] - center).length());
+	sphere[0] = center.x();
+	sphere[1] = center.y();
+	sphere[2] = center.z();
+	sphere[3] = radius;
+}
+
+//! Sphere enclosing all given spheres
+static void mergeSpheres(const std::vector<const float *> & spheres, float result[4]) {
+	Vec3 min(spheres.front()), max(spheres.front());
+	for(const float * s : spheres) {
+		min = Vec3(std::min(min.x(), s[0] - s[3]), std::min(min.y(), s[1] - s[3]), std::min(min.z(), s[2] - s[3]));
+		max = Vec3(std::max(max.x(), s[0] + s[3]), std::max(max.y(), s[1] + s[3]), std::max(max.z(), s[2] + s[3]));
+	}
+	const Vec3 center = (min + max) * 0.5f;
+	float radius = 0.0f;
+	for(const float * s : spheres)
+		radius = std::max(radius, (Vec3(s) - center).length() + s[3]);
+	result[0] = center.x();
+	result[1] = center.y();
+	result[2] = center.z();
+	result[3] = radius;
+}
+
+// -----------------------------------------------------------------------------
+// simplification
+
+//! Symmetric 4x4 error quadric (upper triangle)
+typedef std::array<double, 10> Quadric;
+
+static void addPlaneQuadric(Quadric & q, const Vec3 & n, double d) {
+	const double a = n.x(), b = n.y(), c = n.z();
+	q[0] += a * a; q[1] += a * b; q[2] += a * c; q[3] += a * d;
+	q[4] += b * b; q[5] += b * c; q[6] += b * d;
+	q[7] += c * c; q[8] += c * d;
+	q[9] += d * d;
+}
+
+static double evaluateQuadric(const Quadric & q, const Vec3 & p) {
+	const double x = p.x(), y = p.y(), z = p.z();
+	return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+			+ q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+			+ q[7] * z * z + 2.0 * q[8] * z
+			+ q[9];
+}
+
+/**
+ * Simplifies the given triangles (global vertex indices) to at most @p targetTriangleCount triangles by collapsing
+ * vertices onto neighboring vertices (no new vertices are created). Locked vertices and the vertices of open edges
+ * of the group are not moved. In each pass, the cheapest independent collapses are applied.
+ * @return the geometric error (square root of the maximal quadric error of a collapse)
+ */
+static float simplifyGroup(std::vector<uint32_t> & triangles, uint32_t targetTriangleCount,
+							const std::vector<Vec3> & positions, const std::vector<uint8_t> & lockedVertices) {
+	std::vector<uint32_t> vertices(triangles);
+	std::sort(vertices.begin(), vertices.end());
+	vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+	const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+	std::vector<uint32_t> tris(triangles.size());
+	for(size_t i = 0; i < triangles.size(); ++i)
+		tris[i] = static_cast<uint32_t>(std::lower_bound(vertices.begin(), vertices.end(), triangles[i]) - vertices.begin());
+	uint32_t triangleCount = static_cast<uint32_t>(tris.size() / 3);
+	const auto position = [&](uint32_t v) -> const Vec3 & { return positions[vertices[v]]; };
+
+	std::vector<uint8_t> locked(vertexCount);
+	for(uint32_t v = 0; v < vertexCount; ++v)
+		locked[v] = lockedVertices[vertices[v]];
+	{
+		// edges used by only one triangle of the group are on the border of the group (or of the mesh)
+		std::vector<uint64_t> edges(tris.size());
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				const uint64_t a = tris[t * 3 + i], b = tris[t * 3 + (i + 1) % 3];
+				edges[t * 3 + i] = a < b ? (a << 32) | b : (b << 32) | a;
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for(size_t i = 0; i < edges.size(); ) {
+			size_t j = i + 1;
+			while(j < edges.size() && edges[j] == edges[i])
+				++j;
+			if(j - i == 1) {
+				locked[static_cast<uint32_t>(edges[i] >> 32)] = 1;
+				locked[static_cast<uint32_t>(edges[i] & 0xffffffff)] = 1;
+			}
+			i = j;
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		const Vec3 & a = position(tris[t * 3]);
+		Vec3 n = (position(tris[t * 3 + 1]) - a).cross(position(tris[t * 3 + 2]) - a);
+		const float length = n.length();
+		if(length == 0.0f)
+			continue;
+		n /= length;
+		for(uint_fast8_t i = 0; i < 3; ++i)
+			addPlaneQuadric(quadrics[tris[t * 3 + i]], n, -n.dot(a));
+	}
+
+	struct Collapse {
+		double cost;
+		uint32_t from, to;
+		bool operator<(const Collapse & other) const { return cost < other.cost; }
+	};
+	double maxError = 0.0;
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> vertexTriangles;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	while(triangleCount > targetTriangleCount) {
+		// triangles of each vertex
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for(uint32_t i = 0; i < triangleCount * 3; ++i)
+			++triangleOffsets[tris[i] + 1];
+		for(uint32_t v = 0; v < vertexCount; ++v)
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		vertexTriangles.resize(triangleCount * 3);
+		{
+			std::vector<uint32_t> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+			for(uint32_t i = 0; i < triangleCount * 3; ++i)
+				vertexTriangles[cursor[tris[i]]++] = i / 3;
+		}
+
+		// all possible collapses ordered by their cost
+		collapses.clear();
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				const uint32_t a = tris[t * 3 + i], b = tris[t * 3 + (i + 1) % 3];
+				Quadric q = quadrics[a];
+				for(uint_fast8_t k = 0; k < 10; ++k)
+					q[k] += quadrics[b][k];
+				if(!locked[a])
+					collapses.push_back({evaluateQuadric(q, position(b)), a, b});
+				if(!locked[b])
+					collapses.push_back({evaluateQuadric(q, position(a)), b, a});
+			}
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		// apply independent collapses that do not flip triangles
+		for(uint32_t v = 0; v < vertexCount; ++v)
+			remap[v] = v;
+		std::fill(touched.begin(), touched.end(), 0);
+		uint32_t removed = 0;
+		for(const auto & collapse : collapses) {
+			if(triangleCount - removed <= targetTriangleCount)
+				break;
+			if(touched[collapse.from] || touched[collapse.to])
+				continue;
+			bool valid = true;
+			uint32_t degenerated = 0;
+			for(uint32_t i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1] && valid; ++i) {
+				const uint32_t * t = tris.data() + vertexTriangles[i] * 3;
+				if(t[0] == collapse.to || t[1] == collapse.to || t[2] == collapse.to) {
+					++degenerated;
+					continue;
+				}
+				const Vec3 & a = position(t[0]), & b = position(t[1]), & c = position(t[2]);
+				const Vec3 oldNormal = (b - a).cross(c - a);
+				const Vec3 & na = t[0] == collapse.from ? position(collapse.to) : a;
+				const Vec3 & nb = t[1] == collapse.from ? position(collapse.to) : b;
+				const Vec3 & nc = t[2] == collapse.from ? position(collapse.to) : c;
+				valid = (nb - na).cross(nc - na).dot(oldNormal) > 0.0f;
+			}
+			if(!valid)
+				continue;
+			remap[collapse.from] = collapse.to;
+			for(uint_fast8_t k = 0; k < 10; ++k)
+				quadrics[collapse.to][k] += quadrics[collapse.from][k];
+			maxError = std::max(maxError, collapse.cost);
+			for(uint32_t i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1]; ++i) {
+				for(uint_fast8_t k = 0; k < 3; ++k)
+					touched[tris[vertexTriangles[i] * 3 + k]] = 1;
+			}
+			removed += degenerated;
+		}
+		if(removed == 0)
+			break;
+
+		// remove the degenerated triangles
+		uint32_t write = 0;
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			const uint32_t a = remap[tris[t * 3]], b = remap[tris[t * 3 + 1]], c = remap[tris[t * 3 + 2]];
+			if(a != b && b != c && c != a) {
+				tris[write++] = a;
+				tris[write++] = b;
+				tris[write++] = c;
+			}
+		}
+		triangleCount = write / 3;
+		tris.resize(write);
+	}
+
+	triangles.resize(tris.size());
+	for(size_t i = 0; i < tris.size(); ++i)
+		triangles[i] = vertices[tris[i]];
+	return static_cast<float>(std::sqrt(std::max(0.0, maxError)));
+}
+
+//! Splits the triangles into spatially coherent parts with at most @p maxTriangles triangles (recursive median splits).
+static void splitTriangles(const std::vector<uint32_t> & triangles, const std::vector<Vec3> & positions, uint32_t maxTriangles,
+							std::vector<std::vector<uint32_t>> & parts) {
+	const uint32_t triangleCount = static_cast<uint32_t>(triangles.size() / 3);
+	std::vector<Vec3> centroids(triangleCount);
+	std::vector<uint32_t> order(triangleCount);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		centroids[t] = (positions[triangles[t * 3]] + positions[triangles[t * 3 + 1]] + positions[triangles[t * 3 + 2]]) / 3.0f;
+		order[t] = t;
+	}
+	std::vector<std::pair<uint32_t, uint32_t>> stack;
+	stack.emplace_back(0, triangleCount);
+	while(!stack.empty()) {
+		const uint32_t begin = stack.back().first;
+		const uint32_t end = stack.back().second;
+		stack.pop_back();
+		if(end - begin <= maxTriangles) {
+			parts.emplace_back();
+			for(uint32_t i = begin; i < end; ++i)
+				parts.back().insert(parts.back().end(), triangles.begin() + order[i] * 3, triangles.begin() + order[i] * 3 + 3);
+			continue;
+		}
+		Vec3 min = centroids[order[begin]], max = centroids[order[begin]];
+		for(uint32_t i = begin; i < end; ++i) {
+			const Vec3 & c = centroids[order[i]];
+			min = Vec3(std::min(min.x(), c.x()), std::min(min.y(), c.y()), std::min(min.z(), c.z()));
+			max = Vec3(std::max(max.x(), c.x()), std::max(max.y(), c.y()), std::max(max.z(), c.z()));
+		}
+		const Vec3 extent = max - min;
+		const uint_fast8_t axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+		const uint32_t middle = begin + (end - begin) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b) {
+			return centroids[a][axis] < centroids[b][axis];
+		});
+		stack.emplace_back(middle, end);
+		stack.emplace_back(begin, middle);
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+//! (static)
+ClusterLODHierarchy buildClusterLOD(Mesh * mesh, uint32_t maxTriangles, uint32_t groupSize) {
+	if(maxTriangles == 0 || groupSize < 2)
+		INVALID_ARGUMENT_EXCEPTION("buildClusterLOD: Invalid cluster or group size.");
+	ClusterLODHierarchy hierarchy;
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("buildClusterLOD: Mesh is not an indexed triangle mesh.");
+		return hierarchy;
+	}
+	static const uint32_t GRAIN_SIZE = 1 << 12;
+
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	std::vector<Vec3> positions(vertexCount);
+	{
+		auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+		Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+			for(uint32_t v = begin; v < end; ++v)
+				positions[v] = posAcc->getPosition(v);
+		});
+	}
+
+	const auto addCluster = [&](const uint32_t * indices, size_t indexCount, uint32_t level, const float lodBounds[4], float lodError) {
+		LODCluster cluster{};
+		computeBoundingSphere(positions, indices, indexCount, cluster.bounds);
+		std::copy(lodBounds ? lodBounds : cluster.bounds, (lodBounds ? lodBounds : cluster.bounds) + 4, cluster.lodBounds);
+		std::copy(cluster.lodBounds, cluster.lodBounds + 4, cluster.parentBounds);
+		cluster.lodError = lodError;
+		cluster.parentError = std::numeric_limits<float>::max();
+		cluster.indexOffset = static_cast<uint32_t>(hierarchy.indices.size());
+		cluster.triangleCount = static_cast<uint32_t>(indexCount / 3);
+		cluster.level = level;
+		hierarchy.indices.insert(hierarchy.indices.end(), indices, indices + indexCount);
+		hierarchy.clusters.push_back(cluster);
+		return static_cast<uint32_t>(hierarchy.clusters.size() - 1);
+	};
+
+	// level 0: the clusters of the original mesh
+	std::vector<uint32_t> current;
+	{
+		const MeshletData meshlets = buildMeshlets(mesh, 256, maxTriangles);
+		std::vector<uint32_t> indices;
+		for(const auto & meshlet : meshlets.meshlets) {
+			indices.clear();
+			for(uint32_t i = meshlet.triangleOffset * 3; i < (meshlet.triangleOffset + meshlet.triangleCount) * 3; ++i)
+				indices.push_back(meshlets.vertices[meshlet.vertexOffset + meshlets.triangles[i]]);
+			current.push_back(addCluster(indices.data(), indices.size(), 0, nullptr, 0.0f));
+		}
+	}
+
+	std::vector<uint32_t> vertexGroup(vertexCount);
+	std::vector<uint8_t> lockedVertices(vertexCount);
+	for(uint32_t level = 1; level < MAX_LEVELS && current.size() > 1; ++level) {
+		const uint32_t clusterCount = static_cast<uint32_t>(current.size());
+
+		// 1. adjacency of the clusters (number of shared vertices)
+		std::vector<std::pair<uint32_t, uint32_t>> vertexClusters; // (vertex, cluster)
+		for(uint32_t c = 0; c < clusterCount; ++c) {
+			const LODCluster & cluster = hierarchy.clusters[current[c]];
+			const size_t first = vertexClusters.size();
+			for(uint32_t i = cluster.indexOffset; i < cluster.indexOffset + cluster.triangleCount * 3; ++i)
+				vertexClusters.emplace_back(hierarchy.indices[i], c);
+			std::sort(vertexClusters.begin() + first, vertexClusters.end());
+			vertexClusters.erase(std::unique(vertexClusters.begin() + first, vertexClusters.end()), vertexClusters.end());
+		}
+		std::sort(vertexClusters.begin(), vertexClusters.end());
+		std::vector<std::vector<std::pair<uint32_t, uint32_t>>> neighbors(clusterCount); // (cluster, shared vertices)
+		for(size_t i = 0; i < vertexClusters.size(); ) {
+			size_t j = i + 1;
+			while(j < vertexClusters.size() && vertexClusters[j].first == vertexClusters[i].first)
+				++j;
+			for(size_t a = i; a < j; ++a) {
+				for(size_t b = i; b < j; ++b) {
+					if(a != b)
+						neighbors[vertexClusters[a].second].emplace_back(vertexClusters[b].second, 1);
+				}
+			}
+			i = j;
+		}
+		for(auto & list : neighbors) {
+			std::sort(list.begin(), list.end());
+			size_t write = 0;
+			for(size_t i = 0; i < list.size(); ++i) {
+				if(write > 0 && list[write - 1].first == list[i].first)
+					++list[write - 1].second;
+				else
+					list[write++] = list[i];
+			}
+			list.resize(write);
+		}
+
+		// 2. group neighboring clusters greedily (most shared vertices first)
+		std::vector<std::vector<uint32_t>> groups;
+		std::vector<uint32_t> groupOf(clusterCount, NONE);
+		for(uint32_t seed = 0; seed < clusterCount; ++seed) {
+			if(groupOf[seed] != NONE)
+				continue;
+			const uint32_t groupId = static_cast<uint32_t>(groups.size());
+			groups.emplace_back(1, seed);
+			groupOf[seed] = groupId;
+			while(groups.back().size() < groupSize) {
+				std::vector<std::pair<uint32_t, uint32_t>> shared;
+				for(const uint32_t member : groups.back()) {
+					for(const auto & neighbor : neighbors[member]) {
+						if(groupOf[neighbor.first] != NONE)
+							continue;
+						auto it = std::find_if(shared.begin(), shared.end(), [&](const std::pair<uint32_t, uint32_t> & s) { return s.first == neighbor.first; });
+						if(it == shared.end())
+							shared.push_back(neighbor);
+						else
+							it->second += neighbor.second;
+					}
+				}
+				if(shared.empty())
+					break;
+				const auto best = std::max_element(shared.begin(), shared.end(), [](const std::pair<uint32_t, uint32_t> & a, const std::pair<uint32_t, uint32_t> & b) {
+					return a.second < b.second;
+				});
+				groupOf[best->first] = groupId;
+				groups.back().push_back(best->first);
+			}
+		}
+
+		// 3. lock the vertices shared by different groups
+		std::fill(vertexGroup.begin(), vertexGroup.end(), NONE);
+		std::fill(lockedVertices.begin(), lockedVertices.end(), 0);
+		for(const auto & vertexCluster : vertexClusters) {
+			uint32_t & group = vertexGroup[vertexCluster.first];
+			if(group == NONE)
+				group = groupOf[vertexCluster.second];
+			else if(group != groupOf[vertexCluster.second])
+				lockedVertices[vertexCluster.first] = 1;
+		}
+
+		// 4. simplify the groups in parallel
+		struct GroupResult {
+			std::vector<std::vector<uint32_t>> clusters;
+			float bounds[4];
+			float error = 0.0f;
+			uint32_t level = 0;
+			bool simplified = false;
+		};
+		std::vector<GroupResult> results(groups.size());
+		Parallel::forEach(0, static_cast<uint32_t>(groups.size()), [&](uint32_t g) {
+			GroupResult & result = results[g];
+			std::vector<uint32_t> triangles;
+			std::vector<const float *> childBounds;
+			for(const uint32_t c : groups[g]) {
+				const LODCluster & cluster = hierarchy.clusters[current[c]];
+				triangles.insert(triangles.end(), hierarchy.indices.begin() + cluster.indexOffset,
+									hierarchy.indices.begin() + cluster.indexOffset + cluster.triangleCount * 3);
+				childBounds.push_back(cluster.lodBounds);
+				result.error = std::max(result.error, cluster.lodError);
+				result.level = std::max(result.level, cluster.level + 1);
+			}
+			const uint32_t triangleCount = static_cast<uint32_t>(triangles.size() / 3);
+			const float error = simplifyGroup(triangles, triangleCount / 2, positions, lockedVertices);
+			if(triangles.size() / 3 > triangleCount * MAX_REMAINING_TRIANGLES)
+				return;
+			// the error of a parent is never smaller than the error of its children
+			result.error = std::max(result.error, error);
+			mergeSpheres(childBounds, result.bounds);
+			if(!triangles.empty())
+				splitTriangles(triangles, positions, maxTriangles, result.clusters);
+			result.simplified = true;
+		});
+
+		// 5. add the new clusters; clusters of groups that could not be simplified are kept for the next level
+		std::vector<uint32_t> next;
+		bool simplified = false;
+		for(size_t g = 0; g < groups.size(); ++g) {
+			const GroupResult & result = results[g];
+			if(!result.simplified) {
+				for(const uint32_t c : groups[g])
+					next.push_back(current[c]);
+				continue;
+			}
+			simplified = true;
+			for(const uint32_t c : groups[g]) {
+				LODCluster & child = hierarchy.clusters[current[c]];
+				child.parentError = result.error;
+				std::copy(result.bounds, result.bounds + 4, child.parentBounds);
+			}
+			for(const auto & indices : result.clusters)
+				next.push_back(addCluster(indices.data(), indices.size(), result.level, result.bounds, result.error));
+		}
+		current.swap(next);
+		if(!simplified)
+			break;
+	}
+
+	for(const auto & cluster : hierarchy.clusters)
+		hierarchy.levelCount = std::max(hierarchy.levelCount, cluster.level + 1);
+	return hierarchy;
+}
+
+//! (static)
+std::vector<uint32_t> selectClusterLODCut(const ClusterLODHierarchy & hierarchy, const Geometry::Vec3 & cameraPosition,
+											float projectionScale, float maxPixelError) {
+	const auto projectError = [&](const float sphere[4], float error) {
+		if(error <= 0.0f)
+			return 0.0f;
+		if(error == std::numeric_limits<float>::max())
+			return error;
+		const float distance = (Vec3(sphere) - cameraPosition).length() - sphere[3];
+		// camera inside of the bounds: always refine
+		return distance > 0.0f ? error * projectionScale / distance : std::numeric_limits<float>::max();
+	};
+	const uint32_t clusterCount = static_cast<uint32_t>(hierarchy.clusters.size());
+	std::vector<uint8_t> selected(clusterCount);
+	Parallel::forRange(0, clusterCount, 1 << 10, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c = begin; c < end; ++c) {
+			const LODCluster & cluster = hierarchy.clusters[c];
+			selected[c] = projectError(cluster.lodBounds, cluster.lodError) <= maxPixelError
+							&& projectError(cluster.parentBounds, cluster.parentError) > maxPixelError;
+		}
+	});
+	std::vector<uint32_t> cut;
+	for(uint32_t c = 0; c < clusterCount; ++c) {
+		if(selected[c])
+			cut.push_back(c);
+	}
+	return cut;
+}
+
+//! (static)
+Mesh * createClusterLODMesh(Mesh * mesh, const ClusterLODHierarchy & hierarchy) {
+	const MeshVertexData & vertexData = mesh->openVertexData();
+	auto result = new Mesh(mesh->getVertexDescription(), vertexData.getVertexCount(), static_cast<uint32_t>(hierarchy.indices.size()));
+	result->setDataStrategy(mesh->getDataStrategy());
+	MeshVertexData & targetVertices = result->openVertexData();
+	std::copy(vertexData.data(), vertexData.data() + vertexData.dataSize(), targetVertices.data());
+	targetVertices.updateBoundingBox();
+	MeshIndexData & targetIndices = result->openIndexData();
+	std::copy(hierarchy.indices.begin(), hierarchy.indices.end(), targetIndices.data());
+	targetIndices.updateIndexRange();
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+
+//! (static)
+bool saveClusterLOD(const ClusterLODHierarchy & hierarchy, std::ostream & output) {
+	const uint32_t header[5] = {CLUSTER_LOD_HEADER, CLUSTER_LOD_VERSION, hierarchy.levelCount,
+								static_cast<uint32_t>(hierarchy.clusters.size()), static_cast<uint32_t>(hierarchy.indices.size())};
+	output.write(reinterpret_cast<const char *>(header), HEADER_SIZE);
+	output.write(reinterpret_cast<const char *>(hierarchy.clusters.data()), static_cast<std::streamsize>(hierarchy.clusters.size() * sizeof(LODCluster)));
+	output.write(reinterpret_cast<const char *>(hierarchy.indices.data()), static_cast<std::streamsize>(hierarchy.indices.size() * sizeof(uint32_t)));
+	return output.good();
+}
+
+//! (static)
+bool loadClusterLOD(ClusterLODHierarchy & hierarchy, std::istream & input, bool loadIndices) {
+	uint32_t header[5];
+	input.read(reinterpret_cast<char *>(header), HEADER_SIZE);
+	if(!input.good() || header[0] != CLUSTER_LOD_HEADER) {
+		WARN("loadClusterLOD: Wrong format.");
+		return false;
+	}
+	if(header[1] > CLUSTER_LOD_VERSION) {
+		WARN("loadClusterLOD: Can't read hierarchy, version too high.");
+		return false;
+	}
+	hierarchy.levelCount = header[2];
+	hierarchy.clusters.resize(header[3]);
+	input.read(reinterpret_cast<char *>(hierarchy.clusters.data()), static_cast<std::streamsize>(hierarchy.clusters.size() * sizeof(LODCluster)));
+	hierarchy.indices.clear();
+	if(loadIndices) {
+		hierarchy.indices.resize(header[4]);
+		input.read(reinterpret_cast<char *>(hierarchy.indices.data()), static_cast<std::streamsize>(hierarchy.indices.size() * sizeof(uint32_t)));
+	}
+	if(!input.good()) {
+		WARN("loadClusterLOD: Unexpected end of data.");
+		return false;
+	}
+	for(const auto & cluster : hierarchy.clusters) {
+		if(static_cast<uint64_t>(cluster.indexOffset) + cluster.triangleCount * 3ull > header[4]) {
+			WARN("loadClusterLOD: Invalid cluster.");
+			return false;
+		}
+	}
+	return true;
+}
+
+//! (static)
+uint64_t getClusterLODIndexOffset(const ClusterLODHierarchy & hierarchy, uint32_t cluster) {
+	return HEADER_SIZE + hierarchy.clusters.size() * sizeof(LODCluster) + static_cast<uint64_t>(hierarchy.clusters.at(cluster).indexOffset) * sizeof(uint32_t);
+}
+
+}
+}
@@ -0,0 +1,109 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_CLUSTERLOD_H_
+#define RENDERING_MESHUTILS_CLUSTERLOD_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * A cluster of a continuous level of detail hierarchy (see buildClusterLOD()).
+ * Spheres are stored as (center x, y, z, radius). The layout is a plain structure that can be written to
+ * files or uploaded into a shader storage buffer.
+ */
+struct LODCluster {
+	//! Bounding sphere of the triangles (e.g. for culling)
+	float bounds[4];
+	//! Bounds and object space error of the group simplification that created this cluster (error 0 for the original clusters)
+	float lodBounds[4];
+	float lodError;
+	//! Bounds and error of the group simplification this cluster was replaced by (error FLT_MAX for roots)
+	float parentError;
+	float parentBounds[4];
+	//! Range in ClusterLODHierarchy::indices
+	uint32_t indexOffset;
+	uint32_t triangleCount;
+	//! 0 for the clusters of the original mesh
+	uint32_t level;
+	uint32_t reserved;
+};
+
+/**
+ * Directed acyclic graph of clusters with decreasing detail.
+ * All clusters reference the vertices of the original mesh (the simplification only collapses vertices onto
+ * existing ones), so the vertex data of the mesh can be used for every level.
+ */
+struct ClusterLODHierarchy {
+	std::vector<LODCluster> clusters;
+	//! Triangle indices of all clusters (into the vertex data of the original mesh)
+	std::vector<uint32_t> indices;
+	uint32_t levelCount = 0;
+};
+
+/**
+ * Builds a continuous level of detail hierarchy (cluster DAG) for an indexed triangle mesh.
+ * The mesh is split into clusters (see buildMeshlets()). Then, level by level, neighboring clusters are grouped,
+ * each group is simplified to half of its triangles (with locked group borders to prevent cracks) and split
+ * into new clusters. The errors and bounds are propagated such that a parent is never more accurate than its children.
+ * The groups of a level are simplified in parallel.
+ *
+ * @param mesh Indexed triangle mesh
+ * @param maxTriangles Maximum number of triangles per cluster
+ * @param groupSize Number of clusters that are simplified together
+ * @return the hierarchy; the original mesh is not changed
+ */
+RENDERINGAPI ClusterLODHierarchy buildClusterLOD(Mesh * mesh, uint32_t maxTriangles = 124, uint32_t groupSize = 4);
+
+/**
+ * Selects a crack free cut through the hierarchy: a cluster is selected if its own error is small enough,
+ * but the error of its parent is not. The errors are projected onto the screen using the distance of the
+ * camera to the corresponding bounding sphere. The clusters are tested in parallel.
+ *
+ * @param cameraPosition Camera position in the coordinate system of the mesh
+ * @param projectionScale Scale from object space errors at distance one to pixels (viewportHeight / (2 * tan(fovY / 2)))
+ * @param maxPixelError Maximum allowed screen space error in pixels
+ * @return the indices of the selected clusters (in ascending order)
+ */
+RENDERINGAPI std::vector<uint32_t> selectClusterLODCut(const ClusterLODHierarchy & hierarchy, const Geometry::Vec3 & cameraPosition,
+														float projectionScale, float maxPixelError);
+
+//! Creates a mesh with the vertices of @p mesh and the indices of all clusters; each cluster can be drawn as index range.
+RENDERINGAPI Mesh * createClusterLODMesh(Mesh * mesh, const ClusterLODHierarchy & hierarchy);
+
+/**
+ * Binary little endian format:
+ *   char[4] "clh"+chr(13), uint32 version (0x01), uint32 levelCount, uint32 clusterCount, uint32 indexCount,
+ *   LODCluster[clusterCount], uint32[indexCount]
+ * The indices of a cluster start at getClusterLODIndexOffset() and can be streamed in on demand.
+ */
+RENDERINGAPI bool saveClusterLOD(const ClusterLODHierarchy & hierarchy, std::ostream & output);
+
+/**
+ * Loads a hierarchy written with saveClusterLOD().
+ * @param loadIndices If false, only the clusters are read and the indices are left empty (for streaming).
+ */
+RENDERINGAPI bool loadClusterLOD(ClusterLODHierarchy & hierarchy, std::istream & input, bool loadIndices = true);
+
+//! Byte offset of the indices of a cluster relative to the beginning of the data written by saveClusterLOD().
+RENDERINGAPI uint64_t getClusterLODIndexOffset(const ClusterLODHierarchy & hierarchy, uint32_t cluster);
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_CLUSTERLOD_H_ */
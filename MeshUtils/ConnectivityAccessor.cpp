@@ -8,6 +8,7 @@
  */
 
 #include "ConnectivityAccessor.h"
+#include "internal/Parallel.h"
 
 #include "../Mesh/Mesh.h"
 #include "../Mesh/MeshIndexData.h"
@@ -20,6 +21,8 @@
 #include <Geometry/Vec3.h>
 #include <Geometry/Triangle.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <set>
 
@@ -29,46 +32,152 @@ namespace Rendering {
 namespace MeshUtils {
 
 static const std::string unimplementedFormatMsg("Mesh is not a valid triangle mesh.");
+//! Number of elements processed by a single task during the parallel construction.
+static const uint32_t GRAIN_SIZE = 1 << 14;
 
 void ConnectivityAccessor::assertCornerRange(uint32_t cIndex) const {
-	if(cIndex >= indices.getIndexCount())
-		throw std::invalid_argument("Trying to access corner " + Util::StringUtils::toString(cIndex) + " of overall " + Util::StringUtils::toString(indices.getIndexCount()) + " corners.");
+	if(cIndex >= meshIndexCount)
+		throw std::invalid_argument("Trying to access corner " + Util::StringUtils::toString(cIndex) + " of overall " + Util::StringUtils::toString(meshIndexCount) + " corners.");
+	if(regionLimited && globalToLocalTriangle.count(cIndex/3) == 0)
+		throw std::invalid_argument("Trying to access corner " + Util::StringUtils::toString(cIndex) + " outside of the region.");
 }
 
 void ConnectivityAccessor::assertVertexRange(uint32_t vIndex) const {
-	if(vIndex >= vertexCorners.size())
-		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCorners.size()) + " vertices.");
+	if(!regionLimited && vIndex+1 >= vertexCornerOffsets.size())
+		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCornerOffsets.size()-1) + " vertices.");
+	if(regionLimited && globalToLocalVertex.count(vIndex) == 0)
+		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " outside of the region.");
 }
 
 void ConnectivityAccessor::assertTriangleRange(uint32_t tIndex) const {
-	if(tIndex*3 >= indices.getIndexCount())
-		throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(tIndex) + " of overall " + Util::StringUtils::toString(indices.getIndexCount()/3) + " triangles.");
+	if(tIndex*3 >= meshIndexCount)
+		throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(tIndex) + " of overall " + Util::StringUtils::toString(meshIndexCount/3) + " triangles.");
+	if(regionLimited && globalToLocalTriangle.count(tIndex) == 0)
+		throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(tIndex) + " outside of the region.");
 }
 
-ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh) : indices(mesh->openIndexData()),
+uint32_t ConnectivityAccessor::toLocalCorner(uint32_t cIndex) const {
+	if(!regionLimited)
+		return cIndex;
+	return globalToLocalTriangle.at(cIndex/3)*3 + cIndex%3;
+}
+
+uint32_t ConnectivityAccessor::toGlobalCorner(uint32_t localCorner) const {
+	if(!regionLimited || localCorner == INVALID)
+		return localCorner;
+	return regionTriangles[localCorner/3]*3 + localCorner%3;
+}
+
+uint32_t ConnectivityAccessor::toLocalVertex(uint32_t vIndex) const {
+	if(!regionLimited)
+		return vIndex;
+	return globalToLocalVertex.at(vIndex);
+}
+
+uint32_t ConnectivityAccessor::getLocalCornerVertex(uint32_t localCorner) const {
+	return regionLimited ? regionCornerVertices[localCorner] : (*indices)[localCorner];
+}
+
+//! (internal) Vertex index of a (global) corner.
+uint32_t ConnectivityAccessor::getIndex(uint32_t cIndex) const {
+	return regionLimited ? regionVertices[regionCornerVertices[toLocalCorner(cIndex)]] : (*indices)[cIndex];
+}
+
+ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh) : indices(&mesh->openIndexData()),
 		posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION)),
-		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)) {
-	vertexCorners.resize(mesh->getVertexCount(), INVALID);
-	triangleNextCorners.resize(indices.getIndexCount(), INVALID);
-
-
-	// TODO: do this lazy, on demand, and only partially.
-	for(uint32_t i=0; i<indices.getIndexCount(); ++i) {
-		uint32_t c = vertexCorners[indices[i]];
-		if(c == INVALID) {
-			vertexCorners[indices[i]] = i;
-			triangleNextCorners[i] = i;
-		} else {
-			uint32_t j = c;
-			uint32_t nvc = triangleNextCorners[j];
-			while(nvc != INVALID && nvc != c) {
-				j = nvc;
-				nvc = triangleNextCorners[j];
+		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)),
+		meshIndexCount(indices->getIndexCount()), regionLimited(false) {
+	nextVertexCorners.resize(meshIndexCount, INVALID);
+	buildCornerTables(mesh->getVertexCount());
+}
+
+ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh, const std::vector<uint32_t>& triangles) : indices(nullptr),
+		meshIndexCount(mesh->getIndexCount()), regionLimited(true) {
+	// the data of the mesh is only needed while copying the region
+	LocalMeshDataHolder holder(mesh);
+	const MeshIndexData& meshIndices = mesh->openIndexData();
+	auto positions = PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION);
+
+	const uint32_t triangleCount = meshIndexCount/3;
+	regionTriangles.reserve(triangles.size());
+	regionCornerVertices.reserve(triangles.size()*3);
+	globalToLocalTriangle.reserve(triangles.size());
+	globalToLocalVertex.reserve(triangles.size()*3);
+	for(uint32_t t : triangles) {
+		if(t >= triangleCount)
+			throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(t) + " of overall " + Util::StringUtils::toString(triangleCount) + " triangles.");
+		if(!globalToLocalTriangle.emplace(t, static_cast<uint32_t>(regionTriangles.size())).second)
+			continue; // duplicate
+		regionTriangles.push_back(t);
+		for(uint32_t i=0; i<3; ++i) {
+			const uint32_t v = meshIndices[t*3+i];
+			const auto entry = globalToLocalVertex.emplace(v, static_cast<uint32_t>(regionVertices.size()));
+			if(entry.second) {
+				regionVertices.push_back(v);
+				const Geometry::Vec3 pos = positions->getPosition(v);
+				regionPositions.insert(regionPositions.end(), {pos.getX(), pos.getY(), pos.getZ()});
 			}
-			triangleNextCorners[j] = i;
-			triangleNextCorners[i] = c;
+			regionCornerVertices.push_back(entry.first->second);
 		}
 	}
+	nextVertexCorners.resize(regionTriangles.size()*3, INVALID);
+	buildCornerTables(static_cast<uint32_t>(regionVertices.size()));
+}
+
+void ConnectivityAccessor::buildCornerTables(uint32_t localVertexCount) {
+	const uint32_t cornerCount = getCornerCount();
+
+	// counting sort of the corners by their vertex
+	std::unique_ptr<std::atomic<uint32_t>[]> counters(new std::atomic<uint32_t>[localVertexCount]);
+	for(uint32_t v=0; v<localVertexCount; ++v)
+		counters[v] = 0;
+	Parallel::forRange(0, cornerCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c=begin; c<end; ++c)
+			counters[getLocalCornerVertex(c)].fetch_add(1, std::memory_order_relaxed);
+	});
+	vertexCornerOffsets.resize(localVertexCount+1);
+	vertexCornerOffsets[0] = 0;
+	for(uint32_t v=0; v<localVertexCount; ++v) {
+		vertexCornerOffsets[v+1] = vertexCornerOffsets[v] + counters[v];
+		counters[v] = vertexCornerOffsets[v];
+	}
+	vertexCornerList.resize(cornerCount);
+	Parallel::forRange(0, cornerCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c=begin; c<end; ++c)
+			vertexCornerList[counters[getLocalCornerVertex(c)].fetch_add(1, std::memory_order_relaxed)] = c;
+	});
+
+	// sort the corners of each vertex (the scatter order is not deterministic) and link them cyclically
+	Parallel::forRange(0, localVertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t v=begin; v<end; ++v) {
+			const auto first = vertexCornerList.begin() + vertexCornerOffsets[v];
+			const auto last = vertexCornerList.begin() + vertexCornerOffsets[v+1];
+			std::sort(first, last);
+			for(auto it = first; it != last; ++it)
+				nextVertexCorners[*it] = (it+1 == last) ? *first : *(it+1);
+		}
+	});
+}
+
+void ConnectivityAccessor::buildOppositeCorners() const {
+	const uint32_t cornerCount = getCornerCount();
+	oppositeCorners.assign(cornerCount, INVALID);
+	Parallel::forRange(0, cornerCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t c=begin; c<end; ++c) {
+			const uint32_t t = (c/3)*3;
+			// the edge opposite to c goes from a to b; the adjacent triangle contains the edge from b to a.
+			const uint32_t a = getLocalCornerVertex(t+(c+1)%3);
+			const uint32_t b = getLocalCornerVertex(t+(c+2)%3);
+			for(uint32_t i=vertexCornerOffsets[b]; i<vertexCornerOffsets[b+1]; ++i) {
+				const uint32_t d = vertexCornerList[i];
+				const uint32_t dt = (d/3)*3;
+				if(dt != t && getLocalCornerVertex(dt+(d+1)%3) == a) {
+					oppositeCorners[c] = dt+(d+2)%3;
+					break;
+				}
+			}
+		}
+	});
 }
 
 //! (static)
@@ -80,28 +189,51 @@ Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh) {
 	}
 }
 
+//! (static)
+Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh, const std::vector<uint32_t>& triangles) {
+	if(mesh->isUsingIndexData() && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
+		return new ConnectivityAccessor(mesh, triangles);
+	} else {
+		throw std::invalid_argument(unimplementedFormatMsg + '\'');
+	}
+}
+
+bool ConnectivityAccessor::containsTriangle(uint32_t tIndex) const {
+	if(tIndex*3 >= meshIndexCount)
+		return false;
+	return !regionLimited || globalToLocalTriangle.count(tIndex) > 0;
+}
+
 Geometry::Vec3 ConnectivityAccessor::getVertex(uint32_t vIndex) const {
 	assertVertexRange(vIndex);
+	if(regionLimited) {
+		const uint32_t v = toLocalVertex(vIndex)*3;
+		return Geometry::Vec3(regionPositions[v], regionPositions[v+1], regionPositions[v+2]);
+	}
 	return posAcc->getPosition(vIndex);
 }
 
 TriangleAccessor::TriangleIndices_t ConnectivityAccessor::getTriangle(uint32_t tIndex) const {
 	assertTriangleRange(tIndex);
+	if(regionLimited)
+		return std::make_tuple(getIndex(tIndex*3), getIndex(tIndex*3+1), getIndex(tIndex*3+2));
 	return triAcc->getIndices(tIndex);
 }
 
 uint32_t ConnectivityAccessor::getCorner(uint32_t vIndex, uint32_t tIndex) const {
 	assertVertexRange(vIndex);
 	assertTriangleRange(tIndex);
-	uint32_t c = vertexCorners[vIndex];
-	while(c != INVALID && c/3 != tIndex)
-		c = triangleNextCorners[c];
-	return c;
+	for(uint32_t c=tIndex*3; c<tIndex*3+3; ++c) {
+		if(getIndex(c) == vIndex)
+			return c;
+	}
+	return INVALID;
 }
 
 uint32_t ConnectivityAccessor::getVertexCorner(uint32_t vIndex) const {
 	assertVertexRange(vIndex);
-	return vertexCorners[vIndex];
+	const uint32_t v = toLocalVertex(vIndex);
+	return vertexCornerOffsets[v] == vertexCornerOffsets[v+1] ? INVALID : toGlobalCorner(vertexCornerList[vertexCornerOffsets[v]]);
 }
 
 uint32_t ConnectivityAccessor::getTriangleCorner(uint32_t tIndex) const {
@@ -111,7 +243,7 @@ uint32_t ConnectivityAccessor::getTriangleCorner(uint32_t tIndex) const {
 
 uint32_t ConnectivityAccessor::getCornerVertex(uint32_t cIndex) const {
 	assertCornerRange(cIndex);
-	return indices[cIndex];
+	return getIndex(cIndex);
 }
 
 uint32_t ConnectivityAccessor::getCornerTriangle(uint32_t cIndex) const {
@@ -121,7 +253,7 @@ uint32_t ConnectivityAccessor::getCornerTriangle(uint32_t cIndex) const {
 
 uint32_t ConnectivityAccessor::getNextVertexCorner(uint32_t cIndex) const {
 	assertCornerRange(cIndex);
-	return triangleNextCorners[cIndex];
+	return toGlobalCorner(nextVertexCorners[toLocalCorner(cIndex)]);
 }
 
 uint32_t ConnectivityAccessor::getNextTriangleCorner(uint32_t cIndex) const {
@@ -130,15 +262,28 @@ uint32_t ConnectivityAccessor::getNextTriangleCorner(uint32_t cIndex) const {
 	return tIndex*3+((cIndex+1)%3);
 }
 
+uint32_t ConnectivityAccessor::getOppositeCorner(uint32_t cIndex) const {
+	assertCornerRange(cIndex);
+	std::call_once(oppositeCornersFlag, [this]() { buildOppositeCorners(); });
+	return toGlobalCorner(oppositeCorners[toLocalCorner(cIndex)]);
+}
+
+uint32_t ConnectivityAccessor::getEdgeAdjacentTriangle(uint32_t tIndex, uint8_t edge) const {
+	assertTriangleRange(tIndex);
+	if(edge > 2)
+		throw std::invalid_argument("Invalid triangle edge " + Util::StringUtils::toString(static_cast<uint32_t>(edge)) + ".");
+	// the edge (i, i+1) is opposite to corner i+2
+	const uint32_t c = getOppositeCorner(tIndex*3+(edge+2)%3);
+	return c == INVALID ? INVALID : c/3;
+}
+
 std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentTriangles(uint32_t vIndex) const {
+	assertVertexRange(vIndex);
+	const uint32_t v = toLocalVertex(vIndex);
 	std::vector<uint32_t> out;
-	uint32_t c = getVertexCorner(vIndex);
-	out.push_back(getCornerTriangle(c));
-	uint32_t nc = getNextVertexCorner(c);
-	while(nc != c && nc != INVALID) {
-		out.push_back(getCornerTriangle(nc));
-		nc = getNextVertexCorner(nc);
-	}
+	out.reserve(vertexCornerOffsets[v+1] - vertexCornerOffsets[v]);
+	for(uint32_t i=vertexCornerOffsets[v]; i<vertexCornerOffsets[v+1]; ++i)
+		out.push_back(toGlobalCorner(vertexCornerList[i])/3);
 	return out;
 }
 
@@ -157,45 +302,35 @@ std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentVertices(uint32_t v
 }
 
 std::vector<uint32_t> ConnectivityAccessor::getAdjacentTriangles(uint32_t tIndex) const {
-	auto triangle = getTriangle(tIndex);
+	assertTriangleRange(tIndex);
+	const uint32_t t = toLocalCorner(tIndex*3);
 	std::vector<uint32_t> out;
-	auto e1 = std::make_pair(std::get<0>(triangle), std::get<1>(triangle)); // edge a-b
-	auto e2 = std::make_pair(std::get<1>(triangle), std::get<2>(triangle)); // edge b-c
-	auto e3 = std::make_pair(std::get<2>(triangle), std::get<0>(triangle)); // edge c-a
-	for(auto e : {e1,e2,e3}) {
-		for(auto t : getVertexAdjacentTriangles(e.first)) {
-			uint32_t c = getTriangleCorner(t);
-			while(getCornerVertex(c) != e.first)
-				c = getNextTriangleCorner(c);
-			uint32_t pc = getNextTriangleCorner(getNextTriangleCorner(c)); // previous corner = 2 * next corner
-			if(e.second == getCornerVertex(pc))
-				out.push_back(t);
+	for(uint32_t i=0; i<3; ++i) { // edges a-b, b-c, c-a
+		const uint32_t a = getLocalCornerVertex(t+i);
+		const uint32_t b = getLocalCornerVertex(t+(i+1)%3);
+		// all triangles containing the edge b-a (more than one for non-manifold edges)
+		for(uint32_t j=vertexCornerOffsets[a]; j<vertexCornerOffsets[a+1]; ++j) {
+			const uint32_t c = vertexCornerList[j];
+			if(getLocalCornerVertex((c/3)*3+(c+2)%3) == b)
+				out.push_back(toGlobalCorner(c)/3);
 		}
 	}
 	return out;
 }
 
 bool ConnectivityAccessor::isBorderEdge(uint32_t vIndex1, uint32_t vIndex2) const {
-	// find an edge with vertex1 and vertex2
-	uint32_t c = getVertexCorner(vIndex1);
-	uint32_t ntc = getNextTriangleCorner(c);
-	uint32_t nvc = getNextVertexCorner(c);
-	while(getCornerVertex(ntc) != vIndex2 && nvc != c) {
-		ntc = getNextTriangleCorner(nvc);
-		nvc = getNextVertexCorner(nvc);
-	}
-	if(getCornerVertex(ntc) != vIndex2 )
-		return false; // not an edge
-
-	ntc = getNextTriangleCorner(getNextTriangleCorner(c));
-	nvc = getNextVertexCorner(c);
-	while(nvc != c) {
-		if(getCornerVertex(ntc) == vIndex2)
-			return false; // opposing edge found
-		ntc = getNextTriangleCorner(getNextTriangleCorner(nvc));
-		nvc = getNextVertexCorner(nvc);
+	assertVertexRange(vIndex1);
+	const uint32_t v = toLocalVertex(vIndex1);
+	bool isEdge = false;
+	for(uint32_t i=vertexCornerOffsets[v]; i<vertexCornerOffsets[v+1]; ++i) {
+		const uint32_t c = toGlobalCorner(vertexCornerList[i]);
+		const uint32_t nextCorner = getNextTriangleCorner(c);
+		if(getCornerVertex(nextCorner) == vIndex2)
+			isEdge = true; // edge vertex1->vertex2
+		if(getCornerVertex(getNextTriangleCorner(nextCorner)) == vIndex2)
+			return false; // opposing edge vertex2->vertex1 found (or not an edge)
 	}
-	return getCornerVertex(ntc) != vIndex2;
+	return isEdge;
 }
 
 bool ConnectivityAccessor::isBorderTriangle(uint32_t tIndex) const {
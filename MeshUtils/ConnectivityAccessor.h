@@ -19,6 +19,8 @@
 #include <tuple>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace Geometry {
 template<typename _T> class _Vec3;
@@ -59,29 +61,81 @@ namespace MeshUtils {
  * c1 - corner of t0 and next triangle corner of c0 (see getNextTriangleCorner)
  * c2 - corner of v1 and next vertex corner of c0 (see getNextVertexCorner)
  * @endverbatim
+ *
+ * The corners of each vertex are stored in compressed sparse row format (built with a parallel
+ * counting sort over the vertex indices), so creating the accessor takes linear time.
+ * The opposite corner table used for edge adjacency queries is built lazily on first use.
+ * For editing tools, the accessor can be limited to a region of triangles of the mesh
+ * (see create(Mesh*, const std::vector<uint32_t>&)); then, only the given triangles and their
+ * vertices are considered, and only their indices and positions are copied into the accessor.
+ * Invalid corner or triangle results are returned as std::numeric_limits<uint32_t>::max().
  * @ingroup mesh_accessor
  */
 class ConnectivityAccessor : public Util::ReferenceCounter<ConnectivityAccessor> {
 private:
-	MeshIndexData& indices;
+	//! Data of the whole mesh (only used if not region limited).
+	MeshIndexData* indices;
 	Util::Reference<PositionAttributeAccessor> posAcc;
 	Util::Reference<TriangleAccessor> triAcc;
 	std::unique_ptr<LocalMeshDataHolder> meshDataHolder;
-	std::vector<uint32_t> vertexCorners;
-	std::vector<uint32_t> triangleNextCorners;
+	uint32_t meshIndexCount;
+
+	const bool regionLimited;
+	//! Global triangle index of each local triangle (only used if region limited).
+	std::vector<uint32_t> regionTriangles;
+	//! Copied data of the region: local vertex of each local corner, global index and position (x,y,z) of each local vertex.
+	std::vector<uint32_t> regionCornerVertices;
+	std::vector<uint32_t> regionVertices;
+	std::vector<float> regionPositions;
+	//! Local index of each global triangle/vertex (only used if region limited).
+	std::unordered_map<uint32_t,uint32_t> globalToLocalTriangle;
+	std::unordered_map<uint32_t,uint32_t> globalToLocalVertex;
+
+	//! Local corners of each local vertex (CSR): vertexCornerList[vertexCornerOffsets[v] ... vertexCornerOffsets[v+1]-1]
+	std::vector<uint32_t> vertexCornerOffsets;
+	std::vector<uint32_t> vertexCornerList;
+	//! Next corner of the same vertex for each local corner (cyclic).
+	std::vector<uint32_t> nextVertexCorners;
+	//! Opposite corner for each local corner (built on demand).
+	mutable std::vector<uint32_t> oppositeCorners;
+	mutable std::once_flag oppositeCornersFlag;
+
+	uint32_t getCornerCount() const {	return regionLimited ? static_cast<uint32_t>(regionTriangles.size()*3) : static_cast<uint32_t>(nextVertexCorners.size());	}
+	uint32_t toLocalCorner(uint32_t cIndex) const;
+	uint32_t toGlobalCorner(uint32_t localCorner) const;
+	uint32_t toLocalVertex(uint32_t vIndex) const;
+	uint32_t getLocalCornerVertex(uint32_t localCorner) const;
+	uint32_t getIndex(uint32_t cIndex) const;
+	void buildCornerTables(uint32_t localVertexCount);
+	void buildOppositeCorners() const;
 protected:
 	RENDERINGAPI void assertCornerRange(uint32_t cIndex) const;
 	RENDERINGAPI void assertVertexRange(uint32_t vIndex) const;
 	RENDERINGAPI void assertTriangleRange(uint32_t tIndex) const;
 	RENDERINGAPI ConnectivityAccessor(Mesh* mesh);
+	RENDERINGAPI ConnectivityAccessor(Mesh* mesh, const std::vector<uint32_t>& triangles);
 public:
 	/*! (static factory)
 		Create a ConnectivityAccessor for the given Mesh.
 		If no Accessor can be created, an std::invalid_argument exception is thrown. */
 	RENDERINGAPI static Util::Reference<ConnectivityAccessor> create(Mesh* mesh);
 
+	/*! (static factory)
+		Create a ConnectivityAccessor that only considers the given triangles of the Mesh.
+		The indices and positions of the region are copied, so the construction time and memory only depend
+		on the number of given triangles (if the mesh data is not in local memory, it is downloaded temporarily).
+		Accessing a triangle or vertex outside of the region throws an std::invalid_argument exception.
+		If no Accessor can be created, an std::invalid_argument exception is thrown. */
+	RENDERINGAPI static Util::Reference<ConnectivityAccessor> create(Mesh* mesh, const std::vector<uint32_t>& triangles);
+
 	virtual ~ConnectivityAccessor() {}
 
+	//! Return true, if the accessor only considers a region of triangles of the mesh.
+	bool isRegionLimited() const {	return regionLimited;	}
+
+	//! Return true, if the triangle is part of the region (always true for valid triangles if not region limited).
+	RENDERINGAPI bool containsTriangle(uint32_t tIndex) const;
+
 	/**
 	 * Return the coordinates of a vertex.
 	 * @param vIndex the vertex index
@@ -146,6 +200,22 @@ public:
 	 */
 	RENDERINGAPI uint32_t getNextTriangleCorner(uint32_t cIndex) const;
 
+	/**
+	 * Return the corner opposite to a corner, i.e., the corner of the adjacent triangle that does not lie on
+	 * the edge opposite to the given corner. The edges have to be oriented in opposite directions.
+	 * @param cIndex the corner index
+	 * @return the opposite corner index, or std::numeric_limits<uint32_t>::max() if the edge is a border edge.
+	 */
+	RENDERINGAPI uint32_t getOppositeCorner(uint32_t cIndex) const;
+
+	/**
+	 * Return the triangle sharing an edge with a triangle.
+	 * @param tIndex the triangle index
+	 * @param edge the edge of the triangle (0: a-b, 1: b-c, 2: c-a)
+	 * @return the adjacent triangle index, or std::numeric_limits<uint32_t>::max() if the edge is a border edge.
+	 */
+	RENDERINGAPI uint32_t getEdgeAdjacentTriangle(uint32_t tIndex, uint8_t edge) const;
+
 	/**
 	 * Return the triangles that are adjacent to a vertex.
 	 * @param vIndex the vertex index
@@ -163,6 +233,7 @@ public:
 	/**
 	 * Return the triangles that share an edge with a triangle.
 	 * Triangles are only adjacent, if the directions of the shared edge are opposite to each other.
+	 * For non-manifold edges, all triangles containing the opposite edge are returned.
 	 * @param tIndex the triangle index
 	 * @return list of adjacent triangle indices
 	 */
@@ -0,0 +1,304 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GeoMipMapTerrain.h"
+#include "internal/Parallel.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAccessor.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <Util/Graphics/PixelAccessor.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace Rendering {
+namespace MeshUtils {
+using Geometry::Vec3;
+
+//! Triangles of one level and stitch mask with local vertex indices.
+static void buildLevelIndices(uint32_t patchSize, uint32_t level, uint8_t stitchMask, std::vector<uint32_t> & indices) {
+	const uint32_t stride = 1u << level;
+	const uint32_t n = patchSize / stride;
+	const uint32_t rowSize = patchSize + 1;
+	// Odd vertices on stitched sides are moved onto the preceding even vertex.
+	const auto getIndex = [&](uint32_t i, uint32_t j) {
+		if(((j == 0 && (stitchMask & TERRAIN_STITCH_NORTH)) || (j == n && (stitchMask & TERRAIN_STITCH_SOUTH))) && (i & 1))
+			--i;
+		else if(((i == 0 && (stitchMask & TERRAIN_STITCH_WEST)) || (i == n && (stitchMask & TERRAIN_STITCH_EAST))) && (j & 1))
+			--j;
+		return j * stride * rowSize + i * stride;
+	};
+	const auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+		if(a != b && b != c && a != c) {
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+	};
+	for(uint32_t j = 0; j < n; ++j) {
+		for(uint32_t i = 0; i < n; ++i) {
+			// split along the diagonal (i, j) - (i + 1, j + 1)
+			const uint32_t i00 = getIndex(i, j);
+			const uint32_t i10 = getIndex(i + 1, j);
+			const uint32_t i11 = getIndex(i + 1, j + 1);
+			const uint32_t i01 = getIndex(i, j + 1);
+			addTriangle(i00, i10, i11);
+			addTriangle(i00, i11, i01);
+		}
+	}
+}
+
+//! (static)
+GeoMipMapTerrain buildGeoMipMapTerrain(const VertexDescription & vd,
+										Util::WeakPointer<Util::PixelAccessor> heightReader,
+										Util::WeakPointer<Util::PixelAccessor> colorReader,
+										Util::WeakPointer<Util::PixelAccessor> normalReader,
+										uint32_t patchSize) {
+	if(patchSize < 2 || patchSize > 128 || (patchSize & (patchSize - 1)) != 0)
+		INVALID_ARGUMENT_EXCEPTION("buildGeoMipMapTerrain: The patch size has to be a power of two in [2, 128].");
+	GeoMipMapTerrain terrain;
+	if(heightReader.isNull()) {
+		WARN("buildGeoMipMapTerrain: No height reader given.");
+		return terrain;
+	}
+	const uint32_t pixelWidth = heightReader->getWidth();
+	const uint32_t pixelHeight = heightReader->getHeight();
+	if(pixelWidth < 2 || pixelHeight < 2) {
+		WARN("buildGeoMipMapTerrain: The height map is too small.");
+		return terrain;
+	}
+	const uint32_t width = pixelWidth - 1;
+	const uint32_t height = pixelHeight - 1;
+
+	terrain.patchSize = patchSize;
+	terrain.levelCount = 1;
+	while((1u << terrain.levelCount) <= patchSize)
+		++terrain.levelCount;
+	terrain.patchCountX = (width + patchSize - 1) / patchSize;
+	terrain.patchCountY = (height + patchSize - 1) / patchSize;
+	const uint32_t patchCount = terrain.patchCountX * terrain.patchCountY;
+	const uint32_t rowSize = patchSize + 1;
+	const uint32_t verticesPerPatch = terrain.getVerticesPerPatch();
+
+	// shared index sets
+	terrain.indexRanges.resize(terrain.levelCount * 16);
+	for(uint32_t level = 0; level < terrain.levelCount; ++level) {
+		for(uint8_t mask = 0; mask < 16; ++mask) {
+			auto & range = terrain.indexRanges[level * 16 + mask];
+			range.offset = static_cast<uint32_t>(terrain.indices.size());
+			buildLevelIndices(patchSize, level, mask, terrain.indices);
+			range.count = static_cast<uint32_t>(terrain.indices.size()) - range.offset;
+		}
+	}
+
+	terrain.patches.resize(patchCount);
+	terrain.mesh = new Mesh(vd, patchCount * verticesPerPatch, 0);
+	MeshVertexData & vertexData = terrain.mesh->openVertexData();
+	const VertexDescription & description = vertexData.getVertexDescription();
+	const bool hasColor = description.hasAttribute(VertexAttributeIds::COLOR);
+	const bool hasNormal = description.hasAttribute(VertexAttributeIds::NORMAL);
+	const bool hasTexCoord = description.hasAttribute(VertexAttributeIds::TEXCOORD0);
+	auto accessor = VertexAccessor::create(vertexData);
+
+	// same mapping as QuadtreeMeshBuilder
+	const float xScale = 2.0f / static_cast<float>(width);
+	const float yScale = 2.0f / static_cast<float>(height);
+	const float uScale = 1.0f / static_cast<float>(width);
+	const float vScale = 1.0f / static_cast<float>(height);
+	// vertices outside of the height map are clamped to its border (degenerated triangles)
+	const auto getHeight = [&](uint32_t x, uint32_t y) {
+		return 2.0f * heightReader->readSingleValueFloat(std::min(x, width), std::min(y, height)) - 1.0f;
+	};
+
+	Parallel::forEach(0, patchCount, [&](uint32_t p) {
+		auto & patch = terrain.patches[p];
+		patch.x = p % terrain.patchCountX;
+		patch.y = p / terrain.patchCountX;
+		patch.firstVertex = p * verticesPerPatch;
+		const uint32_t originX = patch.x * patchSize;
+		const uint32_t originY = patch.y * patchSize;
+
+		// local height grid of the patch
+		std::vector<float> heights(verticesPerPatch);
+		for(uint32_t ly = 0; ly <= patchSize; ++ly) {
+			for(uint32_t lx = 0; lx <= patchSize; ++lx)
+				heights[ly * rowSize + lx] = getHeight(originX + lx, originY + ly);
+		}
+
+		float minZ = std::numeric_limits<float>::max();
+		float maxZ = std::numeric_limits<float>::lowest();
+		for(uint32_t ly = 0; ly <= patchSize; ++ly) {
+			const uint32_t y = std::min(originY + ly, height);
+			for(uint32_t lx = 0; lx <= patchSize; ++lx) {
+				const uint32_t x = std::min(originX + lx, width);
+				const uint32_t index = patch.firstVertex + ly * rowSize + lx;
+				const float z = heights[ly * rowSize + lx];
+				minZ = std::min(minZ, z);
+				maxZ = std::max(maxZ, z);
+				accessor->setPosition(index, Vec3(xScale * x - 1.0f, yScale * y - 1.0f, z));
+
+				if(hasColor) {
+					accessor->setColor(index, colorReader.isNotNull() ? colorReader->readColor4f(x, y) : Util::Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+				}
+				if(hasNormal) {
+					if(normalReader.isNotNull()) {
+						const Util::Color4ub normalColor = normalReader->readColor4ub(x, y);
+						const Geometry::Vec3b normal(normalColor.getR() - 128, normalColor.getG() - 128, normalColor.getB() - 128);
+						accessor->setNormal(index, Vec3(normal));
+					} else {
+						// central differences of the height map
+						const uint32_t x0 = x > 0 ? x - 1 : x;
+						const uint32_t x1 = std::min(x + 1, width);
+						const uint32_t y0 = y > 0 ? y - 1 : y;
+						const uint32_t y1 = std::min(y + 1, height);
+						const float dzdx = (getHeight(x1, y) - getHeight(x0, y)) / (static_cast<float>(x1 - x0) * xScale);
+						const float dzdy = (getHeight(x, y1) - getHeight(x, y0)) / (static_cast<float>(y1 - y0) * yScale);
+						accessor->setNormal(index, Vec3(-dzdx, -dzdy, 1.0f).normalize());
+					}
+				}
+				if(hasTexCoord) {
+					accessor->setTexCoord(index, Geometry::Vec2(x * uScale, y * vScale));
+				}
+			}
+		}
+		const uint32_t maxX = std::min(originX + patchSize, width);
+		const uint32_t maxY = std::min(originY + patchSize, height);
+		patch.bounds[0] = xScale * originX - 1.0f;
+		patch.bounds[1] = yScale * originY - 1.0f;
+		patch.bounds[2] = minZ;
+		patch.bounds[3] = xScale * maxX - 1.0f;
+		patch.bounds[4] = yScale * maxY - 1.0f;
+		patch.bounds[5] = maxZ;
+
+		// Error of each level: largest height difference between a vertex and the triangle of the level covering it.
+		patch.errors.assign(terrain.levelCount, 0.0f);
+		for(uint32_t level = 1; level < terrain.levelCount; ++level) {
+			const uint32_t stride = 1u << level;
+			float error = patch.errors[level - 1];
+			for(uint32_t ly = 0; ly <= patchSize; ++ly) {
+				const uint32_t cy = std::min(ly / stride * stride, patchSize - stride);
+				const float fy = static_cast<float>(ly - cy) / stride;
+				for(uint32_t lx = 0; lx <= patchSize; ++lx) {
+					const uint32_t cx = std::min(lx / stride * stride, patchSize - stride);
+					const float fx = static_cast<float>(lx - cx) / stride;
+					const float h00 = heights[cy * rowSize + cx];
+					const float h10 = heights[cy * rowSize + cx + stride];
+					const float h01 = heights[(cy + stride) * rowSize + cx];
+					const float h11 = heights[(cy + stride) * rowSize + cx + stride];
+					const float interpolated = fx >= fy ? h00 + fx * (h10 - h00) + fy * (h11 - h10)
+														: h00 + fy * (h01 - h00) + fx * (h11 - h01);
+					error = std::max(error, std::abs(interpolated - heights[ly * rowSize + lx]));
+				}
+			}
+			patch.errors[level] = error;
+		}
+	});
+	accessor = nullptr;
+	vertexData.markAsChanged();
+	vertexData.updateBoundingBox();
+	return terrain;
+}
+
+//! (static)
+std::vector<uint8_t> selectGeoMipMapLevels(const GeoMipMapTerrain & terrain, const Vec3 & cameraPosition,
+											float projectionScale, float maxPixelError) {
+	std::vector<uint8_t> levels(terrain.patches.size(), 0);
+	Parallel::forEach(0, static_cast<uint32_t>(terrain.patches.size()), [&](uint32_t p) {
+		const auto & patch = terrain.patches[p];
+		float distanceSquared = 0.0f;
+		for(uint_fast8_t a = 0; a < 3; ++a) {
+			const float d = std::max(std::max(patch.bounds[a] - cameraPosition[a], cameraPosition[a] - patch.bounds[a + 3]), 0.0f);
+			distanceSquared += d * d;
+		}
+		const float distance = std::max(std::sqrt(distanceSquared), std::numeric_limits<float>::epsilon());
+		uint8_t level = 0;
+		while(level + 1u < terrain.levelCount && patch.errors[level + 1] * projectionScale / distance <= maxPixelError)
+			++level;
+		levels[p] = level;
+	});
+
+	// Neighbors may differ by one level only (required for the stitching); refining never violates this for other pairs.
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(uint32_t p = 0; p < levels.size(); ++p) {
+			const uint32_t x = p % terrain.patchCountX;
+			const uint32_t y = p / terrain.patchCountX;
+			uint8_t maxLevel = levels[p];
+			if(x > 0)
+				maxLevel = std::min<uint8_t>(maxLevel, levels[p - 1] + 1);
+			if(x + 1 < terrain.patchCountX)
+				maxLevel = std::min<uint8_t>(maxLevel, levels[p + 1] + 1);
+			if(y > 0)
+				maxLevel = std::min<uint8_t>(maxLevel, levels[p - terrain.patchCountX] + 1);
+			if(y + 1 < terrain.patchCountY)
+				maxLevel = std::min<uint8_t>(maxLevel, levels[p + terrain.patchCountX] + 1);
+			if(maxLevel != levels[p]) {
+				levels[p] = maxLevel;
+				changed = true;
+			}
+		}
+	}
+	return levels;
+}
+
+//! (static)
+uint8_t getGeoMipMapStitchMask(const GeoMipMapTerrain & terrain, const std::vector<uint8_t> & levels, uint32_t patch) {
+	const uint32_t x = patch % terrain.patchCountX;
+	const uint32_t y = patch / terrain.patchCountX;
+	const uint8_t level = levels[patch];
+	uint8_t mask = 0;
+	if(x > 0 && levels[patch - 1] > level)
+		mask |= TERRAIN_STITCH_WEST;
+	if(y > 0 && levels[patch - terrain.patchCountX] > level)
+		mask |= TERRAIN_STITCH_NORTH;
+	if(x + 1 < terrain.patchCountX && levels[patch + 1] > level)
+		mask |= TERRAIN_STITCH_EAST;
+	if(y + 1 < terrain.patchCountY && levels[patch + terrain.patchCountX] > level)
+		mask |= TERRAIN_STITCH_SOUTH;
+	return mask;
+}
+
+//! (static)
+void updateGeoMipMapIndices(GeoMipMapTerrain & terrain, const std::vector<uint8_t> & levels) {
+	if(terrain.mesh.isNull())
+		return;
+	if(levels.size() != terrain.patches.size())
+		INVALID_ARGUMENT_EXCEPTION("updateGeoMipMapIndices: One level per patch required.");
+	const uint32_t patchCount = static_cast<uint32_t>(terrain.patches.size());
+	std::vector<uint8_t> masks(patchCount);
+	std::vector<uint32_t> offsets(patchCount + 1, 0);
+	for(uint32_t p = 0; p < patchCount; ++p) {
+		masks[p] = getGeoMipMapStitchMask(terrain, levels, p);
+		offsets[p + 1] = terrain.getIndexRange(levels[p], masks[p]).count;
+	}
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	MeshIndexData & indexData = terrain.mesh->openIndexData();
+	indexData.allocate(offsets.back());
+	uint32_t * target = indexData.data();
+	Parallel::forEach(0, patchCount, [&](uint32_t p) {
+		const auto & range = terrain.getIndexRange(levels[p], masks[p]);
+		const uint32_t firstVertex = terrain.patches[p].firstVertex;
+		const uint32_t * source = terrain.indices.data() + range.offset;
+		std::transform(source, source + range.count, target + offsets[p], [firstVertex](uint32_t index) { return index + firstVertex; });
+	});
+	indexData.updateIndexRange();
+	terrain.mesh->setUseIndexData(true);
+}
+
+}
+}
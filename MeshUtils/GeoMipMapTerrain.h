@@ -0,0 +1,123 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_GEOMIPMAPTERRAIN_H_
+#define RENDERING_MESHUTILS_GEOMIPMAPTERRAIN_H_
+
+#include <Util/References.h>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+namespace Util {
+class PixelAccessor;
+}
+
+namespace Rendering {
+class Mesh;
+class VertexDescription;
+namespace MeshUtils {
+
+/**
+ * Sides of a terrain patch whose neighbor uses the next coarser level (same bits as the side pattern of QuadtreeMeshBuilder).
+ * The odd vertices on these sides are skipped, so the patch matches the edge of its neighbor without cracks.
+ */
+enum TerrainStitchSide : uint8_t {
+	TERRAIN_STITCH_WEST = 0x01,
+	TERRAIN_STITCH_NORTH = 0x02,
+	TERRAIN_STITCH_EAST = 0x04,
+	TERRAIN_STITCH_SOUTH = 0x08
+};
+
+//! A square patch of a GeoMipMapTerrain.
+struct TerrainPatch {
+	//! Position in the patch grid
+	uint32_t x, y;
+	//! First vertex of the patch in the vertex data of the terrain mesh
+	uint32_t firstVertex;
+	//! Bounding box (minX, minY, minZ, maxX, maxY, maxZ)
+	float bounds[6];
+	//! Maximum height difference to the full resolution for every level (errors[0] == 0, not decreasing)
+	std::vector<float> errors;
+};
+
+//! Range in GeoMipMapTerrain::indices
+struct TerrainIndexRange {
+	uint32_t offset;
+	uint32_t count;
+};
+
+/**
+ * Heightmap terrain split into square patches of patchSize x patchSize quads (geomipmapping).
+ * All patches have the same local vertex layout ((patchSize + 1)^2 vertices, row by row) and are stored one after
+ * another in the vertex data of a single mesh. Level l of a patch uses every (2^l)-th vertex; the index sets of all
+ * levels and stitching variants are stored once with local vertex indices and are shared by all patches.
+ */
+struct GeoMipMapTerrain {
+	uint32_t patchSize = 0;
+	uint32_t levelCount = 0;
+	uint32_t patchCountX = 0;
+	uint32_t patchCountY = 0;
+	//! Patches row by row
+	std::vector<TerrainPatch> patches;
+	//! Vertices of all patches; the index data is filled by updateGeoMipMapIndices()
+	Util::Reference<Mesh> mesh;
+	//! Local triangle indices of all levels and stitching variants
+	std::vector<uint32_t> indices;
+	//! Index ranges for level * 16 + stitch mask
+	std::vector<TerrainIndexRange> indexRanges;
+
+	uint32_t getVerticesPerPatch() const { return (patchSize + 1) * (patchSize + 1); }
+	const TerrainIndexRange & getIndexRange(uint32_t level, uint8_t stitchMask) const { return indexRanges[level * 16 + (stitchMask & 0x0f)]; }
+};
+
+/**
+ * Creates a geomipmapped terrain from a height map.
+ * The vertices use the same mapping as QuadtreeMeshBuilder::createMesh(): x and y are scaled to [-1, 1], the
+ * height values (z) from [0, 1] to [-1, 1]. If no normal map is given, normals are calculated from the heights.
+ * The patches are created in parallel.
+ *
+ * @param vd Vertex description (position, optional normal, color and texture coordinates)
+ * @param heightReader Height values (single float value per pixel)
+ * @param colorReader (optional) Colors
+ * @param normalReader (optional) Normals
+ * @param patchSize Number of quads per patch side; power of two in [2, 128]
+ */
+RENDERINGAPI GeoMipMapTerrain buildGeoMipMapTerrain(const VertexDescription & vd,
+													Util::WeakPointer<Util::PixelAccessor> heightReader,
+													Util::WeakPointer<Util::PixelAccessor> colorReader,
+													Util::WeakPointer<Util::PixelAccessor> normalReader,
+													uint32_t patchSize = 32);
+
+/**
+ * Selects the coarsest level of each patch whose projected error is at most @p maxPixelError.
+ * Afterwards, levels are refined until neighboring patches differ by at most one level.
+ *
+ * @param cameraPosition Camera position in the coordinate system of the terrain
+ * @param projectionScale Scale from object space errors at distance one to pixels (viewportHeight / (2 * tan(fovY / 2)))
+ * @return the level of each patch
+ */
+RENDERINGAPI std::vector<uint8_t> selectGeoMipMapLevels(const GeoMipMapTerrain & terrain, const Geometry::Vec3 & cameraPosition,
+														float projectionScale, float maxPixelError);
+
+//! Returns the sides of the patch whose neighbors use a coarser level (see TerrainStitchSide).
+RENDERINGAPI uint8_t getGeoMipMapStitchMask(const GeoMipMapTerrain & terrain, const std::vector<uint8_t> & levels, uint32_t patch);
+
+/**
+ * Fills the index data of the terrain mesh with the triangles of all patches at the given levels
+ * (including stitching). The vertex data is not changed.
+ */
+RENDERINGAPI void updateGeoMipMapIndices(GeoMipMapTerrain & terrain, const std::vector<uint8_t> & levels);
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_GEOMIPMAPTERRAIN_H_ */
@@ -9,12 +9,14 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "MarchingCubesMeshBuilder.h"
-#include "MeshBuilder.h"
+#include "internal/Parallel.h"
+#include "../Mesh/Mesh.h"
 #include "../Mesh/VertexDescription.h"
-#include <Geometry/Vec4.h>
+#include <Geometry/Vec3.h>
 #include <Util/Graphics/Color.h>
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Macros.h>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -313,189 +315,415 @@ static const int8_t triTable[256][16] = {
 	{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
 };
 
-static Geometry::Vec4 interpolateVertices(float isolevel, const Geometry::Vec4 & p1, const Geometry::Vec4 & p2, const float density1, const float density2) {
-	Geometry::Vec4 result;
-	if(std::abs(isolevel - density1) < 0.00001){
-		result = p1;
-	}else if(std::abs(isolevel - density2) < 0.00001){
-		result = p2;
-	}else if(std::abs(density1 - density2) < 0.00001){
-		result = p1;
-	}else{
-		result = p1 + (p2-p1)*(isolevel - density1) / (density2 - density1);
+//! Cube edge -> (offset x, offset y, offset z, axis) of the grid edge, where axis 0,1,2 stands for x,y,z.
+static const uint8_t edgeGridOffsets[12][4] = {
+	{0,0,0,0}, {1,0,0,2}, {0,0,1,0}, {0,0,0,2},
+	{0,1,0,0}, {1,1,0,2}, {0,1,1,0}, {0,1,0,2},
+	{0,0,0,1}, {1,0,0,1}, {1,0,1,1}, {0,0,1,1}
+};
+
+static const uint32_t NO_VERTEX = 0xffffffff;
+//! Marks an index that references a vertex on the upper seam of the previous slab.
+static const uint32_t SEAM_FLAG = 0x80000000;
+
+struct SurfaceVertex {
+	Geometry::Vec3 position;
+	Geometry::Vec3 normal;
+	float occlusion;
+};
+
+//! Part of the volume (range of cell layers along the z-axis) that is processed by a single thread.
+struct Slab {
+	uint32_t zBegin, zEnd;
+	std::vector<SurfaceVertex> vertices;
+	std::vector<uint32_t> indices;
+	//! Vertex indices of the x- and y-edges in layer zEnd (used by the indices of the following slab).
+	std::vector<uint32_t> upperSeam;
+};
+
+//! Parameters of the extraction that are shared by all slabs.
+struct ExtractionParameters {
+	uint32_t resolutionX, resolutionY, resolutionZ;
+	uint32_t rangeMinX, rangeMaxX, rangeMinY, rangeMaxY, rangeMinZ, rangeMaxZ;
+	float isolevel;
+	bool generateNormals;
+	bool compactVertexFormat;
+
+	explicit ExtractionParameters(const MarchingCubesMeshBuilder::DataSet & data) :
+		resolutionX(data.resolutionX), resolutionY(data.resolutionY), resolutionZ(data.resolutionZ),
+		rangeMinX(data.rangeMinX), rangeMaxX(data.rangeMaxX), rangeMinY(data.rangeMinY),
+		rangeMaxY(data.rangeMaxY), rangeMinZ(data.rangeMinZ), rangeMaxZ(data.rangeMaxZ),
+		isolevel(data.isolevel), generateNormals(data.generateNormals), compactVertexFormat(data.compactVertexFormat) {
 	}
-	if(density1<isolevel){
-		result.w( p2.w() );
-	}else if(density2<isolevel){
-		result.w( p1.w() );
-	}else{
-		result.w( p1.w() );
-//		result.w( (p2.w()+p1.w())*0.5 );
+	ExtractionParameters(const MarchingCubesMeshBuilder::SparseVolume & volume, float _isolevel, bool _generateNormals, bool _compactVertexFormat) :
+		resolutionX(volume.getResolutionX()), resolutionY(volume.getResolutionY()), resolutionZ(volume.getResolutionZ()),
+		rangeMinX(0), rangeMaxX(volume.getResolutionX()), rangeMinY(0),
+		rangeMaxY(volume.getResolutionY()), rangeMinZ(0), rangeMaxZ(volume.getResolutionZ()),
+		isolevel(_isolevel), generateNormals(_generateNormals), compactVertexFormat(_compactVertexFormat) {
 	}
-	return result;
-}
+};
 
-//struct DataSet{
-//	uint32_t resolutionX,resolutionY,resolutionZ;
-//	std::vector<float> density; //! resolutionX*resolutionY*resolutionZ many values.
-//	float isolevel;
-//	uint32_t rangeMinX,rangeMaxX,rangeMinY,rangeMaxY,rangeMinZ,rangeMaxZ;
-//	std::vector<float> occlusion;
-//};
-//	
-//! (static)
-Mesh * MarchingCubesMeshBuilder::createMesh(DataSet & data) {
+//! Read access to a dense DataSet.
+struct DenseVolume {
+	const MarchingCubesMeshBuilder::DataSet & data;
+	explicit DenseVolume(const MarchingCubesMeshBuilder::DataSet & _data) : data(_data) {}
+	float getDensity(uint32_t x, uint32_t y, uint32_t z) const {
+		return data.density[z * data.layerXYSize + y * data.resolutionX + x];
+	}
+	float getOcclusion(uint32_t x, uint32_t y, uint32_t z) const {
+		return data.occlusion[z * data.layerXYSize + y * data.resolutionX + x];
+	}
+	//! Return the number of cells starting at the given cell along the x-axis that can not intersect the surface.
+	uint32_t getSkippableCells(uint32_t, uint32_t, uint32_t) const {
+		return 0;
+	}
+};
 
-	if(data.density.size() < data.resolutionX * data.resolutionY * data.resolutionZ )
-		INVALID_ARGUMENT_EXCEPTION("createMesh: Given data has invalid size.");
+//! Read access to a SparseVolume, which skips the cells of bricks that do not intersect the surface.
+class SparseVolumeView {
+	typedef MarchingCubesMeshBuilder::SparseVolume SparseVolume;
+	const SparseVolume & volume;
+	//! For each brick, whether the cells having their first corner inside of the brick may intersect the surface.
+	std::vector<uint8_t> activeBricks;
 
-//	if(data.occlusion.empty())
-//		data.occlusion = data.density;
+public:
+	SparseVolumeView(const SparseVolume & _volume, float isolevel) : volume(_volume),
+			activeBricks(volume.getBrickCountX() * volume.getBrickCountY() * volume.getBrickCountZ(), 0) {
+		const uint32_t countX = volume.getBrickCountX();
+		const uint32_t countY = volume.getBrickCountY();
+		const uint32_t countZ = volume.getBrickCountZ();
+		Parallel::forEach(0, countZ, [&](uint32_t bz) {
+			for(uint32_t by = 0; by < countY; ++by) {
+				for(uint32_t bx = 0; bx < countX; ++bx) {
+					// the cells of a brick also use the first grid points of the following bricks
+					float minDensity, maxDensity;
+					volume.getBrickBounds(bx, by, bz, minDensity, maxDensity);
+					for(uint32_t dz = bz; dz <= std::min(bz + 1, countZ - 1); ++dz) {
+						for(uint32_t dy = by; dy <= std::min(by + 1, countY - 1); ++dy) {
+							for(uint32_t dx = bx; dx <= std::min(bx + 1, countX - 1); ++dx) {
+								float brickMin, brickMax;
+								volume.getBrickBounds(dx, dy, dz, brickMin, brickMax);
+								minDensity = std::min(minDensity, brickMin);
+								maxDensity = std::max(maxDensity, brickMax);
+							}
+						}
+					}
+					// a cell is intersected if at least one corner is above and one is not above the isolevel
+					activeBricks[(bz * countY + by) * countX + bx] = (maxDensity > isolevel && minDensity <= isolevel) ? 1 : 0;
+				}
+			}
+		});
+	}
+	float getDensity(uint32_t x, uint32_t y, uint32_t z) const {
+		return volume.getDensity(x, y, z);
+	}
+	float getOcclusion(uint32_t x, uint32_t y, uint32_t z) const {
+		return volume.getOcclusion(x, y, z);
+	}
+	uint32_t getSkippableCells(uint32_t x, uint32_t y, uint32_t z) const {
+		const uint32_t brickSize = SparseVolume::BRICK_SIZE;
+		const uint32_t brickIndex = ((z / brickSize) * volume.getBrickCountY() + y / brickSize) * volume.getBrickCountX() + x / brickSize;
+		return activeBricks[brickIndex] ? 0 : brickSize - x % brickSize;
+	}
+};
 
-	VertexDescription vertexDescription;
-	vertexDescription.appendPosition3D();
-//	vertexDescription.appendNormalFloat();
-	vertexDescription.appendColorRGBAFloat();
-//	vertexDescription.appendTexCoord();
-	MeshBuilder mb(vertexDescription);
-
-	const float isolevel = data.isolevel;
-//	const uint32_t layerXYSize = data.layerXYSize;
-//	const uint8_t * ptr=data.data();
-//	const float uScale = 1.0f / sizeX;
-//	const float vScale = 1.0f / sizeY;
-
-	Geometry::Vec4 vertexList[12];
-
-	for(uint32_t z = data.rangeMinZ; z < data.rangeMaxZ - 1; ++z) {
-		for(uint32_t y = data.rangeMinY; y < data.rangeMaxY - 1; ++y) {
-			for(uint32_t x = data.rangeMinX; x < data.rangeMaxX - 1; ++x) {
-				const float * ptr = data.density.data() + z * data.layerXYSize + y * data.resolutionX + x;
-
-				const float density_xyz = *ptr ;
-				const float density_Xyz = *(ptr + 1) ;
-				const float density_XyZ = *(ptr + 1 + data.layerXYSize) ;
-				const float density_xyZ = *(ptr + data.layerXYSize) ;
-				const float density_xYz = *(ptr + data.resolutionX) ;
-				const float density_XYz = *(ptr + data.resolutionX + 1) ;
-				const float density_XYZ = *(ptr + data.resolutionX + 1 + data.layerXYSize) ;
-				const float density_xYZ = *(ptr + data.resolutionX + data.layerXYSize) ;
-
-				uint8_t cubeindex = 0;
-				if( density_xyz > isolevel)				cubeindex |= 1;
-				if( density_Xyz > isolevel)				cubeindex |= 2;
-				if( density_XyZ > isolevel)				cubeindex |= 4;
-				if( density_xyZ > isolevel)				cubeindex |= 8;
-				if( density_xYz > isolevel)				cubeindex |= 16;
-				if( density_XYz > isolevel)				cubeindex |= 32;
-				if( density_XYZ > isolevel)				cubeindex |= 64;
-				if( density_xYZ > isolevel)				cubeindex |= 128;
-
-				/* Cube is entirely in/out of the surface */
-				if(edgeTable[cubeindex] == 0)
-					continue;
-
-
-				// get occlusion values
-				const float * oPtr = data.occlusion.data() + z * data.layerXYSize + y * data.resolutionX + x;
-				const float o_xyz = *oPtr ;
-				const float o_Xyz = *(oPtr + 1) ;
-				const float o_XyZ = *(oPtr + 1 + data.layerXYSize) ;
-				const float o_xyZ = *(oPtr + data.layerXYSize) ;
-				const float o_xYz = *(oPtr + data.resolutionX) ;
-				const float o_XYz = *(oPtr + data.resolutionX + 1) ;
-				const float o_XYZ = *(oPtr + data.resolutionX + 1 + data.layerXYSize) ;
-				const float o_xYZ = *(oPtr + data.resolutionX + data.layerXYSize) ;
-
-				/* Find the vertices where the surface intersects the cube */
-				const float xf = static_cast<float>(x);
-				const float yf = static_cast<float>(y);
-				const float zf = static_cast<float>(z);
-				if(edgeTable[cubeindex] & 1)
-					vertexList[0] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf, zf, o_xyz),			Geometry::Vec4(xf+1, yf, zf, o_Xyz),		density_xyz, density_Xyz);
-				if(edgeTable[cubeindex] & 2)
-					vertexList[1] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1, yf, zf, o_Xyz),		Geometry::Vec4(xf+1, yf, zf+1, o_XyZ),		density_Xyz, density_XyZ);
-				if(edgeTable[cubeindex] & 4)
-					vertexList[2] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1, yf, zf+1, o_XyZ),		Geometry::Vec4(xf, yf, zf+1, o_xyZ),		density_XyZ, density_xyZ);
-				if(edgeTable[cubeindex] & 8)
-					vertexList[3] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf, zf+1, o_xyZ),		Geometry::Vec4(xf, yf, zf, o_xyz),			density_xyZ, density_xyz);
-				if(edgeTable[cubeindex] & 16)
-					vertexList[4] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf+1 , zf, o_xYz),		Geometry::Vec4(xf+1 , yf+1 , zf, o_XYz),	density_xYz, density_XYz);
-				if(edgeTable[cubeindex] & 32)
-					vertexList[5] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1 , yf+1 , zf, o_XYz),	Geometry::Vec4(xf+1 , yf+1 , zf+1, o_XYZ),	density_XYz, density_XYZ);
-				if(edgeTable[cubeindex] & 64)
-					vertexList[6] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1 , yf+1 , zf+1, o_XYZ),	Geometry::Vec4(xf, yf+1 , zf+1, o_xYZ),	density_XYZ, density_xYZ);
-				if(edgeTable[cubeindex] & 128)
-					vertexList[7] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf+1 , zf+1, o_xYZ),	Geometry::Vec4(xf, yf+1 , zf, o_xYz),		density_xYZ, density_xYz);
-				if(edgeTable[cubeindex] & 256)
-					vertexList[8] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf, zf, o_xyz),			Geometry::Vec4(xf, yf+1 , zf, o_xYz),		density_xyz, density_xYz);
-				if(edgeTable[cubeindex] & 512)
-					vertexList[9] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1, yf, zf, o_Xyz),		Geometry::Vec4(xf+1 , yf+1 , zf, o_XYz),	density_Xyz, density_XYz);
-				if(edgeTable[cubeindex] & 1024)
-					vertexList[10] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf+1, yf, zf+1, o_XyZ),		Geometry::Vec4(xf+1 , yf+1 , zf+1, o_XYZ),	density_XyZ, density_XYZ);
-				if(edgeTable[cubeindex] & 2048)
-					vertexList[11] = interpolateVertices(isolevel,
-								Geometry::Vec4(xf, yf, zf+1, o_xyZ),		Geometry::Vec4(xf, yf+1 , zf+1, o_xYZ),	density_xyZ, density_xYZ);
-
-				for (uint8_t i = 0; triTable[cubeindex][i] != -1; i += 3) {
-
-//					mb.texCoord0(Geometry::Vec2( x*uScale,y*vScale) );
-
-					for(int8_t j = 2; j >= 0; --j) {
-						const Geometry::Vec4 & v = vertexList[triTable[cubeindex][i+j]];
-						mb.color(Util::Color4f(v.w(),v.w(),v.w(),1.0));
-
-						mb.position( v.xyz() );
-						mb.addIndex(mb.addVertex());
+template<class Volume>
+class SlabExtractor {
+	const Volume & volume;
+	const ExtractionParameters & params;
+	const float isolevel;
+	const uint32_t width, height;
+	Slab & slab;
+	std::vector<uint32_t> lowerLayer; //!< x- and y-edges of the lower layer of the current cell layer
+	std::vector<uint32_t> upperLayer; //!< x- and y-edges of the upper layer of the current cell layer
+	std::vector<uint32_t> zEdges; //!< z-edges between both layers
 
+	Geometry::Vec3 getGradient(uint32_t x, uint32_t y, uint32_t z) const {
+		const uint32_t x0 = x > 0 ? x - 1 : x, x1 = std::min(x + 1, params.resolutionX - 1);
+		const uint32_t y0 = y > 0 ? y - 1 : y, y1 = std::min(y + 1, params.resolutionY - 1);
+		const uint32_t z0 = z > 0 ? z - 1 : z, z1 = std::min(z + 1, params.resolutionZ - 1);
+		return Geometry::Vec3(
+			(volume.getDensity(x1, y, z) - volume.getDensity(x0, y, z)) / static_cast<float>(std::max(1u, x1 - x0)),
+			(volume.getDensity(x, y1, z) - volume.getDensity(x, y0, z)) / static_cast<float>(std::max(1u, y1 - y0)),
+			(volume.getDensity(x, y, z1) - volume.getDensity(x, y, z0)) / static_cast<float>(std::max(1u, z1 - z0)));
+	}
+
+	uint32_t createVertex(uint32_t x, uint32_t y, uint32_t z, uint8_t axis) {
+		const uint32_t x2 = x + (axis == 0 ? 1 : 0);
+		const uint32_t y2 = y + (axis == 1 ? 1 : 0);
+		const uint32_t z2 = z + (axis == 2 ? 1 : 0);
+		const float density1 = volume.getDensity(x, y, z);
+		const float density2 = volume.getDensity(x2, y2, z2);
+
+		float t;
+		if(std::abs(isolevel - density1) < 0.00001) {
+			t = 0.0f;
+		} else if(std::abs(isolevel - density2) < 0.00001) {
+			t = 1.0f;
+		} else if(std::abs(density1 - density2) < 0.00001) {
+			t = 0.0f;
+		} else {
+			t = (isolevel - density1) / (density2 - density1);
+		}
+
+		SurfaceVertex vertex;
+		vertex.position = Geometry::Vec3(static_cast<float>(x) + (axis == 0 ? t : 0.0f),
+										static_cast<float>(y) + (axis == 1 ? t : 0.0f),
+										static_cast<float>(z) + (axis == 2 ? t : 0.0f));
+		// the occlusion is taken from the grid point inside of the surface
+		vertex.occlusion = density1 < isolevel ? volume.getOcclusion(x2, y2, z2) : volume.getOcclusion(x, y, z);
+		if(params.generateNormals) {
+			const Geometry::Vec3 gradient = getGradient(x, y, z) * (1.0f - t) + getGradient(x2, y2, z2) * t;
+			const float length = gradient.length();
+			vertex.normal = length > 0 ? gradient * (-1.0f / length) : gradient;
+		}
+		slab.vertices.emplace_back(vertex);
+		return static_cast<uint32_t>(slab.vertices.size() - 1);
+	}
+
+	uint32_t getVertex(uint32_t x, uint32_t y, uint32_t z, uint8_t edge) {
+		const uint8_t * offset = edgeGridOffsets[edge];
+		const uint32_t px = x + offset[0];
+		const uint32_t py = y + offset[1];
+		const uint32_t cellIndex = (py - params.rangeMinY) * width + (px - params.rangeMinX);
+		uint32_t & slot = offset[3] == 2 ? zEdges[cellIndex] : (offset[2] == 0 ? lowerLayer : upperLayer)[cellIndex * 2 + offset[3]];
+		if(slot == NO_VERTEX)
+			slot = createVertex(px, py, z + offset[2], offset[3]);
+		return slot;
+	}
+
+public:
+	SlabExtractor(const Volume & _volume, const ExtractionParameters & _params, Slab & _slab) :
+			volume(_volume), params(_params), isolevel(_params.isolevel),
+			width(_params.rangeMaxX - _params.rangeMinX), height(_params.rangeMaxY - _params.rangeMinY), slab(_slab),
+			lowerLayer(width * height * 2, NO_VERTEX), upperLayer(width * height * 2, NO_VERTEX), zEdges(width * height, NO_VERTEX) {
+		if(slab.zBegin > params.rangeMinZ) {
+			// the vertices of the lower layer are created by the previous slab
+			for(uint32_t i = 0; i < lowerLayer.size(); ++i)
+				lowerLayer[i] = SEAM_FLAG | i;
+		}
+	}
+
+	void extract() {
+		uint32_t vertexList[12];
+		for(uint32_t z = slab.zBegin; z < slab.zEnd; ++z) {
+			for(uint32_t y = params.rangeMinY; y < params.rangeMaxY - 1; ++y) {
+				for(uint32_t x = params.rangeMinX; x < params.rangeMaxX - 1; ++x) {
+					const uint32_t skippableCells = volume.getSkippableCells(x, y, z);
+					if(skippableCells > 0) {
+						x += skippableCells - 1;
+						continue;
 					}
+					uint8_t cubeindex = 0;
+					if( volume.getDensity(x, y, z) > isolevel)				cubeindex |= 1;
+					if( volume.getDensity(x+1, y, z) > isolevel)			cubeindex |= 2;
+					if( volume.getDensity(x+1, y, z+1) > isolevel)			cubeindex |= 4;
+					if( volume.getDensity(x, y, z+1) > isolevel)			cubeindex |= 8;
+					if( volume.getDensity(x, y+1, z) > isolevel)			cubeindex |= 16;
+					if( volume.getDensity(x+1, y+1, z) > isolevel)			cubeindex |= 32;
+					if( volume.getDensity(x+1, y+1, z+1) > isolevel)		cubeindex |= 64;
+					if( volume.getDensity(x, y+1, z+1) > isolevel)			cubeindex |= 128;
+
+					/* Cube is entirely in/out of the surface */
+					const int16_t edges = edgeTable[cubeindex];
+					if(edges == 0)
+						continue;
 
+					/* Find the vertices where the surface intersects the cube */
+					for(uint8_t e = 0; e < 12; ++e) {
+						if(edges & (1 << e))
+							vertexList[e] = getVertex(x, y, z, e);
+					}
+					for(uint8_t i = 0; triTable[cubeindex][i] != -1; i += 3) {
+						for(int8_t j = 2; j >= 0; --j)
+							slab.indices.push_back(vertexList[triTable[cubeindex][i+j]]);
+					}
 				}
-//					mb.texCoord0(Geometry::Vec2( x*uScale,y*vScale) );
-//					mb.position(Geometry::Vec3(static_cast<float>(x),static_cast<float>(y),static_cast<float>(z)));
-//					mb.addIndex(mb.addVertex());
-//				}
+			}
+			if(z + 1 < slab.zEnd) {
+				std::swap(lowerLayer, upperLayer);
+				std::fill(upperLayer.begin(), upperLayer.end(), NO_VERTEX);
+				std::fill(zEdges.begin(), zEdges.end(), NO_VERTEX);
 			}
 		}
+		slab.upperSeam.swap(upperLayer);
+	}
+};
+
+//! Extract the surface of the given volume in parallel and combine the slabs into a single mesh.
+template<class Volume>
+static Mesh * extractSurface(const Volume & volume, const ExtractionParameters & params) {
+	if(params.rangeMaxX > params.resolutionX || params.rangeMaxY > params.resolutionY || params.rangeMaxZ > params.resolutionZ)
+		INVALID_ARGUMENT_EXCEPTION("createMesh: Invalid range.");
+	if(params.rangeMaxX < params.rangeMinX + 2 || params.rangeMaxY < params.rangeMinY + 2 || params.rangeMaxZ < params.rangeMinZ + 2)
+		return nullptr;
+
+	// split the cell layers into slabs
+	const uint32_t numCellLayers = params.rangeMaxZ - params.rangeMinZ - 1;
+	const uint32_t numSlabs = std::min(numCellLayers, Parallel::getWorkerCount(numCellLayers) * 2);
+	std::vector<Slab> slabs(numSlabs);
+	for(uint32_t s = 0; s < numSlabs; ++s) {
+		slabs[s].zBegin = params.rangeMinZ + static_cast<uint32_t>(static_cast<uint64_t>(numCellLayers) * s / numSlabs);
+		slabs[s].zEnd = params.rangeMinZ + static_cast<uint32_t>(static_cast<uint64_t>(numCellLayers) * (s + 1) / numSlabs);
+	}
+
+	Parallel::forEach(0, numSlabs, [&](uint32_t s) {
+		SlabExtractor<Volume> extractor(volume, params, slabs[s]);
+		extractor.extract();
+	});
+
+	// compute the layout of the combined mesh
+	std::vector<uint32_t> vertexOffsets(numSlabs + 1, 0);
+	std::vector<uint32_t> indexOffsets(numSlabs + 1, 0);
+	for(uint32_t s = 0; s < numSlabs; ++s) {
+		vertexOffsets[s + 1] = vertexOffsets[s] + static_cast<uint32_t>(slabs[s].vertices.size());
+		indexOffsets[s + 1] = indexOffsets[s] + static_cast<uint32_t>(slabs[s].indices.size());
+	}
+	if(indexOffsets[numSlabs] == 0)
+		return nullptr;
+
+	VertexDescription vertexDescription;
+	vertexDescription.appendPosition3D();
+	if(params.compactVertexFormat) {
+		if(params.generateNormals)
+			vertexDescription.appendNormalByte();
+		vertexDescription.appendColorRGBAByte();
+	} else {
+		if(params.generateNormals)
+			vertexDescription.appendNormalFloat();
+		vertexDescription.appendColorRGBAFloat();
 	}
-	return mb.buildMesh();
 
+	auto mesh = new Mesh(vertexDescription, vertexOffsets[numSlabs], indexOffsets[numSlabs]);
+	MeshVertexData & vertices = mesh->openVertexData();
+	MeshIndexData & indices = mesh->openIndexData();
+	const size_t vertexSize = vertexDescription.getVertexSize();
+	const size_t posOffset = vertexDescription.getAttribute(VertexAttributeIds::POSITION).getOffset();
+	const size_t normalOffset = vertexDescription.getAttribute(VertexAttributeIds::NORMAL).getOffset();
+	const size_t colorOffset = vertexDescription.getAttribute(VertexAttributeIds::COLOR).getOffset();
+
+	// copy the vertices and resolve the seam references
+	Parallel::forEach(0, numSlabs, [&](uint32_t s) {
+		const Slab & slab = slabs[s];
+		uint8_t * vPtr = vertices.data() + vertexOffsets[s] * vertexSize;
+		for(const auto & v : slab.vertices) {
+			std::copy(v.position.getVec(), v.position.getVec() + 3, reinterpret_cast<float*>(vPtr + posOffset));
+			const float o = std::min(1.0f, std::max(0.0f, v.occlusion));
+			if(params.compactVertexFormat) {
+				if(params.generateNormals) {
+					int8_t * n = reinterpret_cast<int8_t*>(vPtr + normalOffset);
+					n[0] = static_cast<int8_t>(v.normal.x() * 127.0f);
+					n[1] = static_cast<int8_t>(v.normal.y() * 127.0f);
+					n[2] = static_cast<int8_t>(v.normal.z() * 127.0f);
+					n[3] = 0;
+				}
+				uint8_t * c = vPtr + colorOffset;
+				c[0] = c[1] = c[2] = static_cast<uint8_t>(o * 255.0f);
+				c[3] = 255;
+			} else {
+				if(params.generateNormals)
+					std::copy(v.normal.getVec(), v.normal.getVec() + 3, reinterpret_cast<float*>(vPtr + normalOffset));
+				float * c = reinterpret_cast<float*>(vPtr + colorOffset);
+				c[0] = c[1] = c[2] = v.occlusion;
+				c[3] = 1.0f;
+			}
+			vPtr += vertexSize;
+		}
+		uint32_t * iPtr = indices.data() + indexOffsets[s];
+		for(const auto & index : slab.indices) {
+			if(index & SEAM_FLAG) {
+				*iPtr = slabs[s - 1].upperSeam[index & ~SEAM_FLAG] + vertexOffsets[s - 1];
+			} else {
+				*iPtr = index + vertexOffsets[s];
+			}
+			++iPtr;
+		}
+	});
+
+	vertices.updateBoundingBox();
+	indices.updateIndexRange();
+	return mesh;
 }
 
+//! (static)
+Mesh * MarchingCubesMeshBuilder::createMesh(DataSet & data) {
+
+	if(data.density.size() < data.resolutionX * data.resolutionY * data.resolutionZ ||
+			data.occlusion.size() < data.resolutionX * data.resolutionY * data.resolutionZ)
+		INVALID_ARGUMENT_EXCEPTION("createMesh: Given data has invalid size.");
+
+	return extractSurface(DenseVolume(data), ExtractionParameters(data));
+}
+
+//! (static)
+Mesh * MarchingCubesMeshBuilder::createMesh(const SparseVolume & volume, float isolevel, bool generateNormals, bool compactVertexFormat) {
+	return extractSurface(SparseVolumeView(volume, isolevel), ExtractionParameters(volume, isolevel, generateNormals, compactVertexFormat));
+}
 
 //! (static)
 Mesh * MarchingCubesMeshBuilder::createMeshFromTiledImage(const Util::PixelAccessor & accessor, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ) {
 	const uint32_t numHorizontalTiles = accessor.getWidth() / sizeX;
 	
-	DataSet data(sizeX,sizeY,sizeZ);
-	
-	float * ptr = data.density.data();
-	float * oPtr = data.occlusion.data();
+	SparseVolume volume(sizeX, sizeY, sizeZ);
 	for(uint32_t z = 0; z < sizeZ; ++z) {
 		const uint32_t xOffset = (z % numHorizontalTiles) * sizeX;
 		const uint32_t yOffset = static_cast<uint32_t>(z / numHorizontalTiles) * sizeY;
 		for(uint32_t y = 0; y < sizeY; ++y) {
 			for(uint32_t x = 0; x < sizeX; ++x) {
-				Util::Color4f c = accessor.readColor4f(xOffset + x, yOffset + y);
-				*ptr = c.getR();
-				*oPtr = c.getG();
-				++ptr;
-				++oPtr;
+				const Util::Color4f c = accessor.readColor4f(xOffset + x, yOffset + y);
+				volume.setValue(x, y, z, c.getR(), c.getG());
 			}
 		}
 	}
-	return createMesh(data);
+	return createMesh(volume);
+}
+
+// ------------------------------------------------------------------------------------------
+
+MarchingCubesMeshBuilder::SparseVolume::SparseVolume(uint32_t rX, uint32_t rY, uint32_t rZ, float _backgroundDensity, float _backgroundOcclusion) :
+		resolutionX(rX), resolutionY(rY), resolutionZ(rZ),
+		brickCountX((rX + BRICK_SIZE - 1) / BRICK_SIZE), brickCountY((rY + BRICK_SIZE - 1) / BRICK_SIZE), brickCountZ((rZ + BRICK_SIZE - 1) / BRICK_SIZE),
+		backgroundDensity(_backgroundDensity), backgroundOcclusion(_backgroundOcclusion),
+		bricks(static_cast<size_t>(brickCountX) * brickCountY * brickCountZ) {
+}
+
+MarchingCubesMeshBuilder::SparseVolume::~SparseVolume() = default;
+
+void MarchingCubesMeshBuilder::SparseVolume::setValue(uint32_t x, uint32_t y, uint32_t z, float density, float occlusion) {
+	if(x >= resolutionX || y >= resolutionY || z >= resolutionZ)
+		INVALID_ARGUMENT_EXCEPTION("SparseVolume::setValue: Invalid position.");
+	std::unique_ptr<Brick> & brick = bricks[getBrickIndex(x, y, z)];
+	if(!brick) {
+		if(density == backgroundDensity && occlusion == backgroundOcclusion)
+			return;
+		brick.reset(new Brick);
+		std::fill(std::begin(brick->density), std::end(brick->density), backgroundDensity);
+		std::fill(std::begin(brick->occlusion), std::end(brick->occlusion), backgroundOcclusion);
+		brick->minDensity = brick->maxDensity = backgroundDensity;
+	}
+	const uint32_t index = getValueIndex(x, y, z);
+	brick->density[index] = density;
+	brick->occlusion[index] = occlusion;
+	brick->minDensity = std::min(brick->minDensity, density);
+	brick->maxDensity = std::max(brick->maxDensity, density);
+}
+
+void MarchingCubesMeshBuilder::SparseVolume::getBrickBounds(uint32_t bx, uint32_t by, uint32_t bz, float & minDensity, float & maxDensity) const {
+	const Brick * brick = bricks[(bz * brickCountY + by) * brickCountX + bx].get();
+	if(brick == nullptr) {
+		minDensity = maxDensity = backgroundDensity;
+	} else {
+		minDensity = brick->minDensity;
+		maxDensity = brick->maxDensity;
+	}
+}
+
+uint32_t MarchingCubesMeshBuilder::SparseVolume::getAllocatedBrickCount() const {
+	return static_cast<uint32_t>(std::count_if(bricks.begin(), bricks.end(), [](const std::unique_ptr<Brick> & brick) { return static_cast<bool>(brick); }));
+}
+
+size_t MarchingCubesMeshBuilder::SparseVolume::getMemoryUsage() const {
+	return getAllocatedBrickCount() * sizeof(Brick) + bricks.size() * sizeof(std::unique_ptr<Brick>);
 }
 
 }
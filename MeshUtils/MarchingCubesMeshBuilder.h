@@ -12,6 +12,7 @@
 #define MACRHING_CUBES_MESH_BUILDER_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Util {
@@ -40,16 +41,103 @@ struct DataSet{
 	std::vector<float> density; //! resolutionX*resolutionY*resolutionZ many values.
 	std::vector<float> occlusion;
 	
+	//! If true, the vertex normals are calculated from the gradient of the density field.
+	bool generateNormals;
+	//! If true, normals are stored as 4 bytes and colors as 4 unsigned bytes instead of float values.
+	bool compactVertexFormat;
+	
 	DataSet(const uint32_t rX,const uint32_t rY,const uint32_t rZ) : 
 		resolutionX(rX),resolutionY(rY),resolutionZ(rZ),layerXYSize(rX*rY),
 		isolevel(0.5),
 		rangeMinX(0),rangeMaxX(rX),rangeMinY(0),rangeMaxY(rY),rangeMinZ(0),rangeMaxZ(rZ),
-		density(rX*rY*rZ),occlusion(rX*rY*rZ)
+		density(rX*rY*rZ),occlusion(rX*rY*rZ),
+		generateNormals(true),compactVertexFormat(false)
 		{}
 	
 };
-	
+
+/**
+ * Sparse volume consisting of bricks of BRICK_SIZE^3 grid points, which are only allocated if
+ * one of their values differs from the background values.
+ * For each brick, the minimal and maximal density is stored, which allows skipping all cells
+ * that are completely inside or outside of the surface during extraction.
+ * @note The bounds of a brick are only extended when values are set, so they are conservative.
+ * @note Setting values is not thread-safe; reading values is.
+ */
+class SparseVolume {
+	public:
+		static const uint32_t BRICK_SIZE = 8;
+
+		RENDERINGAPI SparseVolume(uint32_t rX, uint32_t rY, uint32_t rZ, float backgroundDensity = 0.0f, float backgroundOcclusion = 0.0f);
+		RENDERINGAPI ~SparseVolume();
+
+		uint32_t getResolutionX() const			{	return resolutionX;	}
+		uint32_t getResolutionY() const			{	return resolutionY;	}
+		uint32_t getResolutionZ() const			{	return resolutionZ;	}
+		float getBackgroundDensity() const		{	return backgroundDensity;	}
+		float getBackgroundOcclusion() const	{	return backgroundOcclusion;	}
+
+		RENDERINGAPI void setValue(uint32_t x, uint32_t y, uint32_t z, float density, float occlusion);
+
+		float getDensity(uint32_t x, uint32_t y, uint32_t z) const {
+			const Brick * brick = bricks[getBrickIndex(x, y, z)].get();
+			return brick == nullptr ? backgroundDensity : brick->density[getValueIndex(x, y, z)];
+		}
+		float getOcclusion(uint32_t x, uint32_t y, uint32_t z) const {
+			const Brick * brick = bricks[getBrickIndex(x, y, z)].get();
+			return brick == nullptr ? backgroundOcclusion : brick->occlusion[getValueIndex(x, y, z)];
+		}
+
+		uint32_t getBrickCountX() const			{	return brickCountX;	}
+		uint32_t getBrickCountY() const			{	return brickCountY;	}
+		uint32_t getBrickCountZ() const			{	return brickCountZ;	}
+		//! Return the minimal and maximal density of the brick with the given brick coordinates.
+		RENDERINGAPI void getBrickBounds(uint32_t bx, uint32_t by, uint32_t bz, float & minDensity, float & maxDensity) const;
+		RENDERINGAPI uint32_t getAllocatedBrickCount() const;
+		//! Return the number of bytes used by the allocated bricks and the brick table.
+		RENDERINGAPI size_t getMemoryUsage() const;
+
+	private:
+		struct Brick {
+			float density[BRICK_SIZE * BRICK_SIZE * BRICK_SIZE];
+			float occlusion[BRICK_SIZE * BRICK_SIZE * BRICK_SIZE];
+			float minDensity, maxDensity;
+		};
+		const uint32_t resolutionX, resolutionY, resolutionZ;
+		const uint32_t brickCountX, brickCountY, brickCountZ;
+		const float backgroundDensity, backgroundOcclusion;
+		std::vector<std::unique_ptr<Brick>> bricks;
+
+		uint32_t getBrickIndex(uint32_t x, uint32_t y, uint32_t z) const {
+			return ((z / BRICK_SIZE) * brickCountY + y / BRICK_SIZE) * brickCountX + x / BRICK_SIZE;
+		}
+		static uint32_t getValueIndex(uint32_t x, uint32_t y, uint32_t z) {
+			return ((z % BRICK_SIZE) * BRICK_SIZE + y % BRICK_SIZE) * BRICK_SIZE + x % BRICK_SIZE;
+		}
+};
+
+/**
+ * Extract the iso surface of the given data set.
+ * The volume is split into slabs along the z-axis which are processed in parallel.
+ * Vertices on cell edges are shared between all adjacent cells (also across slab borders),
+ * so each intersected edge results in exactly one vertex.
+ * The occlusion value of a vertex is stored as its gray scale color.
+ */
 RENDERINGAPI Mesh * createMesh(DataSet & data);
+
+/**
+ * Extract the iso surface of the given sparse volume.
+ * Cells in bricks whose density bounds (including the neighboring bricks) do not contain the
+ * isolevel are skipped.
+ * @see createMesh(DataSet&)
+ */
+RENDERINGAPI Mesh * createMesh(const SparseVolume & volume, float isolevel = 0.5f, bool generateNormals = true, bool compactVertexFormat = false);
+
+/**
+ * Create a mesh from a volume stored as tiled image (one tile per z-layer, density in the red
+ * channel and occlusion in the green channel).
+ * The values are stored in a SparseVolume, so empty regions do not allocate memory.
+ */
 RENDERINGAPI Mesh * createMeshFromTiledImage(const Util::PixelAccessor & accessor, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ);
 }
 
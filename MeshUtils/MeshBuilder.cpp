@@ -23,7 +23,9 @@
 #include <Util/Graphics/Color.h>
 #include <Util/Graphics/Bitmap.h>
 #include <Util/Graphics/PixelAccessor.h>
+#include <Util/Macros.h>
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 
@@ -40,6 +42,48 @@ static uint32_t nextPowerOfTwo(uint32_t n) {
 	return n + 1;
 }
 
+// -----------------------------------------------------------------------------
+// VertexCursor
+
+MeshBuilder::VertexCursor::VertexCursor(MeshVertexData & vData, uint32_t first, const Geometry::Matrix4x4 * transformation) :
+		index(first), transMat(transformation) {
+	const VertexDescription & vd = vData.getVertexDescription();
+	if(vd.hasAttribute(VertexAttributeIds::POSITION))
+		positions = PositionAttributeAccessor::create(vData);
+	if(vd.hasAttribute(VertexAttributeIds::NORMAL))
+		normals = NormalAttributeAccessor::create(vData);
+	if(vd.hasAttribute(VertexAttributeIds::COLOR))
+		colors = ColorAttributeAccessor::create(vData);
+	if(vd.hasAttribute(VertexAttributeIds::TEXCOORD0))
+		texCoords = TexCoordAttributeAccessor::create(vData);
+}
+
+MeshBuilder::VertexCursor::~VertexCursor() = default;
+
+MeshBuilder::VertexCursor & MeshBuilder::VertexCursor::position(const Geometry::Vec3f & v) {
+	if(positions.isNotNull())
+		positions->setPosition(index, transMat ? transMat->transformPosition(v) : v);
+	return *this;
+}
+
+MeshBuilder::VertexCursor & MeshBuilder::VertexCursor::normal(const Geometry::Vec3f & n) {
+	if(normals.isNotNull())
+		normals->setNormal(index, transMat ? transMat->transformDirection(n) : n);
+	return *this;
+}
+
+MeshBuilder::VertexCursor & MeshBuilder::VertexCursor::color(const Util::Color4f & c) {
+	if(colors.isNotNull())
+		colors->setColor(index, c);
+	return *this;
+}
+
+MeshBuilder::VertexCursor & MeshBuilder::VertexCursor::texCoord0(const Geometry::Vec2 & uv) {
+	if(texCoords.isNotNull())
+		texCoords->setCoordinate(index, uv);
+	return *this;
+}
+
 // -----------------------------------------------------------------------------
 
 MeshBuilder::MeshBuilder() {
@@ -129,12 +173,64 @@ uint32_t MeshBuilder::addVertex() {
 	return vSize++;
 }
 
+uint32_t MeshBuilder::addVertices(uint32_t count) {
+	ensureCapacity(vSize + count, iSize);
+	const uint32_t vertexSize = description.getVertexSize();
+	uint8_t * target = vData.data() + vSize * vertexSize;
+	for(uint32_t i = 0; i < count; ++i)
+		target = std::copy(currentVertex.data(), currentVertex.data() + vertexSize, target);
+	const uint32_t first = vSize;
+	vSize += count;
+	return first;
+}
+
+uint32_t MeshBuilder::addVertices(uint32_t count, const Geometry::Vec3f * positions, const Geometry::Vec3f * normals,
+									const Util::Color4f * colors, const Geometry::Vec2 * texCoords) {
+	const uint32_t first = addVertices(count);
+	VertexCursor cursor = getVertexCursor(first);
+	for(uint32_t i = 0; i < count; ++i, cursor.next()) {
+		if(positions)
+			cursor.position(positions[i]);
+		if(normals)
+			cursor.normal(normals[i]);
+		if(colors)
+			cursor.color(colors[i]);
+		if(texCoords)
+			cursor.texCoord0(texCoords[i]);
+	}
+	return first;
+}
+
+MeshBuilder::VertexCursor MeshBuilder::getVertexCursor(uint32_t first) {
+	return VertexCursor(vData, first, transMat.get());
+}
+
 void MeshBuilder::addIndex(uint32_t idx) {
 	if(iSize >= iData.getIndexCount())
 		iData.allocate(iData.getIndexCount()*2);
 	iData[iSize++] = idx;
 }
 
+void MeshBuilder::addIndices(const uint32_t * indices, uint32_t count, uint32_t offset) {
+	ensureCapacity(vSize, iSize + count);
+	std::transform(indices, indices + count, iData.data() + iSize, [offset](uint32_t index) { return index + offset; });
+	iSize += count;
+}
+
+void MeshBuilder::reserve(uint32_t vertexCount, uint32_t indexCount) {
+	if(vertexCount > vData.getVertexCount())
+		vData.allocate(vertexCount, description);
+	if(indexCount > iData.getIndexCount())
+		iData.allocate(indexCount);
+}
+
+void MeshBuilder::ensureCapacity(uint32_t vertexCount, uint32_t indexCount) {
+	if(vertexCount > vData.getVertexCount())
+		vData.allocate(nextPowerOfTwo(vertexCount), description);
+	if(indexCount > iData.getIndexCount())
+		iData.allocate(nextPowerOfTwo(indexCount));
+}
+
 Mesh* MeshBuilder::buildMesh() {
 	if(isEmpty()) {
 		std::cerr << "Empty Mesh..? (MeshBuilder::buildMesh)\n";
@@ -175,10 +271,7 @@ void MeshBuilder::addTriangle(uint32_t idx0, uint32_t idx1,	uint32_t idx2) {
 }
 
 void MeshBuilder::addMesh(Mesh* mesh) {
-	if(iSize + mesh->getIndexCount() > iData.getIndexCount())
-		iData.allocate(nextPowerOfTwo(iSize + mesh->getIndexCount()));
-	if(vSize + mesh->getVertexCount() > vData.getVertexCount())
-		vData.allocate(nextPowerOfTwo(vSize + mesh->getVertexCount()), description);
+	ensureCapacity(vSize + mesh->getVertexCount(), iSize + mesh->getIndexCount());
 	
 	const auto& id = mesh->openIndexData();
 	const auto& vd = mesh->openVertexData();
@@ -211,6 +304,28 @@ void MeshBuilder::addMesh(Mesh* mesh) {
 	vSize += mesh->getVertexCount();
 }
 
+void MeshBuilder::merge(const MeshBuilder & other) {
+	if(&other == this) {
+		WARN("MeshBuilder::merge: Can not merge a builder with itself.");
+		return;
+	}
+	ensureCapacity(vSize + other.vSize, iSize + other.iSize);
+	const uint32_t vertexSize = description.getVertexSize();
+	if(description == other.description) {
+		std::copy(other.vData.data(), other.vData.data() + other.vSize * vertexSize, vData.data() + vSize * vertexSize);
+	} else {
+		MeshVertexData otherVertices;
+		otherVertices.allocate(other.vSize, other.description);
+		std::copy(other.vData.data(), other.vData.data() + otherVertices.dataSize(), otherVertices.data());
+		std::unique_ptr<MeshVertexData> newVd(MeshUtils::convertVertices(otherVertices, description));
+		std::copy(newVd->data(), newVd->data() + newVd->dataSize(), vData.data() + vSize * vertexSize);
+	}
+	const uint32_t offset = vSize;
+	std::transform(other.iData.data(), other.iData.data() + other.iSize, iData.data() + iSize, [offset](uint32_t index) { return index + offset; });
+	vSize += other.vSize;
+	iSize += other.iSize;
+}
+
 Geometry::Matrix4x4 MeshBuilder::getTransformation() const {
 	return !transMat ? Geometry::Matrix4x4() : *transMat;
 }
@@ -17,6 +17,7 @@
 #include "../Mesh/MeshIndexData.h"
 #include "../Mesh/VertexDescription.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexAttributeAccessors.h"
 #include <Util/ReferenceCounter.h>
 #include <Util/StringUtils.h>
 
@@ -68,6 +69,32 @@ namespace MeshUtils {
 */
 class MeshBuilder : public Util::ReferenceCounter<MeshBuilder> {
 public:
+	/*! Writes the standard attributes of consecutive vertices directly into the vertex buffer of a MeshBuilder
+		(see MeshBuilder::getVertexCursor(...)). Attributes missing in the vertex description are ignored.
+		\note The cursor becomes invalid if the vertex buffer of the builder grows (addVertex(), reserve(), ...). */
+	class VertexCursor {
+	public:
+		RENDERINGAPI VertexCursor(MeshVertexData & vData, uint32_t first, const Geometry::Matrix4x4 * transformation);
+		RENDERINGAPI ~VertexCursor();
+
+		RENDERINGAPI VertexCursor & position(const Geometry::Vec3f & v);
+		RENDERINGAPI VertexCursor & normal(const Geometry::Vec3f & n);
+		RENDERINGAPI VertexCursor & color(const Util::Color4f & c);
+		RENDERINGAPI VertexCursor & texCoord0(const Geometry::Vec2 & uv);
+
+		//! Move to the next vertex.
+		VertexCursor & next()				{	++index;	return *this;	}
+		uint32_t getIndex() const			{	return index;	}
+
+	private:
+		uint32_t index;
+		const Geometry::Matrix4x4 * transMat;
+		Util::Reference<PositionAttributeAccessor> positions;
+		Util::Reference<NormalAttributeAccessor> normals;
+		Util::Reference<ColorAttributeAccessor> colors;
+		Util::Reference<TexCoordAttributeAccessor> texCoords;
+	};
+
 	RENDERINGAPI MeshBuilder();
 	RENDERINGAPI explicit MeshBuilder(VertexDescription description);
 	RENDERINGAPI ~MeshBuilder();
@@ -98,9 +125,28 @@ public:
 		The index of the new vertex is returned.*/
 	RENDERINGAPI uint32_t addVertex();
 
+	/*! Add @p count vertices with the current data and return the index of the first one.
+		The vertices can then be overwritten using getVertexCursor(...). */
+	RENDERINGAPI uint32_t addVertices(uint32_t count);
+
+	/*! Add @p count vertices at once and return the index of the first one.
+		Attributes without an array (nullptr) are taken from the current data. The transformation is applied as in addVertex(). */
+	RENDERINGAPI uint32_t addVertices(uint32_t count, const Geometry::Vec3f * positions, const Geometry::Vec3f * normals = nullptr,
+										const Util::Color4f * colors = nullptr, const Geometry::Vec2 * texCoords = nullptr);
+
+	/*! Returns a cursor writing directly into the vertex buffer, starting at the existing vertex @p first. */
+	RENDERINGAPI VertexCursor getVertexCursor(uint32_t first);
+
 	/*! Add a index to the interal buffer	*/
 	RENDERINGAPI void addIndex(uint32_t idx);
 
+	/*! Add @p count indices at once; @p offset is added to every index. */
+	RENDERINGAPI void addIndices(const uint32_t * indices, uint32_t count, uint32_t offset = 0);
+
+	/*! Make sure that the internal buffers can hold (in total) @p vertexCount vertices and @p indexCount indices
+		without reallocation. */
+	RENDERINGAPI void reserve(uint32_t vertexCount, uint32_t indexCount);
+
 	/*! Adds a quad to the internal buffer, clockwise.	*/
 	RENDERINGAPI void addQuad(uint32_t idx0, uint32_t idx1, uint32_t idx2, uint32_t idx3);
 
@@ -109,9 +155,16 @@ public:
 
 	/*! Get current vertex count which is the index of next vertex added. */
 	uint32_t getNextIndex() const { return vSize; }
+
+	/*! Get current index count. */
+	uint32_t getIndexCount() const { return iSize; }
 	
 	//! Add entire mesh to meshBuilder
 	RENDERINGAPI void addMesh(Mesh* mesh);
+
+	/*! Append the vertices and indices of another builder (e.g. filled on a worker thread); its indices are offset accordingly.
+		The transformation of this builder is not applied, as the vertices of @p other have already been transformed. */
+	RENDERINGAPI void merge(const MeshBuilder & other);
 	
 	//! Get the current transformation.
 	RENDERINGAPI Geometry::Matrix4x4 getTransformation() const;
@@ -124,6 +177,9 @@ public:
 	RENDERINGAPI void transform(const Geometry::Matrix4x4 & m);
 	
 private:
+	//! Grow the buffers (to the next power of two) if they can not hold the given numbers of vertices and indices.
+	void ensureCapacity(uint32_t vertexCount, uint32_t indexCount);
+
 	VertexDescription description;
 	uint32_t vSize=0;
 	uint32_t iSize=0;
@@ -13,11 +13,13 @@
 #include "../Mesh/VertexDescription.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexAccessor.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
 #include "../Texture/Texture.h"
 #include "../Texture/TextureUtils.h"
 #include "TriangleAccessor.h"
+#include "internal/Parallel.h"
 #include <Geometry/BoundingSphere.h>
 #include <Geometry/Box.h>
 #include <Geometry/Matrix4x4.h>
@@ -39,6 +41,7 @@
 #include <Util/Utils.h>
 #include <Util/Numeric.h>
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstring> /* for memcmp */
 #include <map>
@@ -51,6 +54,11 @@
 #include <vector>
 #include <unordered_map>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RENDERING_MESHUTILS_SSE
+#endif
+
 using Geometry::Matrix4x4f;
 using Geometry::Vec3f;
 
@@ -116,17 +124,12 @@ public:
 	static RawVertex midPoint(const RawVertex & rwa, const RawVertex & rwb, const uint32_t & newIndex, const VertexDescription & vd);
 
 	/**
-	 * @param rwa first RawVertex for interpolation
-	 * @param rwb second RawVertex for interpolation
+	 * Writes the linear interpolation of the vertex data @p va and @p vb to @p target.
 	 * @param a interpolation factor (between 0.0 and 1.0)
-	 * @param newIndex the index of the created RawVertex
-	 * @param vd the VertexDescription of both RawVertices
-	 * @return a linear interpolated RawVertex in the middle of rwa and rwb
+	 * @param vd the VertexDescription of both vertices
 	 * @author Sascha Brandt
 	 */
-	static RawVertex interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd);
-
-	static RawVertex move(const RawVertex & rw, const Geometry::Vec3 & dir, const uint32_t & newIndex, const VertexDescription & vd);
+	static void interpolate(uint8_t * target, const uint8_t * va, const uint8_t * vb, float a, const VertexDescription & vd);
 
 private:
 	//! Index of the vertex in the mesh.
@@ -273,19 +276,15 @@ RawVertex RawVertex::midPoint(const RawVertex & rwa, const RawVertex & rwb, cons
 
 template<typename GLType>
 inline
-void interpolateValue(uint8_t* data, const RawVertex & rwa, const RawVertex & rwb, const VertexAttribute& attr, unsigned j, float a, float a_inv) {
-	float f = static_cast<float>((reinterpret_cast<const GLType *> (rwa.getData() + attr.getOffset() + j * sizeof(GLType)))[0]) * a_inv;
-	f += static_cast<float>((reinterpret_cast<const GLType *> (rwb.getData() + attr.getOffset() + j * sizeof(GLType)))[0]) * a;
+void interpolateValue(uint8_t* data, const uint8_t * va, const uint8_t * vb, const VertexAttribute& attr, unsigned j, float a, float a_inv) {
+	float f = static_cast<float>((reinterpret_cast<const GLType *> (va + attr.getOffset() + j * sizeof(GLType)))[0]) * a_inv;
+	f += static_cast<float>((reinterpret_cast<const GLType *> (vb + attr.getOffset() + j * sizeof(GLType)))[0]) * a;
 	(reinterpret_cast<GLType *> (data + attr.getOffset() + j * sizeof(GLType)))[0] = static_cast<GLType>(f);
 }
 
 // -----------------------------------------------------------------------------
 
-
-RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd) {
-	FAIL_IF(rwa.getSize()!=rwb.getSize());
-	auto data = new uint8_t[rwa.getSize()];
-	RawVertex ret(newIndex, data, rwa.getSize());
+void RawVertex::interpolate(uint8_t * data, const uint8_t * va, const uint8_t * vb, float a, const VertexDescription & vd) {
 	float a_inv = 1.0f - a;
 	for(const auto & attr : vd.getAttributes()) {
 		if (!attr.isValid())
@@ -293,28 +292,29 @@ RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, f
 		for (unsigned j = 0; j < attr.getComponentCount(); ++j) {
 			switch (attr.getDataType()) {
 			case Util::TypeConstant::FLOAT:
-				interpolateValue<GLfloat>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLfloat>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::UINT8:
-				interpolateValue<GLubyte>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLubyte>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::INT8:
+				interpolateValue<GLbyte>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::UINT16:
-				interpolateValue<GLushort>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLushort>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::INT16:
-				interpolateValue<GLshort>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLshort>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::UINT32:
-				interpolateValue<GLuint>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLuint>(data, va, vb, attr, j, a, a_inv);
 				break;
 			case Util::TypeConstant::INT32:
-				interpolateValue<GLint>(data, rwa, rwb, attr, j, a, a_inv);
+				interpolateValue<GLint>(data, va, vb, attr, j, a, a_inv);
 				break;
 #ifdef LIB_GL
 				case Util::TypeConstant::DOUBLE:
-					interpolateValue<GLdouble>(data, rwa, rwb, attr, j, a, a_inv);
+					interpolateValue<GLdouble>(data, va, vb, attr, j, a, a_inv);
 					break;
 #endif /* LIB_GL */
 			default:
@@ -322,23 +322,6 @@ RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, f
 			}
 		}
 	}
-	return ret;
-}
-
-// -----------------------------------------------------------------------------
-
-RawVertex RawVertex::move(const RawVertex & rw, const Geometry::Vec3 & dir, const uint32_t & newIndex, const VertexDescription & vd) {
-	auto data = new uint8_t[rw.getSize()];
-	std::copy(rw.getData(), rw.getData() + rw.getSize(), data);
-	const VertexAttribute & attr = vd.getAttribute(VertexAttributeIds::POSITION);
-	// assume float
-	float* posData = reinterpret_cast<float *> (data + attr.getOffset());
-	posData[0] += dir.x();
-	posData[1] += dir.y();
-	posData[2] += dir.z();
-
-	RawVertex ret(newIndex, data, rw.getSize());
-	return ret;
 }
 
 // -----------------------------------------------------------------------------
@@ -634,11 +617,64 @@ void shrinkMesh(Mesh * m, bool shrinkPosition) {
 
 // -----------------------------------------------------------------------------
 
-//! (internal) Transforms a range of vertices with the given matrix.
+/**
+ * Multiply @p count vectors (x,y,z,w) with the given matrix, where x,y,z are the first three float values
+ * at @p data + i * @p stride. Only the x,y,z values of the result are written back.
+ */
+static void transformVec3Array(const Matrix4x4f & transMat, uint8_t * data, size_t stride, uint32_t count, float w) {
+	const float * m = transMat.getData(); // row-major
+#if defined(RENDERING_MESHUTILS_SSE)
+	const __m128 col0 = _mm_setr_ps(m[0], m[4], m[8], m[12]);
+	const __m128 col1 = _mm_setr_ps(m[1], m[5], m[9], m[13]);
+	const __m128 col2 = _mm_setr_ps(m[2], m[6], m[10], m[14]);
+	const __m128 col3 = _mm_mul_ps(_mm_setr_ps(m[3], m[7], m[11], m[15]), _mm_set1_ps(w));
+	alignas(16) float result[4];
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float * v = reinterpret_cast<float *>(data);
+		const __m128 xy = _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(v[0])), _mm_mul_ps(col1, _mm_set1_ps(v[1])));
+		const __m128 zw = _mm_add_ps(_mm_mul_ps(col2, _mm_set1_ps(v[2])), col3);
+		_mm_store_ps(result, _mm_add_ps(xy, zw));
+		v[0] = result[0];
+		v[1] = result[1];
+		v[2] = result[2];
+	}
+#else
+	for(uint32_t i = 0; i < count; ++i, data += stride) {
+		float * v = reinterpret_cast<float *>(data);
+		const float x = v[0], y = v[1], z = v[2];
+		v[0] = m[0] * x + m[1] * y + m[2] * z + m[3] * w;
+		v[1] = m[4] * x + m[5] * y + m[6] * z + m[7] * w;
+		v[2] = m[8] * x + m[9] * y + m[10] * z + m[11] * w;
+	}
+#endif
+}
+
+/**
+ * Transform the attribute with the given name of the vertices [begin, begin+numVerts) without marking the data as changed.
+ * Float attributes are transformed in place by a batched kernel, other types are transformed using an accessor.
+ * @param w 1 for positions and 0 for directions.
+ */
+static void transformAttribute(MeshVertexData & vData, Util::StringIdentifier attrName, const Matrix4x4f & transMat, uint32_t begin, uint32_t numVerts, float w) {
+	const VertexAttribute & attr = vData.getVertexDescription().getAttribute(attrName);
+	if(attr.getDataType() == Util::TypeConstant::FLOAT && attr.getComponentCount() >= 3) {
+		transformVec3Array(transMat, vData[begin] + attr.getOffset(), vData.getVertexDescription().getVertexSize(), numVerts, w);
+	} else if(w != 0.0f) {
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,attrName));
+		const uint32_t end = begin+numVerts;
+		for(uint32_t i=begin;i<end;++i)
+			positionAccessor->setPosition(i,transMat.transformPosition(positionAccessor->getPosition(i)));
+	} else {
+		Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,attrName));
+		const uint32_t end = begin+numVerts;
+		for(uint32_t i=begin;i<end;++i)
+			normalAccessor->setNormal(i, (transMat * Geometry::Vec4(normalAccessor->getNormal(i),0)).xyz());
+	}
+}
+
 static void transformVertexData(MeshVertexData & vData, const Matrix4x4f & transMat, uint32_t begin, uint32_t numVerts) {
-	transformCoordinates(vData, VertexAttributeIds::POSITION, transMat, begin, numVerts);
+	transformAttribute(vData, VertexAttributeIds::POSITION, transMat, begin, numVerts, 1.0f);
 	if(vData.getVertexDescription().hasAttribute(VertexAttributeIds::NORMAL))
-		transformNormals(vData, VertexAttributeIds::NORMAL, transMat, begin, numVerts);
+		transformAttribute(vData, VertexAttributeIds::NORMAL, transMat, begin, numVerts, 0.0f);
 }
 
 // -----------------------------------------------------------------------------
@@ -646,6 +682,7 @@ static void transformVertexData(MeshVertexData & vData, const Matrix4x4f & trans
 //! (static)
 void transform(MeshVertexData & vData, const Matrix4x4f & transMat) {
 	transformVertexData(vData, transMat, 0, vData.getVertexCount());
+	vData.markAsChanged();
 	vData.updateBoundingBox();
 }
 
@@ -654,11 +691,7 @@ void transform(MeshVertexData & vData, const Matrix4x4f & transMat) {
 //! (static)
 void transformCoordinates(MeshVertexData & vData, Util::StringIdentifier attrName, const Geometry::Matrix4x4 & transMat, uint32_t begin,
 		uint32_t numVerts) {
-
-	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,attrName));
-	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		positionAccessor->setPosition(i,transMat.transformPosition(positionAccessor->getPosition(i)));
+	transformAttribute(vData, attrName, transMat, begin, numVerts, 1.0f);
 	vData.markAsChanged();
 }
 
@@ -667,11 +700,7 @@ void transformCoordinates(MeshVertexData & vData, Util::StringIdentifier attrNam
 //! (static)
 void transformNormals(MeshVertexData & vData, Util::StringIdentifier attrName, const Geometry::Matrix4x4 & transMat, uint32_t begin,
 		uint32_t numVerts) {
-
-	Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,attrName));
-	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		normalAccessor->setNormal(i, (transMat * Geometry::Vec4(normalAccessor->getNormal(i),0)).xyz());
+	transformAttribute(vData, attrName, transMat, begin, numVerts, 0.0f);
 	vData.markAsChanged();
 }
 
@@ -821,46 +850,70 @@ void calculateNormals(Mesh * m) {
  * Must have identical VertexDescription.
  */
 Mesh * combineMeshes(const std::deque<Mesh *> & meshArray) {
-	return combineMeshes(meshArray, std::deque<Geometry::Matrix4x4>());
+	const std::vector<Mesh *> meshes(meshArray.begin(), meshArray.end());
+	return combineMeshes(meshes.data(), meshes.size(), nullptr, 0);
 }
 
 // -----------------------------------------------------------------------------
 
 Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geometry::Matrix4x4> & transformations) {
-	if (meshArray.empty()) {
+	const std::vector<Mesh *> meshes(meshArray.begin(), meshArray.end());
+	const std::vector<Geometry::Matrix4x4> matrices(transformations.begin(), transformations.end());
+	return combineMeshes(meshes.data(), meshes.size(), matrices.data(), matrices.size());
+}
+
+// -----------------------------------------------------------------------------
+
+Mesh * combineMeshes(const std::vector<Mesh *> & meshes, const std::vector<Geometry::Matrix4x4> & transformations) {
+	return combineMeshes(meshes.data(), meshes.size(), transformations.data(), transformations.size());
+}
+
+// -----------------------------------------------------------------------------
+
+Mesh * combineMeshes(Mesh * const * meshArray, size_t meshCount, const Geometry::Matrix4x4 * transformations, size_t transformationCount) {
+	if (meshCount == 0) {
 		return nullptr;
 	}
 
-	Mesh * firstMesh = meshArray.front();
+	Mesh * firstMesh = meshArray[0];
 	if (!firstMesh)
 		FAIL();
 
 	const VertexDescription & vd = firstMesh->getVertexDescription();
 
-	std::deque<Mesh *> meshArray2; //< collect meshes which have the same vertexDescription
-	std::deque<Geometry::Matrix4x4> transformations2; //< collect meshes which have the same vertexDescription
+	//! Source mesh with its position in the combined mesh.
+	struct Part {
+		const MeshVertexData * vertexData;
+		const MeshIndexData * indexData;
+		const Geometry::Matrix4x4 * transformation;
+		uint32_t vertexOffset;
+		uint32_t indexOffset;
+	};
+	std::vector<Part> parts;
+	parts.reserve(meshCount);
 
-	//count vertices and indices, check if Meshes exist and have the same vertexDescription
+	// compute the layout of the combined mesh, check if Meshes exist and have the same vertexDescription
 	uint32_t indexCount = 0;
 	uint32_t vertexCount = 0;
-	{
-		auto tIt = transformations.begin();
-		for (auto it = meshArray.begin(); it != meshArray.end(); ++it, (tIt != transformations.end() ? ++tIt : tIt)) {
-			if (!(*it)) {
-				WARN("combineMeshes: No Mesh");
-				continue;
-			}
-			if (!((*it)->getVertexDescription() == vd)) {
-				WARN("combineMeshes: can't combine meshes with different vertex descriptions.");
-				std::cout << (*it)->getVertexDescription().toString() << ":" << vd.toString() << "\n";
-				continue;
-			}
-			meshArray2.push_back(*it);
-			if (tIt != transformations.end())
-				transformations2.push_back(*tIt);
-			indexCount += (*it)->getIndexCount();
-			vertexCount += (*it)->getVertexCount();
+	const Geometry::Matrix4x4 noTrans;
+	for (size_t i = 0; i < meshCount; ++i) {
+		Mesh * currentMesh = meshArray[i];
+		if (!currentMesh) {
+			WARN("combineMeshes: No Mesh");
+			continue;
+		}
+		if (!(currentMesh->getVertexDescription() == vd)) {
+			WARN("combineMeshes: can't combine meshes with different vertex descriptions.");
+			std::cout << currentMesh->getVertexDescription().toString() << ":" << vd.toString() << "\n";
+			continue;
 		}
+		const Geometry::Matrix4x4 * transformation = nullptr;
+		if (i < transformationCount && transformations[i] != noTrans)
+			transformation = &transformations[i];
+		// openVertexData/openIndexData make sure the local data is available (this must not be done in parallel)
+		parts.push_back({&currentMesh->openVertexData(), &currentMesh->openIndexData(), transformation, vertexCount, indexCount});
+		indexCount += currentMesh->getIndexCount();
+		vertexCount += currentMesh->getVertexCount();
 	}
 	// create mesh
 	auto mesh = new Mesh;
@@ -870,29 +923,23 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 	indices.allocate(indexCount);
 
 	// copy data
-
-	uint32_t indexPointer = 0;
-	uint32_t vertexPointer = 0;
-
-	Geometry::Matrix4x4 noTrans;
-	auto tIt2 = transformations2.cbegin();
-	for (auto it = meshArray2.cbegin(); it != meshArray2.cend(); ++it, (tIt2 != transformations2.cend() ? ++tIt2 : tIt2)) {
-		Mesh * currentMesh = *it;
+	Parallel::forEach(0, static_cast<uint32_t>(parts.size()), [&](uint32_t p) {
+		const Part & part = parts[p];
 		// add modified indices
-		MeshIndexData & currentIndices = currentMesh->openIndexData();
+		const MeshIndexData & currentIndices = *part.indexData;
+		const uint32_t * source = currentIndices.data();
+		uint32_t * target = indices.data() + part.indexOffset;
 		for (uint32_t j = 0; j < currentIndices.getIndexCount(); ++j)
-			indices[indexPointer + j] = currentIndices[j] + vertexPointer;
-		indexPointer += currentIndices.getIndexCount();
+			target[j] = source[j] + part.vertexOffset;
 
 		// add vertices
-		MeshVertexData & currentVertices = currentMesh->openVertexData();
-		std::copy(currentVertices.data(), currentVertices.data() + currentVertices.dataSize(), vertices[vertexPointer]);
+		const MeshVertexData & currentVertices = *part.vertexData;
+		std::copy(currentVertices.data(), currentVertices.data() + currentVertices.dataSize(), vertices[part.vertexOffset]);
 
-		if (tIt2 != transformations2.cend() && (*tIt2) != noTrans) {
-			transformVertexData(vertices, (*tIt2), vertexPointer, currentVertices.getVertexCount());
+		if (part.transformation) {
+			transformVertexData(vertices, *part.transformation, part.vertexOffset, currentVertices.getVertexCount());
 		}
-		vertexPointer += currentVertices.getVertexCount();
-	}
+	});
 	vertices.updateBoundingBox();
 	indices.updateIndexRange();
 
@@ -1571,383 +1618,591 @@ void calculateTextureCoordinates_projection(Mesh * mesh, Util::StringIdentifier
 
 //!	(static)
 void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName) {
+	calculateTangentVectors(mesh, uvName, tangentVecName, Util::TypeConstant::INT8);
+}
+
+//! Write a normalized vector with four components into a tangent attribute of type INT8, INT16 or FLOAT.
+static void writeTangent(uint8_t * ptr, Util::TypeConstant type, const Geometry::Vec3 & t, float w) {
+	const float values[4] = {t.x(), t.y(), t.z(), w};
+	switch(type) {
+		case Util::TypeConstant::INT8:
+			for(uint_fast8_t i = 0; i < 4; ++i)
+				reinterpret_cast<int8_t*>(ptr)[i] = static_cast<int8_t>(std::round(std::max(-1.0f, std::min(1.0f, values[i])) * 127.0f));
+			break;
+		case Util::TypeConstant::INT16:
+			for(uint_fast8_t i = 0; i < 4; ++i)
+				reinterpret_cast<int16_t*>(ptr)[i] = static_cast<int16_t>(std::round(std::max(-1.0f, std::min(1.0f, values[i])) * 32767.0f));
+			break;
+		default:
+			std::copy(values, values + 4, reinterpret_cast<float*>(ptr));
+			break;
+	}
+}
+
+void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName, Util::TypeConstant tangentType) {
 	using Geometry::Vec3;
 	using Geometry::Vec2;
 	MeshVertexData & vertices(mesh->openVertexData());
-	const MeshIndexData & indices(mesh->openIndexData());
+	MeshIndexData & indices(mesh->openIndexData());
 
 	{ // assure mesh has the right form
 		if (mesh->getDrawMode() != Mesh::DRAW_TRIANGLES)
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No triangle mesh.");
 
-		if (vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION).getDataType() != Util::TypeConstant::FLOAT)
-			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No float positions.");
+		if (!vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION).isValid())
+			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No positions.");
 
 		if (!vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL).isValid())
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No normals.");
 
-		if (vertices.getVertexDescription().getAttribute(uvName).getDataType() != Util::TypeConstant::FLOAT
+		if (!vertices.getVertexDescription().getAttribute(uvName).isValid()
 				|| vertices.getVertexDescription().getAttribute(uvName).getComponentCount() < 2)
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No or wrong texture coordinates.");
 
-		// add slot for 4 byte tangent vector
+		if (tangentType != Util::TypeConstant::INT8 && tangentType != Util::TypeConstant::INT16 && tangentType != Util::TypeConstant::FLOAT)
+			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: Unsupported tangent type.");
+
+		// add slot for the 4 component tangent vector
 		if (!vertices.getVertexDescription().getAttribute(tangentVecName).isValid()) {
 			VertexDescription newVd = vertices.getVertexDescription();
-			newVd.appendAttribute(tangentVecName, Util::TypeConstant::INT8, 4, true);
+			newVd.appendAttribute(tangentVecName, tangentType, 4, tangentType != Util::TypeConstant::FLOAT);
 			std::unique_ptr<MeshVertexData> newVertices(convertVertices(vertices, newVd));
 			vertices.swap(*newVertices.get());
 		}
-		if (vertices.getVertexDescription().getAttribute(tangentVecName).getDataType() != Util::TypeConstant::INT8 || vertices.getVertexDescription().getAttribute(
-				tangentVecName).getComponentCount() != 4)
-			INVALID_ARGUMENT_EXCEPTION("createTextureCoordinates_boxProjection: Wrong tangent format.");
-
+		const VertexAttribute & tanAttr = vertices.getVertexDescription().getAttribute(tangentVecName);
+		if ((tanAttr.getDataType() != Util::TypeConstant::INT8 && tanAttr.getDataType() != Util::TypeConstant::INT16
+				&& tanAttr.getDataType() != Util::TypeConstant::FLOAT) || tanAttr.getComponentCount() != 4)
+			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: Wrong tangent format.");
+	}
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	const uint32_t cornerCount = triangleCount * 3;
+	static const uint32_t GRAIN_SIZE = 1 << 12;
+
+	// read the attributes (of any type) once
+	std::vector<Vec3> positions(vertexCount);
+	std::vector<Vec3> normals(vertexCount);
+	std::vector<Vec2> uvs(vertexCount);
+	{
+		auto acc = VertexAccessor::create(vertices);
+		Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t v = begin; v < end; ++v) {
+				positions[v] = acc->getPosition(v);
+				normals[v] = acc->getNormal(v);
+				const float length = normals[v].length();
+				if (length > 0.0f)
+					normals[v] /= length;
+				uvs[v] = acc->getTexCoord(v, uvName);
+			}
+		});
+	}
+
+	// per triangle: normalized first tangent direction (vOs) and orientation in texture space (as in MikkTSpace)
+	std::vector<Vec3> triangleTangents(triangleCount);
+	enum : uint8_t { ORIENT_PRESERVING = 1, DEGENERATE = 2 };
+	std::vector<uint8_t> triangleFlags(triangleCount, 0);
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t t = begin; t < end; ++t) {
+			const uint32_t i0 = indices[t * 3], i1 = indices[t * 3 + 1], i2 = indices[t * 3 + 2];
+			const Vec3 d1 = positions[i1] - positions[i0];
+			const Vec3 d2 = positions[i2] - positions[i0];
+			const float t21x = uvs[i1].x() - uvs[i0].x();
+			const float t21y = uvs[i1].y() - uvs[i0].y();
+			const float t31x = uvs[i2].x() - uvs[i0].x();
+			const float t31y = uvs[i2].y() - uvs[i0].y();
+			const float signedAreaSTx2 = t21x * t31y - t21y * t31x;
+			const Vec3 vOs = d1 * t31y - d2 * t21y;
+			const float lengthOs = vOs.length();
+			uint8_t flags = signedAreaSTx2 > 0.0f ? ORIENT_PRESERVING : 0;
+			if (signedAreaSTx2 == 0.0f || lengthOs == 0.0f) {
+				flags |= DEGENERATE;
+			} else {
+				triangleTangents[t] = vOs * ((flags & ORIENT_PRESERVING) ? 1.0f : -1.0f) / lengthOs;
+			}
+			triangleFlags[t] = flags;
+		}
+	});
+
+	// corners of each vertex (counting sort)
+	std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+	for (uint32_t c = 0; c < cornerCount; ++c)
+		++cornerOffsets[indices[c] + 1];
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		cornerOffsets[v + 1] += cornerOffsets[v];
+	std::vector<uint32_t> vertexCorners(cornerCount);
+	{
+		std::vector<uint32_t> cursor(cornerOffsets.begin(), cornerOffsets.end() - 1);
+		for (uint32_t c = 0; c < cornerCount; ++c)
+			vertexCorners[cursor[indices[c]]++] = c;
+	}
+
+	/* Accumulate the angle weighted tangents of the corners of each vertex, grouped by the orientation of the
+	   triangles (MikkTSpace does not share a tangent between mirrored and non-mirrored triangles).
+	   If a vertex is used by both groups, the mirrored group gets a copy of the vertex. */
+	std::vector<Vec3> tangents(vertexCount * 2);
+	std::vector<uint8_t> usedGroups(vertexCount, 0); // bit 0: mirrored group used, bit 1: preserving group used
+	Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t v = begin; v < end; ++v) {
+			const Vec3 & n = normals[v];
+			for (uint32_t i = cornerOffsets[v]; i < cornerOffsets[v + 1]; ++i) {
+				const uint32_t c = vertexCorners[i];
+				const uint32_t t = c / 3;
+				if (triangleFlags[t] & DEGENERATE)
+					continue;
+				const uint8_t group = (triangleFlags[t] & ORIENT_PRESERVING) ? 1 : 0;
+				usedGroups[v] |= (1 << group);
+				Vec3 vOs = triangleTangents[t] - n * n.dot(triangleTangents[t]);
+				const float length = vOs.length();
+				if (length == 0.0f)
+					continue;
+				vOs /= length;
+				// weight by the angle of the triangle at the corner (measured in the tangent plane of the normal)
+				Vec3 e1 = positions[indices[t * 3 + (c + 1) % 3]] - positions[v];
+				Vec3 e2 = positions[indices[t * 3 + (c + 2) % 3]] - positions[v];
+				e1 = e1 - n * n.dot(e1);
+				e2 = e2 - n * n.dot(e2);
+				const float l1 = e1.length(), l2 = e2.length();
+				if (l1 == 0.0f || l2 == 0.0f)
+					continue;
+				const float angle = std::acos(std::max(-1.0f, std::min(1.0f, e1.dot(e2) / (l1 * l2))));
+				tangents[v * 2 + group] += vOs * angle;
+			}
+		}
+	});
+
+	// split vertices used by both groups
+	std::vector<uint32_t> splitVertex(vertexCount, 0);
+	uint32_t newVertexCount = vertexCount;
+	for (uint32_t v = 0; v < vertexCount; ++v) {
+		if (usedGroups[v] == 3)
+			splitVertex[v] = newVertexCount++;
+	}
+	if (newVertexCount != vertexCount) {
+		MeshVertexData newVertices;
+		newVertices.allocate(newVertexCount, vertices.getVertexDescription());
+		const size_t vertexSize = vertices.getVertexDescription().getVertexSize();
+		std::copy(vertices.data(), vertices.data() + vertices.dataSize(), newVertices.data());
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			if (splitVertex[v] != 0)
+				std::copy(vertices[v], vertices[v] + vertexSize, newVertices[splitVertex[v]]);
+		}
+		vertices.swap(newVertices);
+		vertices.updateBoundingBox();
+		for (uint32_t c = 0; c < cornerCount; ++c) {
+			const uint32_t v = indices[c];
+			if (splitVertex[v] != 0 && (triangleFlags[c / 3] & (ORIENT_PRESERVING | DEGENERATE)) == 0)
+				indices[c] = splitVertex[v];
+		}
+		indices.markAsChanged();
+		indices.updateIndexRange();
 	}
-	// calculate tangents and bitangents
-	const VertexDescription & vDesc = vertices.getVertexDescription();
-	const VertexAttribute & posAttr = vDesc.getAttribute(VertexAttributeIds::POSITION);
-	const VertexAttribute & normalAttr = vDesc.getAttribute(VertexAttributeIds::NORMAL);
-	const VertexAttribute & uvAttr = vDesc.getAttribute(uvName);
-	const VertexAttribute & tanAttr = vDesc.getAttribute(tangentVecName);
-
-	std::vector<Vec3> tan1(vertices.getVertexCount());
-	std::vector<Vec3> tan2(vertices.getVertexCount());
-
-	for (uint32_t i = 0; i < indices.getIndexCount(); i += 3) {
-		const uint32_t index1 = indices[i];
-		const uint32_t index2 = indices[i + 1];
-		const uint32_t index3 = indices[i + 2];
-
-		const Vec3 pos1(reinterpret_cast<float*> (vertices[index1] + posAttr.getOffset()));
-		const Vec3 pos2(reinterpret_cast<float*> (vertices[index2] + posAttr.getOffset()));
-		const Vec3 pos3(reinterpret_cast<float*> (vertices[index3] + posAttr.getOffset()));
 
-		const Vec2 uv1(reinterpret_cast<float*> (vertices[index1] + uvAttr.getOffset()));
-		const Vec2 uv2(reinterpret_cast<float*> (vertices[index2] + uvAttr.getOffset()));
-		const Vec2 uv3(reinterpret_cast<float*> (vertices[index3] + uvAttr.getOffset()));
-
-		const float x1 = pos2.x() - pos1.x();
-		const float x2 = pos3.x() - pos1.x();
-		const float y1 = pos2.y() - pos1.y();
-		const float y2 = pos3.y() - pos1.y();
-		const float z1 = pos2.z() - pos1.z();
-		const float z2 = pos3.z() - pos1.z();
-
-		const float s1 = uv2.x() - uv1.x();
-		const float s2 = uv3.x() - uv1.x();
-		const float t1 = uv2.y() - uv1.y();
-		const float t2 = uv3.y() - uv1.y();
+	// write the tangents; the w component contains the handedness of the tangent space
+	const VertexAttribute & tanAttr = vertices.getVertexDescription().getAttribute(tangentVecName);
+	const auto writeGroup = [&](uint32_t v, uint32_t target, uint8_t group) {
+		Vec3 t = tangents[v * 2 + group];
+		const float length = t.length();
+		if (length > 0.0f) {
+			t /= length;
+		} else {
+			// no tangent information available: use an arbitrary vector perpendicular to the normal
+			const Vec3 & n = normals[v];
+			t = std::abs(n.x()) < 0.9f ? Vec3(1, 0, 0).cross(n) : Vec3(0, 1, 0).cross(n);
+			const float l = t.length();
+			t = l > 0.0f ? t / l : Vec3(1, 0, 0);
+		}
+		writeTangent(vertices[target] + tanAttr.getOffset(), tanAttr.getDataType(), t, group == 1 ? 1.0f : -1.0f);
+	};
+	Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t v = begin; v < end; ++v) {
+			if (usedGroups[v] == 3) {
+				writeGroup(v, v, 1);
+				writeGroup(v, splitVertex[v], 0);
+			} else {
+				writeGroup(v, v, usedGroups[v] == 1 ? 0 : 1);
+			}
+		}
+	});
+	vertices.markAsChanged();
+}
 
-		const float r = 1.0f / (s1 * t2 - s2 * t1);
-		const Vec3 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		const Vec3 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+// -----------------------------------------------------------------------------
 
-		tan1[index1] += sdir;
-		tan1[index2] += sdir;
-		tan1[index3] += sdir;
+inline bool isZero(float f, float tolerance=std::numeric_limits<float>::epsilon()) {
+	return std::abs(f) <= tolerance;
+}
 
-		tan2[index1] += tdir;
-		tan2[index2] += tdir;
-		tan2[index3] += tdir;
-	}
+// -----------------------------------------------------------------------------
 
-	// -----------------------------------------------------------------------------
+/**
+ * Cut configuration of a triangle with respect to a plane.
+ * @a first is the corner that becomes the corner 'a' of the split triangles:
+ * for SPLIT_2 the corner lying on the plane, for SPLIT_3 the single corner on one side of the plane.
+ */
+struct TriangleCut {
+	enum Type : uint8_t { KEEP, SPLIT_2, SPLIT_3 };
+	uint8_t type;
+	uint8_t first;
+};
 
-	if (normalAttr.getDataType() == Util::TypeConstant::FLOAT) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const Vec3 normal(reinterpret_cast<float*> (vertices[i] + normalAttr.getOffset()));
-			const Vec3 & t = tan1[i];
-			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
+inline TriangleCut classifyTriangleCut(float pa, float pb, float pc, float tolerance) {
+	if( (pa>=-tolerance && pb>=-tolerance && pc>=-tolerance) || (pa<=tolerance && pb<=tolerance && pc<=tolerance) ) {
+		// triangle is completely above/below plane
+		return {TriangleCut::KEEP, 0};
+	} else if (isZero(pa, tolerance) || isZero(pb, tolerance) || isZero(pc, tolerance)) {
+		// one point lies on the plane
+		return {TriangleCut::SPLIT_2, static_cast<uint8_t>(isZero(pa, tolerance) ? 0 : (isZero(pb, tolerance) ? 1 : 2))};
+	} else if( (pb>=0 && pa<=0 && pc<=0) || (pb<=0 && pa>=0 && pc>=0) ) {
+		// only b is above/below plane
+		return {TriangleCut::SPLIT_3, 1};
+	} else if( (pc>=0 && pa<=0 && pb<=0) || (pc<=0 && pa>=0 && pb>=0) ) {
+		// only c is above/below plane
+		return {TriangleCut::SPLIT_3, 2};
+	}
+	return {TriangleCut::SPLIT_3, 0};
+}
 
-			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			int8_t handedness = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
-			tPtr[0] = handedness * static_cast<int8_t> (tan.x());
-			tPtr[1] = handedness * static_cast<int8_t> (tan.y());
-			tPtr[2] = handedness * static_cast<int8_t> (tan.z());
-			tPtr[3] = handedness;
+/**
+ * Plane cut step shared by cutMeshSelection() and getMeshSection():
+ * Calculates the signed plane distances of all vertices and classifies all (selected) triangles.
+ * The vertex positions have to be floats.
+ */
+static void classifyPlaneCut(const MeshVertexData & vertices, const MeshIndexData & indices, const Geometry::Plane& plane,
+							const std::vector<bool> & selection, float tolerance,
+							std::vector<float> & distances, std::vector<TriangleCut> & cuts) {
+	static const uint32_t GRAIN_SIZE = 1 << 12;
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	const size_t posOffset = vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION).getOffset();
+
+	distances.resize(vertexCount);
+	Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t v = begin; v < end; ++v)
+			distances[v] = plane.planeTest(Geometry::Vec3(reinterpret_cast<const float *>(vertices[v] + posOffset)));
+	});
+
+	cuts.resize(triangleCount);
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			if(!selection.empty() && (t >= selection.size() || !selection[t])) {
+				cuts[t] = {TriangleCut::KEEP, 0};
+				continue;
+			}
+			cuts[t] = classifyTriangleCut(distances[indices[t * 3]], distances[indices[t * 3 + 1]], distances[indices[t * 3 + 2]], tolerance);
 		}
-	} else if (normalAttr.getDataType() == Util::TypeConstant::INT8) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const int8_t * nPtr = reinterpret_cast<const int8_t*> (vertices[i] + normalAttr.getOffset());
-			const Vec3 normal((Vec3(nPtr[0], nPtr[1], nPtr[2])).normalize());
-			const Vec3 & t = tan1[i];
-			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
+	});
+}
 
-			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			int8_t handedness = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
-			tPtr[0] = handedness * static_cast<int8_t> (tan.x());
-			tPtr[1] = handedness * static_cast<int8_t> (tan.y());
-			tPtr[2] = handedness * static_cast<int8_t> (tan.z());
-			tPtr[3] = handedness;
+//! Converts a set of triangle indices into a dense selection. An empty set selects all triangles.
+static std::vector<bool> createTriangleSelection(const std::set<uint32_t> & tIndices, uint32_t triangleCount) {
+	std::vector<bool> selection;
+	if(!tIndices.empty()) {
+		selection.resize(triangleCount, false);
+		for(const auto t : tIndices) {
+			if(t < triangleCount)
+				selection[t] = true;
 		}
 	}
+	return selection;
 }
 
-// -----------------------------------------------------------------------------
-
-inline bool isZero(float f, float tolerance=std::numeric_limits<float>::epsilon()) {
-	return std::abs(f) <= tolerance;
+//!	(static)
+void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices, float tolerance) {
+	cutMeshSelection(m, plane, createTriangleSelection(tIndices, m->openIndexData().getIndexCount() / 3), tolerance);
 }
 
-// -----------------------------------------------------------------------------
-
 //!	(static)
-void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices, float tolerance) {
+void cutMeshSelection(Mesh* m, const Geometry::Plane& plane, const std::vector<bool> & selection, float tolerance) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
 	if (posAttr.getDataType() != Util::TypeConstant::FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("cutMesh: Unsupported vertex format.");
 		return;
 	}
-
-	std::deque<SplitTriangle> triangles;
-	std::deque<SplitTriangle> trianglesOut;
-	std::deque<SplitTriangle> trianglesNew;
-	std::vector<RawVertex> vertexArray;
+	static const uint32_t GRAIN_SIZE = 1 << 12;
 
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+
+	std::vector<float> distances;
+	std::vector<TriangleCut> cuts;
+	classifyPlaneCut(vertices, indices, plane, selection, tolerance, distances, cuts);
+
+	/* Output layout: every triangle keeps its position (a split triangle is replaced by its first part);
+	   the other parts follow after all original triangles, the new vertices after all original vertices.
+	   A split triangle adds as many triangles as vertices, so one offset array serves both. */
+	std::vector<uint32_t> offsets(triangleCount + 1, 0);
+	for(uint32_t t = 0; t < triangleCount; ++t)
+		offsets[t + 1] = offsets[t] + (cuts[t].type == TriangleCut::SPLIT_3 ? 2 : (cuts[t].type == TriangleCut::SPLIT_2 ? 1 : 0));
+	if(offsets[triangleCount] == 0)
+		return;
 
-	// extract triangles
-	uint64_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
-
-	// split triangles intersecting plane
-	uint32_t tIndex = 0;
-	while(!triangles.empty()) {
-		auto t = triangles.front();
-		triangles.pop_front();
-		RawVertex a = t.getRawVertex(0);
-		RawVertex b = t.getRawVertex(1);
-		RawVertex c = t.getRawVertex(2);
-
-		const Geometry::Vec3 va(reinterpret_cast<const float *> (a.getData() + posAttr.getOffset()));
-		const Geometry::Vec3 vb(reinterpret_cast<const float *> (b.getData() + posAttr.getOffset()));
-		const Geometry::Vec3 vc(reinterpret_cast<const float *> (c.getData() + posAttr.getOffset()));
-
-		float pa = plane.planeTest(va);
-		float pb = plane.planeTest(vb);
-		float pc = plane.planeTest(vc);
-
-		if( (pa>=-tolerance && pb>=-tolerance && pc>=-tolerance) || (pa<=tolerance && pb<=tolerance && pc<=tolerance) || (!tIndices.empty() && tIndices.count(tIndex)==0)) {
-			// triangle is completely above/below plane -> keep
-			trianglesOut.push_back(t);
-		} else if (isZero(pa, tolerance) || isZero(pb, tolerance) || isZero(pc, tolerance)){
-			// one point lies on the plane -> split into two triangles
-
-			// reorder vertices s.t. vertex a lies on the plane
-			if(isZero(pb, tolerance)) {
-				std::swap(a, b); std::swap(b, c);
-				std::swap(pa, pb); std::swap(pb, pc);
-			} else if(isZero(pc, tolerance)) {
-				std::swap(a, c); std::swap(b, c);
-				std::swap(pa, pc); std::swap(pb, pc);
+	// vertex arena: copy of the original vertices followed by the interpolated ones
+	MeshVertexData newVertices;
+	newVertices.allocate(vertexCount + offsets[triangleCount], vd);
+	std::copy(vertices.data(), vertices.data() + vertices.dataSize(), newVertices.data());
+	MeshIndexData newIndices;
+	newIndices.allocate((triangleCount + offsets[triangleCount]) * 3);
+
+	const MeshVertexData & source = vertices;
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			uint32_t * out = newIndices.data() + t * 3;
+			const TriangleCut cut = cuts[t];
+			if(cut.type == TriangleCut::KEEP) {
+				std::copy(indices.data() + t * 3, indices.data() + t * 3 + 3, out);
+				continue;
 			}
-
-			float blend = std::abs(pb)/(std::abs(pb) + std::abs(pc));
-			RawVertex d = RawVertex::interpolate(b, c, blend, static_cast<uint32_t>(vertexArray.size()), vd);
-			vertexArray.push_back(d);
-			trianglesOut.push_back(SplitTriangle(a, b, d));
-			trianglesNew.push_back(SplitTriangle(a, d, c));
-		} else {
-			// only one point is above/below plane -> split into three triangles
-
-			// reorder vertices s.t. vertex a is the single point above/below the plane
-			if( (pb>=0 && pa<=0 && pc<=0) || (pb<=0 && pa>=0 && pc>=0) ) { // b above/below plane
-				std::swap(a, b); std::swap(b, c);
-				std::swap(pa, pb); std::swap(pb, pc);
-			} else if((pc>=0 && pa<=0 && pb<=0) || (pc<=0 && pa>=0 && pb>=0)) { // c above/below plane
-				std::swap(a, c); std::swap(b, c);
-				std::swap(pa, pc); std::swap(pb, pc);
+			const uint32_t a = indices[t * 3 + cut.first];
+			const uint32_t b = indices[t * 3 + (cut.first + 1) % 3];
+			const uint32_t c = indices[t * 3 + (cut.first + 2) % 3];
+			const float pa = std::abs(distances[a]), pb = std::abs(distances[b]), pc = std::abs(distances[c]);
+			uint32_t * outNew = newIndices.data() + (triangleCount + offsets[t]) * 3;
+			const uint32_t d = vertexCount + offsets[t];
+			if(cut.type == TriangleCut::SPLIT_2) {
+				// a lies on the plane -> split into two triangles
+				RawVertex::interpolate(newVertices[d], source[b], source[c], pb / (pb + pc), vd);
+				out[0] = a; out[1] = b; out[2] = d;
+				outNew[0] = a; outNew[1] = d; outNew[2] = c;
+			} else {
+				// a is the single point above/below the plane -> split into three triangles
+				const uint32_t d_ab = d;
+				const uint32_t d_ac = d + 1;
+				RawVertex::interpolate(newVertices[d_ab], source[a], source[b], pa / (pa + pb), vd);
+				RawVertex::interpolate(newVertices[d_ac], source[a], source[c], pa / (pa + pc), vd);
+				out[0] = a; out[1] = d_ab; out[2] = d_ac;
+				outNew[0] = d_ab; outNew[1] = b; outNew[2] = c;
+				outNew[3] = d_ab; outNew[4] = c; outNew[5] = d_ac;
 			}
-
-			float blend_ab = std::abs(pa)/(std::abs(pa) + std::abs(pb));
-			float blend_ac = std::abs(pa)/(std::abs(pa) + std::abs(pc));
-			RawVertex d_ab = RawVertex::interpolate(a, b, blend_ab, static_cast<uint32_t>(vertexArray.size()), vd);
-			vertexArray.push_back(d_ab);
-			RawVertex d_ac = RawVertex::interpolate(a, c, blend_ac, static_cast<uint32_t>(vertexArray.size()), vd);
-			vertexArray.push_back(d_ac);
-
-			trianglesOut.push_back(SplitTriangle(a, d_ab, d_ac));
-			trianglesNew.push_back(SplitTriangle(d_ab, b, c));
-			trianglesNew.push_back(SplitTriangle(d_ab, c, d_ac));
 		}
-		++tIndex;
-	}
-	for(auto t : trianglesNew)
-		trianglesOut.push_back(t);
-	trianglesNew.clear();
-
-	// reassemble mesh
-	// - indices
-	uint32_t iCount = static_cast<uint32_t>(trianglesOut.size() * 3);
-	indices.allocate(iCount);
-	for (uint32_t i = 0; i < iCount; i += 3) {
-		SplitTriangle t = trianglesOut.front();
-		trianglesOut.pop_front();
-		indices[i + 0] = t.a.getIndex();
-		indices[i + 1] = t.b.getIndex();
-		indices[i + 2] = t.c.getIndex();
-	}
-	indices.updateIndexRange();
+	});
 
-	// - vertices
-	vertices.allocate(static_cast<uint32_t>(vertexArray.size()), vd);
-	for (uint32_t i = 0; i < static_cast<uint32_t>(vertexArray.size()); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
+	vertices.swap(newVertices);
+	vertices.markAsChanged();
 	vertices.updateBoundingBox();
+	newIndices.updateIndexRange();
+	indices.swap(newIndices);
+	indices.markAsChanged();
+}
 
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
+//!	(static)
+std::vector<Geometry::Vec3> getMeshSection(Mesh* m, const Geometry::Plane& plane, const std::vector<bool> & selection, float tolerance) {
+	std::vector<Geometry::Vec3> segments;
+	const VertexAttribute & posAttr = m->getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	if (posAttr.getDataType() != Util::TypeConstant::FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("getMeshSection: Unsupported vertex format.");
+		return segments;
 	}
-}
+	static const uint32_t GRAIN_SIZE = 1 << 12;
 
-// -----------------------------------------------------------------------------
+	const MeshVertexData & vertices = m->openVertexData();
+	const MeshIndexData & indices = m->openIndexData();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
 
-#define ADJ_AB 1
-#define ADJ_BC 2
-#define ADJ_CA 4
+	std::vector<float> distances;
+	std::vector<TriangleCut> cuts;
+	classifyPlaneCut(vertices, indices, plane, selection, tolerance, distances, cuts);
 
-inline
-uint8_t getAdjacence(const SplitTriangle& t1, const SplitTriangle& t2, const VertexAttribute & posAttr) {
-	const static float EPS = std::numeric_limits<float>::epsilon()*10;
-	const Geometry::Vec3 va1(reinterpret_cast<const float *> (t1.a.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vb1(reinterpret_cast<const float *> (t1.b.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vc1(reinterpret_cast<const float *> (t1.c.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 va2(reinterpret_cast<const float *> (t2.a.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vb2(reinterpret_cast<const float *> (t2.b.getData() + posAttr.getOffset()));
-	const Geometry::Vec3 vc2(reinterpret_cast<const float *> (t2.c.getData() + posAttr.getOffset()));
-
-	bool eq_a = va1.equals(va2, EPS) || va1.equals(vb2, EPS) || va1.equals(vc2, EPS);
-	bool eq_b = vb1.equals(va2, EPS) || vb1.equals(vb2, EPS) || vb1.equals(vc2, EPS);
-	bool eq_c = vc1.equals(va2, EPS) || vc1.equals(vb2, EPS) || vc1.equals(vc2, EPS);
-
-	//std::cout << eq_a << "; " << eq_b << "; " << eq_c << std::endl;
-	//std::cout << va1 << "; " << vb1 << "; " << vc1 << std::endl;
-	//std::cout << va2 << "; " << vb2 << "; " << vc2 << std::endl;
-
-	if(eq_a && eq_b)
-		return ADJ_AB;
-	if(eq_b && eq_c)
-		return ADJ_BC;
-	if(eq_c && eq_a)
-		return ADJ_CA;
-	return 0;
+	// every cut triangle contributes one segment
+	std::vector<uint32_t> segmentOffsets(triangleCount + 1, 0);
+	for(uint32_t t = 0; t < triangleCount; ++t)
+		segmentOffsets[t + 1] = segmentOffsets[t] + (cuts[t].type == TriangleCut::KEEP ? 0 : 1);
+	segments.resize(segmentOffsets[triangleCount] * 2);
+
+	const auto position = [&](uint32_t v) {
+		return Geometry::Vec3(reinterpret_cast<const float *>(vertices[v] + posAttr.getOffset()));
+	};
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			const TriangleCut cut = cuts[t];
+			if(cut.type == TriangleCut::KEEP)
+				continue;
+			const uint32_t a = indices[t * 3 + cut.first];
+			const uint32_t b = indices[t * 3 + (cut.first + 1) % 3];
+			const uint32_t c = indices[t * 3 + (cut.first + 2) % 3];
+			const float pa = std::abs(distances[a]), pb = std::abs(distances[b]), pc = std::abs(distances[c]);
+			Geometry::Vec3 * out = segments.data() + segmentOffsets[t] * 2;
+			if(cut.type == TriangleCut::SPLIT_2) {
+				out[0] = position(a);
+				out[1] = position(b) + (position(c) - position(b)) * (pb / (pb + pc));
+			} else {
+				out[0] = position(a) + (position(b) - position(a)) * (pa / (pa + pb));
+				out[1] = position(a) + (position(c) - position(a)) * (pa / (pa + pc));
+			}
+		}
+	});
+	return segments;
 }
 
 // -----------------------------------------------------------------------------
 
 //!	(static)
 void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_t> tIndices) {
+	if(tIndices.empty())
+		return;
+	extrudeTriangleSelection(m, dir, createTriangleSelection(tIndices, m->openIndexData().getIndexCount() / 3));
+}
+
+//!	(static)
+void extrudeTriangleSelection(Mesh* m, const Geometry::Vec3& dir, const std::vector<bool> & selection) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
 	if (posAttr.getDataType() != Util::TypeConstant::FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("extrudeTriangles: Unsupported vertex format.");
 		return;
 	}
-
-	std::vector<SplitTriangle> triangles;
-	std::vector<RawVertex> vertexArray;
+	static const uint32_t GRAIN_SIZE = 1 << 12;
 
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
 
-	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
-
-
-	// find adjacent triangles
-	std::unordered_map<uint32_t, uint8_t> adjacencies;
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
-		adjacencies[ti] = 0;
-		for(auto tj : tIndices) {
-			if(tj >= triangles.size() || ti == tj)
-				continue;
-			uint8_t adj = getAdjacence(triangles[ti], triangles[tj], posAttr);
-			adjacencies[ti] |= adj;
-			//std::cout << ti << "-" << tj << " ab " << ((adj&ADJ_AB)>0) << " bc " << ((adj&ADJ_BC)>0) << " ca " << ((adj&ADJ_CA)>0) << std::endl;
-		}
+	// selected triangles in ascending order
+	std::vector<uint32_t> selected;
+	for(uint32_t t = 0; t < triangleCount && t < selection.size(); ++t) {
+		if(selection[t])
+			selected.push_back(t);
 	}
+	const uint32_t selectedCount = static_cast<uint32_t>(selected.size());
+	if(selectedCount == 0)
+		return;
 
-	// extrude triangles
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
-		RawVertex a = triangles[ti].a;
-		RawVertex b = triangles[ti].b;
-		RawVertex c = triangles[ti].c;
-
-		RawVertex an = RawVertex::move(a, dir, static_cast<uint32_t>(vertexArray.size()), vd);
-		vertexArray.push_back(an);
-		RawVertex bn = RawVertex::move(b, dir, static_cast<uint32_t>(vertexArray.size()), vd);
-		vertexArray.push_back(bn);
-		RawVertex cn = RawVertex::move(c, dir, static_cast<uint32_t>(vertexArray.size()), vd);
-		vertexArray.push_back(cn);
-		triangles[ti].a = an;
-		triangles[ti].b = bn;
-		triangles[ti].c = cn;
-
-		// add new triangles
-		uint8_t adj = adjacencies[ti];
-
-		if( (adj & ADJ_CA) == 0) {
-			triangles.push_back(SplitTriangle(a, an, cn));
-			triangles.push_back(SplitTriangle(a, cn, c));
+	/* number the corner positions of the selected triangles: positions that are equal up to EPS are merged.
+	   The corners are sorted into a grid with cell size EPS, so equal positions lie in neighboring cells. */
+	const static float EPS = std::numeric_limits<float>::epsilon()*10;
+	const uint32_t cornerCount = selectedCount * 3;
+	using Cell = std::array<int64_t, 3>;
+	const auto getCellCoordinate = [](float f) {
+		return static_cast<int64_t>(std::max(-4.0e18, std::min(4.0e18, std::floor(static_cast<double>(f) / EPS))));
+	};
+	std::vector<Geometry::Vec3> cornerVecs(cornerCount);
+	std::vector<std::pair<Cell, uint32_t>> cornerCells(cornerCount);
+	Parallel::forRange(0, selectedCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s) {
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				const uint32_t c = s * 3 + i;
+				cornerVecs[c] = Geometry::Vec3(reinterpret_cast<const float *>(vertices[indices[selected[s] * 3 + i]] + posAttr.getOffset()));
+				cornerCells[c] = {{getCellCoordinate(cornerVecs[c].x()), getCellCoordinate(cornerVecs[c].y()), getCellCoordinate(cornerVecs[c].z())}, c};
+			}
 		}
-
-		if( (adj & ADJ_AB) == 0) {
-			triangles.push_back(SplitTriangle(b, bn, an));
-			triangles.push_back(SplitTriangle(b, an, a));
+	});
+	std::sort(cornerCells.begin(), cornerCells.end());
+
+	// union-find over the corners; the root of a corner identifies its position
+	std::vector<uint32_t> cornerPositions(cornerCount);
+	for(uint32_t c = 0; c < cornerCount; ++c)
+		cornerPositions[c] = c;
+	const auto findPosition = [&](uint32_t c) {
+		while(cornerPositions[c] != c)
+			c = cornerPositions[c] = cornerPositions[cornerPositions[c]];
+		return c;
+	};
+	const auto compareCells = [](const std::pair<Cell, uint32_t> & a, const std::pair<Cell, uint32_t> & b) { return a.first < b.first; };
+	for(const auto & corner : cornerCells) {
+		for(int64_t dx = -1; dx <= 1; ++dx) {
+			for(int64_t dy = -1; dy <= 1; ++dy) {
+				for(int64_t dz = -1; dz <= 1; ++dz) {
+					const std::pair<Cell, uint32_t> key{{corner.first[0] + dx, corner.first[1] + dy, corner.first[2] + dz}, 0};
+					const auto range = std::equal_range(cornerCells.begin(), cornerCells.end(), key, compareCells);
+					for(auto it = range.first; it != range.second; ++it) {
+						if(it->second > corner.second && cornerVecs[corner.second].equals(cornerVecs[it->second], EPS)) {
+							const uint32_t p0 = findPosition(corner.second), p1 = findPosition(it->second);
+							if(p0 != p1)
+								cornerPositions[std::max(p0, p1)] = std::min(p0, p1);
+						}
+					}
+				}
+			}
 		}
+	}
+	for(uint32_t c = 0; c < cornerCount; ++c)
+		cornerPositions[c] = findPosition(c);
 
-		if( (adj & ADJ_BC) == 0) {
-			triangles.push_back(SplitTriangle(c, cn, bn));
-			triangles.push_back(SplitTriangle(c, bn, b));
+	// edges of the selected triangles as sorted position pairs; an edge occurring twice is an inner edge
+	enum : uint8_t { ADJ_AB = 1, ADJ_BC = 2, ADJ_CA = 4 };
+	const auto edgeKey = [&](uint32_t c0, uint32_t c1) {
+		const uint64_t p0 = cornerPositions[c0], p1 = cornerPositions[c1];
+		return p0 < p1 ? (p0 << 32) | p1 : (p1 << 32) | p0;
+	};
+	std::vector<uint64_t> edges(selectedCount * 3);
+	for(uint32_t s = 0; s < selectedCount; ++s) {
+		for(uint_fast8_t i = 0; i < 3; ++i)
+			edges[s * 3 + i] = edgeKey(s * 3 + i, s * 3 + (i + 1) % 3);
+	}
+	std::sort(edges.begin(), edges.end());
+	std::vector<uint8_t> adjacencies(selectedCount, 0);
+	std::vector<uint32_t> sideTriangleOffsets(selectedCount + 1, 0);
+	Parallel::forRange(0, selectedCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s) {
+			uint8_t adj = 0;
+			uint32_t sideCount = 0;
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				const auto range = std::equal_range(edges.begin(), edges.end(), edgeKey(s * 3 + i, s * 3 + (i + 1) % 3));
+				if(range.second - range.first > 1)
+					adj |= (1 << i);
+				else
+					sideCount += 2;
+			}
+			adjacencies[s] = adj;
+			sideTriangleOffsets[s + 1] = sideCount;
 		}
-	}
+	});
+	for(uint32_t s = 0; s < selectedCount; ++s)
+		sideTriangleOffsets[s + 1] += sideTriangleOffsets[s];
+
+	// vertex arena: copy of the original vertices followed by three moved vertices per selected triangle
+	MeshVertexData newVertices;
+	newVertices.allocate(vertexCount + selectedCount * 3, vd);
+	std::copy(vertices.data(), vertices.data() + vertices.dataSize(), newVertices.data());
+	MeshIndexData newIndices;
+	newIndices.allocate((triangleCount + sideTriangleOffsets[selectedCount]) * 3);
+	std::copy(indices.data(), indices.data() + triangleCount * 3, newIndices.data());
+
+	const size_t vertexSize = vd.getVertexSize();
+	Parallel::forRange(0, selectedCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t s = begin; s < end; ++s) {
+			const uint32_t t = selected[s];
+			const uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+			const uint32_t an = vertexCount + s * 3, bn = an + 1, cn = an + 2;
+			std::copy(vertices[a], vertices[a] + vertexSize, newVertices[an]);
+			std::copy(vertices[b], vertices[b] + vertexSize, newVertices[bn]);
+			std::copy(vertices[c], vertices[c] + vertexSize, newVertices[cn]);
+			for(const uint32_t v : {an, bn, cn}) {
+				float * pos = reinterpret_cast<float *>(newVertices[v] + posAttr.getOffset());
+				pos[0] += dir.x();
+				pos[1] += dir.y();
+				pos[2] += dir.z();
+			}
 
-	// reassemble mesh
-	// - indices
-	{
-		indices.allocate(static_cast<uint32_t>(triangles.size()) * 3);
-		uint32_t i=0;
-		for (auto t : triangles) {
-			indices[i++] = t.a.getIndex();
-			indices[i++] = t.b.getIndex();
-			indices[i++] = t.c.getIndex();
+			// move the triangle and add the side triangles of its border edges
+			uint32_t * out = newIndices.data() + t * 3;
+			out[0] = an; out[1] = bn; out[2] = cn;
+			out = newIndices.data() + (triangleCount + sideTriangleOffsets[s]) * 3;
+			const uint8_t adj = adjacencies[s];
+			if( (adj & ADJ_CA) == 0) {
+				*out++ = a; *out++ = an; *out++ = cn;
+				*out++ = a; *out++ = cn; *out++ = c;
+			}
+			if( (adj & ADJ_AB) == 0) {
+				*out++ = b; *out++ = bn; *out++ = an;
+				*out++ = b; *out++ = an; *out++ = a;
+			}
+			if( (adj & ADJ_BC) == 0) {
+				*out++ = c; *out++ = cn; *out++ = bn;
+				*out++ = c; *out++ = bn; *out++ = b;
+			}
 		}
-		indices.updateIndexRange();
-	}
+	});
 
-	// - vertices
-	vertices.allocate(static_cast<uint32_t>(vertexArray.size()), vd);
-	for (uint32_t i = 0; i < static_cast<uint32_t>(vertexArray.size()); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
+	vertices.swap(newVertices);
+	vertices.markAsChanged();
 	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	newIndices.updateIndexRange();
+	indices.swap(newIndices);
+	indices.markAsChanged();
 }
 
 //!	(static)
@@ -2192,6 +2447,411 @@ std::deque<Mesh*> splitIntoConnectedComponents(Mesh* mesh, float relDistance/*=0
 	return result;
 }
 
+//! Disjoint-set forest with path halving and union by size.
+class UnionFind {
+	std::vector<uint32_t> parent;
+	std::vector<uint32_t> size;
+public:
+	explicit UnionFind(uint32_t count) : parent(count), size(count, 1) {
+		for(uint32_t i = 0; i < count; ++i)
+			parent[i] = i;
+	}
+	uint32_t find(uint32_t i) {
+		while(parent[i] != i) {
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	}
+	void unite(uint32_t a, uint32_t b) {
+		a = find(a);
+		b = find(b);
+		if(a == b)
+			return;
+		if(size[a] < size[b])
+			std::swap(a, b);
+		parent[b] = a;
+		size[a] += size[b];
+	}
+};
+
+//! Unite all vertices whose positions are closer than (or equal to) the given distance using a hash grid.
+static void weldVertexPositions(MeshVertexData & vertexData, float weldDistance, UnionFind & sets) {
+	auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+	const uint32_t vertexCount = vertexData.getVertexCount();
+
+	if(weldDistance == 0.0f) {
+		// exact welding: vertices with bitwise identical positions
+		struct PositionHash {
+			size_t operator()(const std::array<uint32_t, 3> & p) const {
+				return (static_cast<size_t>(p[0]) * 73856093u) ^ (static_cast<size_t>(p[1]) * 19349663u) ^ (static_cast<size_t>(p[2]) * 83492791u);
+			}
+		};
+		std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> positions;
+		positions.reserve(vertexCount);
+		for(uint32_t v = 0; v < vertexCount; ++v) {
+			const Geometry::Vec3 pos = posAcc->getPosition(v);
+			std::array<uint32_t, 3> key;
+			const float coords[3] = {pos.x() + 0.0f, pos.y() + 0.0f, pos.z() + 0.0f}; // + 0.0f maps -0 to +0
+			std::memcpy(key.data(), coords, sizeof(coords));
+			auto it = positions.emplace(key, v);
+			if(!it.second)
+				sets.unite(it.first->second, v);
+		}
+		return;
+	}
+
+	// epsilon welding: the cell size equals the weld distance, so only the 27 surrounding cells have to be checked.
+	const float invCellSize = 1.0f / weldDistance;
+	const float weldDistanceSquared = weldDistance * weldDistance;
+	const auto getCell = [invCellSize](float c) {
+		return static_cast<int32_t>(std::floor(c * invCellSize));
+	};
+	const auto getCellKey = [](int32_t x, int32_t y, int32_t z) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x) & 0x1fffff) << 42) |
+				(static_cast<uint64_t>(static_cast<uint32_t>(y) & 0x1fffff) << 21) |
+				(static_cast<uint64_t>(static_cast<uint32_t>(z) & 0x1fffff));
+	};
+	std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+	grid.reserve(vertexCount);
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		const Geometry::Vec3 pos = posAcc->getPosition(v);
+		const int32_t cx = getCell(pos.x()), cy = getCell(pos.y()), cz = getCell(pos.z());
+		for(int32_t dz = -1; dz <= 1; ++dz) {
+			for(int32_t dy = -1; dy <= 1; ++dy) {
+				for(int32_t dx = -1; dx <= 1; ++dx) {
+					const auto it = grid.find(getCellKey(cx + dx, cy + dy, cz + dz));
+					if(it == grid.end())
+						continue;
+					for(const uint32_t other : it->second) {
+						if(posAcc->getPosition(other).distanceSquared(pos) <= weldDistanceSquared)
+							sets.unite(other, v);
+					}
+				}
+			}
+		}
+		grid[getCellKey(cx, cy, cz)].push_back(v);
+	}
+}
+
+std::deque<Mesh*> splitIntoConnectedComponentsByTopology(Mesh* mesh, float weldDistance/*=0.0*/) {
+	std::deque<Mesh*> result;
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("Mesh is not a triangle mesh.");
+		return result;
+	}
+	if(!mesh->isUsingIndexData()) {
+		WARN("splitIntoConnectedComponentsByTopology: Mesh has no index data.");
+		return result;
+	}
+
+	const VertexDescription & desc = mesh->getVertexDescription();
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	const uint32_t triangleCount = indexData.getIndexCount() / 3;
+	const uint32_t * indices = indexData.data();
+	// all per-vertex arrays below are addressed by the indices, so they are validated once
+	if(std::any_of(indices, indices + triangleCount * 3, [vertexCount](uint32_t index) { return index >= vertexCount; })) {
+		WARN("splitIntoConnectedComponentsByTopology: Index out of range.");
+		return result;
+	}
+
+	// 1. union-find over the shared (and optionally welded) vertices
+	UnionFind sets(vertexCount);
+	if(weldDistance >= 0.0f)
+		weldVertexPositions(vertexData, weldDistance, sets);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		sets.unite(indices[t * 3], indices[t * 3 + 1]);
+		sets.unite(indices[t * 3], indices[t * 3 + 2]);
+	}
+
+	// 2. number the components in order of their first triangle and count their triangles
+	static const uint32_t NONE = 0xffffffff;
+	std::vector<uint32_t> rootToComponent(vertexCount, NONE);
+	std::vector<uint32_t> triangleComponent(triangleCount);
+	std::vector<uint32_t> componentIndexCount;
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		uint32_t & component = rootToComponent[sets.find(indices[t * 3])];
+		if(component == NONE) {
+			component = static_cast<uint32_t>(componentIndexCount.size());
+			componentIndexCount.push_back(0);
+		}
+		triangleComponent[t] = component;
+		componentIndexCount[component] += 3;
+	}
+
+	// 3. assign the new vertex indices (only vertices used by a triangle are kept)
+	std::vector<uint32_t> newVertexIndex(vertexCount, NONE);
+	std::vector<uint32_t> componentVertexCount(componentIndexCount.size(), 0);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		for(uint_fast8_t i = 0; i < 3; ++i) {
+			const uint32_t v = indices[t * 3 + i];
+			if(newVertexIndex[v] == NONE)
+				newVertexIndex[v] = componentVertexCount[triangleComponent[t]]++;
+		}
+	}
+
+	// 4. scatter the vertices and indices into the component meshes in one linear pass
+	std::vector<Mesh*> components(componentIndexCount.size());
+	std::vector<uint8_t*> componentVertices(components.size());
+	std::vector<uint32_t*> componentIndices(components.size());
+	for(uint32_t c = 0; c < components.size(); ++c) {
+		components[c] = new Mesh(desc, componentVertexCount[c], componentIndexCount[c]);
+		components[c]->setDataStrategy(mesh->getDataStrategy());
+		componentVertices[c] = components[c]->openVertexData().data();
+		componentIndices[c] = components[c]->openIndexData().data();
+	}
+	const size_t vertexSize = desc.getVertexSize();
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		if(newVertexIndex[v] != NONE) {
+			const uint32_t c = rootToComponent[sets.find(v)];
+			std::copy(vertexData[v], vertexData[v] + vertexSize, componentVertices[c] + newVertexIndex[v] * vertexSize);
+		}
+	}
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		uint32_t *& target = componentIndices[triangleComponent[t]];
+		*(target++) = newVertexIndex[indices[t * 3]];
+		*(target++) = newVertexIndex[indices[t * 3 + 1]];
+		*(target++) = newVertexIndex[indices[t * 3 + 2]];
+	}
+
+	for(auto component : components) {
+		component->openVertexData().updateBoundingBox();
+		component->openIndexData().updateIndexRange();
+		result.push_back(component);
+	}
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+
+//! Axis-aligned bounds used by splitIntoSpatialChunks()
+struct ChunkBounds {
+	float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	float max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+	bool isEmpty() const { return min[0] > max[0]; }
+	float getExtent(uint_fast8_t axis) const { return isEmpty() ? 0.0f : max[axis] - min[axis]; }
+	float getMaxExtent() const { return std::max(getExtent(0), std::max(getExtent(1), getExtent(2))); }
+	//! Half of the surface area
+	float getArea() const { return getExtent(0) * getExtent(1) + getExtent(1) * getExtent(2) + getExtent(2) * getExtent(0); }
+	void include(const Geometry::Vec3 & p) {
+		for(uint_fast8_t i = 0; i < 3; ++i) {
+			min[i] = std::min(min[i], p[i]);
+			max[i] = std::max(max[i], p[i]);
+		}
+	}
+	void include(const ChunkBounds & other) {
+		for(uint_fast8_t i = 0; i < 3; ++i) {
+			min[i] = std::min(min[i], other.min[i]);
+			max[i] = std::max(max[i], other.max[i]);
+		}
+	}
+};
+
+std::deque<Mesh*> splitIntoSpatialChunks(Mesh* mesh, uint32_t maxTriangles, float maxExtent/*=0.0*/) {
+	std::deque<Mesh*> result;
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("Mesh is not a triangle mesh.");
+		return result;
+	}
+	if(!mesh->isUsingIndexData()) {
+		WARN("splitIntoSpatialChunks: Mesh has no index data.");
+		return result;
+	}
+	if(maxTriangles == 0) {
+		WARN("splitIntoSpatialChunks: maxTriangles has to be greater than zero.");
+		return result;
+	}
+	static const uint32_t GRAIN_SIZE = 1 << 12;
+	static const uint32_t BIN_COUNT = 16;
+
+	const VertexDescription & desc = mesh->getVertexDescription();
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	const uint32_t triangleCount = indexData.getIndexCount() / 3;
+	const uint32_t * indices = indexData.data();
+	if(triangleCount == 0)
+		return result;
+
+	// 1. bounds and centroids of the triangles
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	{
+		auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+		Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+			for(uint32_t v = begin; v < end; ++v)
+				positions[v] = posAcc->getPosition(v);
+		});
+	}
+	std::vector<ChunkBounds> triangleBounds(triangleCount);
+	std::vector<Geometry::Vec3> centroids(triangleCount);
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			const Geometry::Vec3 & a = positions[indices[t * 3]];
+			const Geometry::Vec3 & b = positions[indices[t * 3 + 1]];
+			const Geometry::Vec3 & c = positions[indices[t * 3 + 2]];
+			triangleBounds[t].include(a);
+			triangleBounds[t].include(b);
+			triangleBounds[t].include(c);
+			centroids[t] = (a + b + c) / 3.0f;
+		}
+	});
+
+	// 2. recursively partition the triangle order using binned SAH splits; the ranges of the leaves become the chunks
+	struct Bin {
+		ChunkBounds bounds;
+		uint32_t count = 0;
+	};
+	std::vector<uint32_t> order(triangleCount);
+	for(uint32_t t = 0; t < triangleCount; ++t)
+		order[t] = t;
+	std::vector<std::pair<uint32_t, uint32_t>> leaves;
+	std::vector<std::pair<uint32_t, uint32_t>> stack;
+	stack.emplace_back(0, triangleCount);
+	while(!stack.empty()) {
+		const uint32_t begin = stack.back().first;
+		const uint32_t end = stack.back().second;
+		stack.pop_back();
+		const uint32_t count = end - begin;
+		const uint32_t chunkCount = (count + GRAIN_SIZE - 1) / GRAIN_SIZE;
+
+		// bounds of the triangles and of their centroids
+		std::vector<ChunkBounds> partialBounds(chunkCount * 2);
+		Parallel::forRange(begin, end, GRAIN_SIZE, [&](uint32_t chunkBegin, uint32_t chunkEnd) {
+			ChunkBounds * bounds = partialBounds.data() + (chunkBegin - begin) / GRAIN_SIZE * 2;
+			for(uint32_t i = chunkBegin; i < chunkEnd; ++i) {
+				bounds[0].include(triangleBounds[order[i]]);
+				bounds[1].include(centroids[order[i]]);
+			}
+		});
+		ChunkBounds nodeBounds, centroidBounds;
+		for(uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+			nodeBounds.include(partialBounds[chunk * 2]);
+			centroidBounds.include(partialBounds[chunk * 2 + 1]);
+		}
+		if(count == 1 || (count <= maxTriangles && (maxExtent <= 0.0f || nodeBounds.getMaxExtent() <= maxExtent))) {
+			leaves.emplace_back(begin, end);
+			continue;
+		}
+
+		// classify the triangles into bins along each axis
+		float binScale[3];
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			const float extent = centroidBounds.getExtent(axis);
+			binScale[axis] = extent > 0.0f ? BIN_COUNT / extent : 0.0f;
+		}
+		const auto getBin = [&](uint32_t t, uint_fast8_t axis) {
+			const auto bin = static_cast<uint32_t>((centroids[t][axis] - centroidBounds.min[axis]) * binScale[axis]);
+			return std::min(bin, BIN_COUNT - 1);
+		};
+		std::vector<Bin> partialBins(chunkCount * 3 * BIN_COUNT);
+		Parallel::forRange(begin, end, GRAIN_SIZE, [&](uint32_t chunkBegin, uint32_t chunkEnd) {
+			Bin * bins = partialBins.data() + (chunkBegin - begin) / GRAIN_SIZE * 3 * BIN_COUNT;
+			for(uint32_t i = chunkBegin; i < chunkEnd; ++i) {
+				for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+					Bin & bin = bins[axis * BIN_COUNT + getBin(order[i], axis)];
+					bin.bounds.include(triangleBounds[order[i]]);
+					++bin.count;
+				}
+			}
+		});
+		std::vector<Bin> bins(3 * BIN_COUNT);
+		for(uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+			for(uint32_t b = 0; b < 3 * BIN_COUNT; ++b) {
+				bins[b].bounds.include(partialBins[chunk * 3 * BIN_COUNT + b].bounds);
+				bins[b].count += partialBins[chunk * 3 * BIN_COUNT + b].count;
+			}
+		}
+
+		// find the split with the lowest surface area heuristic cost
+		float bestCost = std::numeric_limits<float>::max();
+		uint_fast8_t bestAxis = 0;
+		uint32_t bestSplit = 0;
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			if(binScale[axis] == 0.0f)
+				continue;
+			const Bin * axisBins = bins.data() + axis * BIN_COUNT;
+			float rightCosts[BIN_COUNT];
+			ChunkBounds right;
+			uint32_t rightCount = 0;
+			for(uint32_t b = BIN_COUNT - 1; b > 0; --b) {
+				right.include(axisBins[b].bounds);
+				rightCount += axisBins[b].count;
+				rightCosts[b] = rightCount > 0 ? right.getArea() * rightCount : -1.0f;
+			}
+			ChunkBounds left;
+			uint32_t leftCount = 0;
+			for(uint32_t split = 1; split < BIN_COUNT; ++split) {
+				left.include(axisBins[split - 1].bounds);
+				leftCount += axisBins[split - 1].count;
+				if(leftCount == 0 || rightCosts[split] < 0.0f)
+					continue;
+				const float cost = left.getArea() * leftCount + rightCosts[split];
+				if(cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		uint32_t middle;
+		if(bestSplit > 0) {
+			middle = static_cast<uint32_t>(std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t t) {
+				return getBin(t, bestAxis) < bestSplit;
+			}) - order.begin());
+		} else {
+			// all centroids coincide: split by count
+			middle = begin + count / 2;
+		}
+		// process the lower half first to keep the chunks in spatial order
+		stack.emplace_back(middle, end);
+		stack.emplace_back(begin, middle);
+	}
+
+	// 3. collect the (sorted) vertices of each chunk
+	const uint32_t leafCount = static_cast<uint32_t>(leaves.size());
+	std::vector<std::vector<uint32_t>> leafVertices(leafCount);
+	Parallel::forEach(0, leafCount, [&](uint32_t l) {
+		std::vector<uint32_t> & vertices = leafVertices[l];
+		vertices.reserve((leaves[l].second - leaves[l].first) * 3);
+		for(uint32_t i = leaves[l].first; i < leaves[l].second; ++i) {
+			for(uint_fast8_t c = 0; c < 3; ++c)
+				vertices.push_back(indices[order[i] * 3 + c]);
+		}
+		std::sort(vertices.begin(), vertices.end());
+		vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+	});
+
+	// 4. create the chunks and fill them in parallel
+	std::vector<MeshVertexData*> chunkVertices(leafCount);
+	std::vector<MeshIndexData*> chunkIndices(leafCount);
+	for(uint32_t l = 0; l < leafCount; ++l) {
+		auto chunk = new Mesh(desc, static_cast<uint32_t>(leafVertices[l].size()), (leaves[l].second - leaves[l].first) * 3);
+		chunk->setDataStrategy(mesh->getDataStrategy());
+		chunkVertices[l] = &chunk->openVertexData();
+		chunkIndices[l] = &chunk->openIndexData();
+		result.push_back(chunk);
+	}
+	const size_t vertexSize = desc.getVertexSize();
+	Parallel::forEach(0, leafCount, [&](uint32_t l) {
+		const std::vector<uint32_t> & vertices = leafVertices[l];
+		MeshVertexData & targetVertices = *chunkVertices[l];
+		for(uint32_t v = 0; v < vertices.size(); ++v)
+			std::copy(vertexData[vertices[v]], vertexData[vertices[v]] + vertexSize, targetVertices[v]);
+		uint32_t * target = chunkIndices[l]->data();
+		for(uint32_t i = leaves[l].first; i < leaves[l].second; ++i) {
+			for(uint_fast8_t c = 0; c < 3; ++c)
+				*(target++) = static_cast<uint32_t>(std::lower_bound(vertices.begin(), vertices.end(), indices[order[i] * 3 + c]) - vertices.begin());
+		}
+		targetVertices.updateBoundingBox();
+		chunkIndices[l]->updateIndexRange();
+	});
+	return result;
+}
+
 // -----------------------------------------------------------------------------
 
 void applyDisplacementMap(Mesh* mesh, Util::PixelAccessor* displaceAcc, float scale, bool clampToEdge) {
@@ -12,6 +12,7 @@
 #define MESHUTILS_H
 
 #include <Geometry/Matrix4x4.h>
+#include <Util/TypeConstant.h>
 
 #include <cstdint>
 #include <deque>
@@ -86,12 +87,23 @@ RENDERINGAPI void calculateNormals(Mesh * m);
 
 /**
  * Calculate and add tangent space vectors from the normals and uv-coordinates of the given mesh.
- * \note based on: Lengyel, Eric. "Computing Tangent Space Basis Vectors for an Arbitrary Mesh".
- * Terathon Software 3D Graphics Library, 2001. http://www.terathon.com/code/tangent.html
+ * The tangents are compatible with MikkTSpace (http://www.mikktspace.com): for each corner, the tangent
+ * of its triangle is projected into the tangent plane of the vertex normal and weighted by the angle of
+ * the corner. Corners of mirrored and non-mirrored triangles (w.r.t. texture space) do not share a
+ * tangent; vertices used by both are split.
+ * Positions, normals and texture coordinates may have any type; the tangent computation runs in parallel.
  * The bitangent can be calculated in the shader by:
  * float3 bitangent = cross(normal, tangent.xyz) * tangent.w;
+ * \note Contrary to MikkTSpace, triangles are only grouped by their orientation around each vertex index
+ *   and not by their connectivity.
+ * @param tangentType Type of the tangent attribute if it has to be created: INT8 (normalized, 4 bytes),
+ *   INT16 (normalized, 8 bytes) or FLOAT.
  */
 RENDERINGAPI void calculateTangentVectors(	Mesh * mesh, const Util::StringIdentifier uvName,
+const Util::StringIdentifier tangentVecName, Util::TypeConstant tangentType);
+
+//! Calculate tangent space vectors stored as four normalized bytes. \see calculateTangentVectors(Mesh*, Util::StringIdentifier, Util::StringIdentifier, Util::TypeConstant)
+RENDERINGAPI void calculateTangentVectors(	Mesh * mesh, const Util::StringIdentifier uvName,
 const Util::StringIdentifier tangentVecName);
 
 
@@ -109,6 +121,18 @@ RENDERINGAPI void calculateTextureCoordinates_projection( Mesh * mesh, Util::Str
 RENDERINGAPI Mesh * combineMeshes(const std::deque<Mesh *> & meshArray);
 RENDERINGAPI Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geometry::Matrix4x4> & transformations);
 
+/**
+ * Combine several meshes into a single mesh.
+ * The layout of the resulting mesh is computed first; afterwards, the meshes are copied (and
+ * transformed by the corresponding matrix, if given) in parallel.
+ * Meshes without a corresponding transformation, or with an identity transformation, are copied unchanged.
+ *
+ * @param meshArray Pointer to @p meshCount meshes. All meshes must have the same VertexDescription.
+ * @param transformations Pointer to @p transformationCount transformation matrices (may be nullptr).
+ */
+RENDERINGAPI Mesh * combineMeshes(Mesh * const * meshArray, size_t meshCount, const Geometry::Matrix4x4 * transformations, size_t transformationCount);
+RENDERINGAPI Mesh * combineMeshes(const std::vector<Mesh *> & meshes, const std::vector<Geometry::Matrix4x4> & transformations = {});
+
 /**
  * Splits the vertex data of a given mesh into multiple blocks of vertex data each containing @a chunkSize many vertices.
  *
@@ -311,6 +335,31 @@ RENDERINGAPI VertexDescription uniteVertexDescriptions(const std::deque<VertexDe
  */
 RENDERINGAPI void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices={}, float tolerance=std::numeric_limits<float>::epsilon());
 
+/**
+ * Cuts the selected triangles of the given mesh along the given plane.
+ * The vertex distances are calculated and the triangles are classified in parallel; the new vertices and
+ * triangles are appended to the mesh data.
+ *
+ * @param m the mesh to be cut
+ * @param plane the cutting plane
+ * @param selection selected triangles (indexed by triangle index). If empty, the whole mesh is cut.
+ * @param tolerance if a vertex lies on the plane with the given tolerance, no new vertex is created
+ */
+RENDERINGAPI void cutMeshSelection(Mesh* m, const Geometry::Plane& plane, const std::vector<bool> & selection, float tolerance=std::numeric_limits<float>::epsilon());
+
+/**
+ * Calculates the intersection of the given mesh with the given plane (e.g. for section views)
+ * using the same classification as cutMeshSelection().
+ * Triangles touching the plane only in a vertex or an edge do not contribute.
+ *
+ * @param m the mesh (with float positions)
+ * @param plane the cutting plane
+ * @param selection selected triangles (indexed by triangle index). If empty, all triangles are used.
+ * @param tolerance if a vertex lies on the plane with the given tolerance, it is used as end point of the segment
+ * @return two end points per intersection segment
+ */
+RENDERINGAPI std::vector<Geometry::Vec3> getMeshSection(Mesh* m, const Geometry::Plane& plane, const std::vector<bool> & selection={}, float tolerance=std::numeric_limits<float>::epsilon());
+
 /**
  * Extrudes the specified triangles of the given mesh.
  *
@@ -321,6 +370,16 @@ RENDERINGAPI void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<
  */
 RENDERINGAPI void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_t> tIndices);
 
+/**
+ * Extrudes the selected triangles of the given mesh.
+ * Edges shared by two selected triangles (with positions equal up to 10*FLT_EPSILON) are inner edges and get no side faces.
+ *
+ * @param m the mesh
+ * @param dir extrusion direction
+ * @param selection selected triangles (indexed by triangle index)
+ */
+RENDERINGAPI void extrudeTriangleSelection(Mesh* m, const Geometry::Vec3& dir, const std::vector<bool> & selection);
+
 /**
  * Slow method for finding the first triangle in a mesh that intersects the given ray.
  * @param m the mesh
@@ -352,6 +411,35 @@ RENDERINGAPI uint32_t mergeCloseVertices(Mesh * mesh, float tolerance=std::numer
  */
 RENDERINGAPI std::deque<Mesh*> splitIntoConnectedComponents(Mesh* mesh, float relDistance=0.001);
 
+/**
+ * Splits a triangle mesh into its connected components using the mesh topology.
+ * Two triangles are connected if they share a vertex index or, if welding is enabled, if they
+ * have vertices at (nearly) the same position. The components are determined by a union-find
+ * over the vertices, positions are welded using a hash grid, and the resulting meshes are filled
+ * in one linear pass over the vertices and triangles. Unused vertices are removed.
+ * This function has an expected runtime of O(n) where n is the number of vertices and indices.
+ *
+ * @param mesh Indexed triangle mesh to split into connected components
+ * @param weldDistance Vertices with a distance <= weldDistance are considered as connected.
+ *        Use 0 for welding bitwise identical positions only and a negative value to disable welding.
+ * @return connected components of the mesh (ordered by their first triangle)
+ */
+RENDERINGAPI std::deque<Mesh*> splitIntoConnectedComponentsByTopology(Mesh* mesh, float weldDistance=0.0f);
+
+/**
+ * Splits a triangle mesh into spatially coherent chunks (e.g. for frustum and occlusion culling).
+ * The triangles are partitioned recursively by binned surface area heuristic splits of their centroids
+ * until a chunk contains at most @p maxTriangles triangles and its extent is at most @p maxExtent.
+ * Each chunk only contains the vertices it uses (with compacted indices) and has a tight bounding box.
+ *
+ * @param mesh Indexed triangle mesh to split
+ * @param maxTriangles Maximum number of triangles per chunk (> 0)
+ * @param maxExtent Maximum side length of the bounding box of a chunk; 0 for no limit.
+ *        A single triangle larger than this is not split.
+ * @return the chunks in the depth-first order of the partitioning (empty for a mesh without triangles)
+ */
+RENDERINGAPI std::deque<Mesh*> splitIntoSpatialChunks(Mesh* mesh, uint32_t maxTriangles, float maxExtent=0.0f);
+
 /**
  * Moves every vertex along their normal according to the given texture (using its u,v coordinates).
  *
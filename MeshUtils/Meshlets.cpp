@@ -0,0 +1,306 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "Meshlets.h"
+#include "internal/Parallel.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+namespace Rendering {
+namespace MeshUtils {
+using Geometry::Vec3;
+
+static_assert(sizeof(Meshlet) == 48, "Meshlet has to be a plain 48 byte structure.");
+
+static const uint32_t MESHLET_HEADER = 0x0d746c6d; // = "mlt\r" (little endian)
+static const uint32_t MESHLET_VERSION = 0x01;
+
+//! Normals of a meshlet have to deviate less than ~84 degrees from the cone axis to allow culling.
+static const float MIN_CONE_DOT = 0.1f;
+
+//! (static)
+MeshletData buildMeshlets(Mesh * mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+	if(maxVertices < 3 || maxVertices > 256 || maxTriangles == 0)
+		INVALID_ARGUMENT_EXCEPTION("buildMeshlets: A meshlet needs 3 to 256 vertices and at least one triangle.");
+	MeshletData result;
+	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES || !mesh->isUsingIndexData()) {
+		WARN("buildMeshlets: Mesh is not an indexed triangle mesh.");
+		return result;
+	}
+	static const uint32_t GRAIN_SIZE = 1 << 12;
+	static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	const uint32_t triangleCount = indexData.getIndexCount() / 3;
+	const uint32_t * indices = indexData.data();
+
+	std::vector<Vec3> positions(vertexCount);
+	{
+		auto posAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+		Parallel::forRange(0, vertexCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+			for(uint32_t v = begin; v < end; ++v)
+				positions[v] = posAcc->getPosition(v);
+		});
+	}
+	std::vector<Vec3> centroids(triangleCount);
+	std::vector<Vec3> triangleNormals(triangleCount);
+	Parallel::forRange(0, triangleCount, GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t t = begin; t < end; ++t) {
+			const Vec3 & a = positions[indices[t * 3]];
+			const Vec3 & b = positions[indices[t * 3 + 1]];
+			const Vec3 & c = positions[indices[t * 3 + 2]];
+			centroids[t] = (a + b + c) / 3.0f;
+			const Vec3 n = (b - a).cross(c - a);
+			const float length = n.length();
+			triangleNormals[t] = length > 0.0f ? n / length : Vec3(0, 0, 0);
+		}
+	});
+
+	// triangles of each vertex (counting sort)
+	std::vector<uint32_t> vertexTriangleOffsets(vertexCount + 1, 0);
+	for(uint32_t i = 0; i < triangleCount * 3; ++i)
+		++vertexTriangleOffsets[indices[i] + 1];
+	for(uint32_t v = 0; v < vertexCount; ++v)
+		vertexTriangleOffsets[v + 1] += vertexTriangleOffsets[v];
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursor(vertexTriangleOffsets.begin(), vertexTriangleOffsets.end() - 1);
+		for(uint32_t i = 0; i < triangleCount * 3; ++i)
+			vertexTriangles[cursor[indices[i]]++] = i / 3;
+	}
+
+	// grow the meshlets greedily along the connectivity
+	result.vertices.reserve(triangleCount);
+	result.triangles.reserve(triangleCount * 3);
+	std::vector<bool> assigned(triangleCount, false);
+	std::vector<uint32_t> localIndex(vertexCount, NONE); // index of a vertex in the current meshlet
+	std::vector<uint32_t> candidateOf(triangleCount, NONE); // meshlet for which a triangle is a candidate
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> meshletTriangles; // source triangle of each meshlet triangle
+	meshletTriangles.reserve(triangleCount);
+	uint32_t nextSeed = 0;
+	Meshlet current{};
+	Vec3 centroidSum;
+
+	const auto finishMeshlet = [&]() {
+		for(uint32_t i = current.vertexOffset; i < result.vertices.size(); ++i)
+			localIndex[result.vertices[i]] = NONE;
+		result.meshlets.push_back(current);
+		current = Meshlet{};
+		current.vertexOffset = static_cast<uint32_t>(result.vertices.size());
+		current.triangleOffset = static_cast<uint32_t>(result.triangles.size() / 3);
+		centroidSum = Vec3(0, 0, 0);
+		candidates.clear();
+	};
+	const auto addTriangle = [&](uint32_t t) {
+		const uint32_t meshletId = static_cast<uint32_t>(result.meshlets.size());
+		assigned[t] = true;
+		for(uint_fast8_t i = 0; i < 3; ++i) {
+			const uint32_t v = indices[t * 3 + i];
+			if(localIndex[v] == NONE) {
+				localIndex[v] = current.vertexCount++;
+				result.vertices.push_back(v);
+				for(uint32_t j = vertexTriangleOffsets[v]; j < vertexTriangleOffsets[v + 1]; ++j) {
+					const uint32_t neighbor = vertexTriangles[j];
+					if(!assigned[neighbor] && candidateOf[neighbor] != meshletId) {
+						candidateOf[neighbor] = meshletId;
+						candidates.push_back(neighbor);
+					}
+				}
+			}
+			result.triangles.push_back(static_cast<uint8_t>(localIndex[v]));
+		}
+		meshletTriangles.push_back(t);
+		++current.triangleCount;
+		centroidSum += centroids[t];
+	};
+
+	for(uint32_t remaining = triangleCount; remaining > 0; --remaining) {
+		// prefer the candidate adding the fewest vertices, then the one closest to the meshlet
+		const Vec3 center = current.triangleCount > 0 ? centroidSum / static_cast<float>(current.triangleCount) : Vec3(0, 0, 0);
+		uint32_t best = NONE;
+		uint32_t bestNewVertices = 4;
+		float bestDistance = std::numeric_limits<float>::max();
+		size_t keep = 0;
+		for(size_t i = 0; i < candidates.size(); ++i) {
+			const uint32_t t = candidates[i];
+			if(assigned[t])
+				continue;
+			candidates[keep++] = t;
+			uint32_t newVertices = 0;
+			for(uint_fast8_t j = 0; j < 3; ++j)
+				newVertices += localIndex[indices[t * 3 + j]] == NONE ? 1 : 0;
+			const float distance = (centroids[t] - center).lengthSquared();
+			if(newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance)) {
+				best = t;
+				bestNewVertices = newVertices;
+				bestDistance = distance;
+			}
+		}
+		candidates.resize(keep);
+		if(best == NONE) {
+			// nothing connected left: continue with the next unassigned triangle
+			while(assigned[nextSeed])
+				++nextSeed;
+			best = nextSeed;
+			bestNewVertices = 0;
+			for(uint_fast8_t j = 0; j < 3; ++j)
+				bestNewVertices += localIndex[indices[best * 3 + j]] == NONE ? 1 : 0;
+		}
+		if(current.triangleCount >= maxTriangles || current.vertexCount + bestNewVertices > maxVertices)
+			finishMeshlet();
+		addTriangle(best);
+	}
+	if(current.triangleCount > 0)
+		finishMeshlet();
+
+	// bounding spheres and normal cones
+	Parallel::forRange(0, static_cast<uint32_t>(result.meshlets.size()), 64, [&](uint32_t begin, uint32_t end) {
+		for(uint32_t m = begin; m < end; ++m) {
+			Meshlet & meshlet = result.meshlets[m];
+			const uint32_t * vertices = result.vertices.data() + meshlet.vertexOffset;
+			Vec3 min = positions[vertices[0]], max = positions[vertices[0]];
+			for(uint32_t i = 1; i < meshlet.vertexCount; ++i) {
+				const Vec3 & p = positions[vertices[i]];
+				min = Vec3(std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z()));
+				max = Vec3(std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z()));
+			}
+			const Vec3 center = (min + max) * 0.5f;
+			float radius = 0.0f;
+			for(uint32_t i = 0; i < meshlet.vertexCount; ++i)
+				radius = std::max(radius, (positions[vertices[i]] - center).length());
+
+			Vec3 axis;
+			for(uint32_t i = meshlet.triangleOffset; i < meshlet.triangleOffset + meshlet.triangleCount; ++i)
+				axis += triangleNormals[meshletTriangles[i]];
+			const float axisLength = axis.length();
+			float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+			if(axisLength > 0.0f) {
+				axis /= axisLength;
+				for(uint32_t i = meshlet.triangleOffset; i < meshlet.triangleOffset + meshlet.triangleCount; ++i) {
+					const Vec3 & n = triangleNormals[meshletTriangles[i]];
+					if(n.lengthSquared() > 0.0f)
+						minDot = std::min(minDot, n.dot(axis));
+				}
+			}
+
+			for(uint_fast8_t i = 0; i < 3; ++i)
+				meshlet.center[i] = center[i];
+			meshlet.radius = radius;
+			if(minDot < MIN_CONE_DOT) {
+				meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+				meshlet.coneCutoff = 1.0f;
+			} else {
+				for(uint_fast8_t i = 0; i < 3; ++i)
+					meshlet.coneAxis[i] = axis[i];
+				meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+		}
+	});
+	return result;
+}
+
+//! (static)
+void applyMeshletOrder(Mesh * mesh, const MeshletData & data) {
+	MeshIndexData & indexData = mesh->openIndexData();
+	if(indexData.getIndexCount() != data.triangles.size()) {
+		WARN("applyMeshletOrder: The meshlets do not match the mesh.");
+		return;
+	}
+	for(const auto & meshlet : data.meshlets) {
+		for(uint32_t i = meshlet.triangleOffset * 3; i < (meshlet.triangleOffset + meshlet.triangleCount) * 3; ++i)
+			indexData[i] = data.vertices[meshlet.vertexOffset + data.triangles[i]];
+	}
+	indexData.markAsChanged();
+	indexData.updateIndexRange();
+}
+
+//! (static)
+bool isMeshletBackfacing(const Meshlet & meshlet, const Geometry::Vec3 & cameraPosition) {
+	const Vec3 view = Vec3(meshlet.center[0], meshlet.center[1], meshlet.center[2]) - cameraPosition;
+	const Vec3 axis(meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]);
+	return view.dot(axis) >= meshlet.coneCutoff * view.length() + meshlet.radius;
+}
+
+// -----------------------------------------------------------------------------
+
+template<typename T>
+static void write(std::ostream & out, const T * data, size_t count) {
+	out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template<typename T>
+static void read(std::istream & in, T * data, size_t count) {
+	in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+//! (static)
+bool saveMeshlets(const MeshletData & data, std::ostream & output) {
+	const uint32_t header[5] = {MESHLET_HEADER, MESHLET_VERSION, static_cast<uint32_t>(data.meshlets.size()),
+								static_cast<uint32_t>(data.vertices.size()), static_cast<uint32_t>(data.triangles.size() / 3)};
+	write(output, header, 5);
+	write(output, data.meshlets.data(), data.meshlets.size());
+	write(output, data.vertices.data(), data.vertices.size());
+	write(output, data.triangles.data(), data.triangles.size());
+	return output.good();
+}
+
+//! (static)
+bool loadMeshlets(MeshletData & data, std::istream & input) {
+	uint32_t header[5];
+	read(input, header, 5);
+	if(!input.good() || header[0] != MESHLET_HEADER) {
+		WARN("loadMeshlets: Wrong format.");
+		return false;
+	}
+	if(header[1] > MESHLET_VERSION) {
+		WARN("loadMeshlets: Can't read meshlets, version too high.");
+		return false;
+	}
+	data.meshlets.resize(header[2]);
+	data.vertices.resize(header[3]);
+	data.triangles.resize(header[4] * 3);
+	read(input, data.meshlets.data(), data.meshlets.size());
+	read(input, data.vertices.data(), data.vertices.size());
+	read(input, data.triangles.data(), data.triangles.size());
+	if(!input.good()) {
+		WARN("loadMeshlets: Unexpected end of data.");
+		return false;
+	}
+	for(const auto & meshlet : data.meshlets) {
+		if(static_cast<size_t>(meshlet.vertexOffset) + meshlet.vertexCount > data.vertices.size()
+				|| (static_cast<size_t>(meshlet.triangleOffset) + meshlet.triangleCount) * 3 > data.triangles.size()) {
+			WARN("loadMeshlets: Invalid meshlet.");
+			return false;
+		}
+		// the local indices have to reference vertices of the meshlet
+		const auto triangles = data.triangles.begin() + static_cast<std::ptrdiff_t>(meshlet.triangleOffset) * 3;
+		if(std::any_of(triangles, triangles + static_cast<std::ptrdiff_t>(meshlet.triangleCount) * 3,
+				[&meshlet](uint8_t index) { return index >= meshlet.vertexCount; })) {
+			WARN("loadMeshlets: Invalid local vertex index.");
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+}
@@ -0,0 +1,98 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_MESHLETS_H_
+#define RENDERING_MESHUTILS_MESHLETS_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * A small cluster of triangles of a mesh (e.g. for mesh shaders or cluster culling).
+ * The layout is a plain 48 byte structure that can directly be written to files or uploaded into
+ * a (std430) shader storage buffer.
+ */
+struct Meshlet {
+	//! First entry of the meshlet in MeshletData::vertices
+	uint32_t vertexOffset;
+	//! First triangle of the meshlet in MeshletData::triangles (and in the index order of applyMeshletOrder())
+	uint32_t triangleOffset;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+
+	//! Bounding sphere (center, radius)
+	float center[3];
+	float radius;
+
+	/**
+	 * Normal cone: all triangles of the meshlet are back facing for a camera at position c if
+	 *   dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius
+	 * If the normals are too different, coneAxis is zero and coneCutoff is one (the meshlet is never culled).
+	 */
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+/**
+ * The meshlets of a mesh.
+ * The vertices of a meshlet are stored as indices into the vertex data of the mesh, the triangles use
+ * 8-bit indices into the vertex list of their meshlet.
+ */
+struct MeshletData {
+	std::vector<Meshlet> meshlets;
+	//! Vertex indices of the original mesh (vertexCount entries per meshlet)
+	std::vector<uint32_t> vertices;
+	//! Local vertex indices (three per triangle)
+	std::vector<uint8_t> triangles;
+};
+
+/**
+ * Partitions a triangle mesh into meshlets with at most @p maxVertices vertices and @p maxTriangles triangles.
+ * Triangles are added greedily to the current meshlet, preferring triangles that add no (or few) new vertices
+ * and are close to the meshlet. For every meshlet, a bounding sphere and a normal cone are calculated.
+ *
+ * @param mesh Indexed triangle mesh
+ * @param maxVertices Maximum number of vertices per meshlet (3 <= maxVertices <= 256)
+ * @param maxTriangles Maximum number of triangles per meshlet (> 0)
+ * @return the meshlets
+ */
+RENDERINGAPI MeshletData buildMeshlets(Mesh * mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+/**
+ * Replaces the index data of the mesh by the triangles of the meshlets in meshlet order.
+ * Afterwards, each meshlet can be drawn as index range [triangleOffset * 3, (triangleOffset + triangleCount) * 3).
+ */
+RENDERINGAPI void applyMeshletOrder(Mesh * mesh, const MeshletData & data);
+
+//! Returns true if all triangles of the meshlet are facing away from the given camera position.
+RENDERINGAPI bool isMeshletBackfacing(const Meshlet & meshlet, const Geometry::Vec3 & cameraPosition);
+
+/**
+ * Binary little endian format:
+ *   char[4] "mlt"+chr(13), uint32 version (0x01),
+ *   uint32 meshletCount, uint32 vertexCount, uint32 triangleCount,
+ *   Meshlet[meshletCount], uint32[vertexCount], uint8[3 * triangleCount]
+ */
+RENDERINGAPI bool saveMeshlets(const MeshletData & data, std::ostream & output);
+//! Loads meshlets written with saveMeshlets(). Returns false if the data is invalid.
+RENDERINGAPI bool loadMeshlets(MeshletData & data, std::istream & input);
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_MESHLETS_H_ */
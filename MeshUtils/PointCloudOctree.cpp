@@ -0,0 +1,430 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "PointCloudOctree.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAccessor.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include <Geometry/Box.h>
+#include <Geometry/Frustum.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <random>
+
+namespace Rendering {
+namespace MeshUtils {
+using Geometry::Vec3;
+
+static_assert(sizeof(PointCloudPoint) == 16, "PointCloudPoint has to match the vertex layout position3D + colorRGBAByte.");
+
+static const uint32_t OCTREE_HEADER = 0x0d6f6370; // = "pco\r"
+static const uint32_t OCTREE_VERSION = 0x01;
+static const uint32_t OCTREE_HEADER_SIZE = 32;
+
+//! Nodes at this depth are not split any further (e.g. for many identical points).
+static const uint32_t MAX_DEPTH = 24;
+
+//! Memory used for buffering the points of all chunks before writing them to the chunk files.
+static const size_t CHUNK_BUFFER_MEMORY = 64 * 1024 * 1024;
+
+template<typename T>
+static void write(std::ostream & out, const T * data, size_t count) {
+	out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template<typename T>
+static void read(std::istream & in, T * data, size_t count) {
+	in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+static uint32_t getCell(float value, float min, float size, uint32_t resolution) {
+	const float cell = (value - min) / size * static_cast<float>(resolution);
+	if(!(cell > 0.0f)) // also catches NaN
+		return 0;
+	return std::min(static_cast<uint32_t>(cell), resolution - 1);
+}
+
+static uint32_t getOctant(const PointCloudPoint & point, const float * min, float halfSize) {
+	return (point.position[0] >= min[0] + halfSize ? 1 : 0)
+			| (point.position[1] >= min[1] + halfSize ? 2 : 0)
+			| (point.position[2] >= min[2] + halfSize ? 4 : 0);
+}
+
+// ------------------------------------------------------------------------------------------------
+// PointCloudOctreeBuilder
+
+PointCloudOctreeBuilder::PointCloudOctreeBuilder(const Geometry::Box & bounds, std::string _tempFilePrefix,
+													uint32_t _maxNodePoints, uint32_t _chunkLevels) :
+		tempFilePrefix(std::move(_tempFilePrefix)), maxNodePoints(_maxNodePoints), chunkLevels(_chunkLevels),
+		chunkResolution(1u << _chunkLevels), bufferSize(0), pointCount(0), dataOffset(0) {
+	if(maxNodePoints == 0 || chunkLevels > 6)
+		INVALID_ARGUMENT_EXCEPTION("PointCloudOctreeBuilder: maxNodePoints has to be > 0 and chunkLevels <= 6.");
+	rootCube.min[0] = bounds.getMinX();
+	rootCube.min[1] = bounds.getMinY();
+	rootCube.min[2] = bounds.getMinZ();
+	rootCube.size = std::max(bounds.getExtentX(), std::max(bounds.getExtentY(), bounds.getExtentZ()));
+	if(!(rootCube.size > 0.0f))
+		rootCube.size = 1.0f;
+
+	const size_t chunkCount = static_cast<size_t>(chunkResolution) * chunkResolution * chunkResolution;
+	bufferSize = std::max<size_t>(256, CHUNK_BUFFER_MEMORY / sizeof(PointCloudPoint) / chunkCount);
+	chunkBuffers.resize(chunkCount);
+	chunkPointCounts.resize(chunkCount, 0);
+}
+
+PointCloudOctreeBuilder::~PointCloudOctreeBuilder() {
+	for(uint32_t chunk = 0; chunk < chunkPointCounts.size(); ++chunk) {
+		if(chunkPointCounts[chunk] > 0)
+			std::remove(getChunkFileName(chunk).c_str());
+	}
+}
+
+PointCloudOctreeBuilder::Cube PointCloudOctreeBuilder::getChunkCube(uint32_t chunk) const {
+	Cube cube;
+	cube.size = rootCube.size / static_cast<float>(chunkResolution);
+	cube.min[0] = rootCube.min[0] + static_cast<float>(chunk % chunkResolution) * cube.size;
+	cube.min[1] = rootCube.min[1] + static_cast<float>((chunk / chunkResolution) % chunkResolution) * cube.size;
+	cube.min[2] = rootCube.min[2] + static_cast<float>(chunk / (chunkResolution * chunkResolution)) * cube.size;
+	return cube;
+}
+
+std::string PointCloudOctreeBuilder::getChunkFileName(uint32_t chunk) const {
+	return tempFilePrefix + std::to_string(chunk) + ".tmp";
+}
+
+void PointCloudOctreeBuilder::flushChunk(uint32_t chunk) {
+	auto & buffer = chunkBuffers[chunk];
+	if(buffer.empty())
+		return;
+	// the first flush truncates a file left over from an aborted build with the same prefix
+	const auto mode = chunkPointCounts[chunk] == 0 ? std::ios::trunc : std::ios::app;
+	std::ofstream out(getChunkFileName(chunk), std::ios::binary | std::ios::out | mode);
+	write(out, buffer.data(), buffer.size());
+	if(!out.good())
+		WARN("PointCloudOctreeBuilder: Could not write chunk file " + getChunkFileName(chunk));
+	chunkPointCounts[chunk] += buffer.size();
+	buffer.clear();
+}
+
+void PointCloudOctreeBuilder::addPoints(const PointCloudPoint * points, size_t count) {
+	for(size_t i = 0; i < count; ++i) {
+		const auto & point = points[i];
+		const uint32_t chunk = getCell(point.position[0], rootCube.min[0], rootCube.size, chunkResolution)
+				+ (getCell(point.position[1], rootCube.min[1], rootCube.size, chunkResolution)
+				+ getCell(point.position[2], rootCube.min[2], rootCube.size, chunkResolution) * chunkResolution) * chunkResolution;
+		auto & buffer = chunkBuffers[chunk];
+		buffer.push_back(point);
+		if(buffer.size() >= bufferSize)
+			flushChunk(chunk);
+	}
+	pointCount += count;
+}
+
+void PointCloudOctreeBuilder::addPoints(Mesh * mesh) {
+	MeshVertexData & vertices = mesh->openVertexData();
+	const bool hasColor = vertices.getVertexDescription().hasAttribute(VertexAttributeIds::COLOR);
+	auto accessor = VertexAccessor::create(vertices);
+
+	std::vector<PointCloudPoint> points(std::min<size_t>(vertices.getVertexCount(), bufferSize));
+	for(uint32_t begin = 0; begin < vertices.getVertexCount(); begin += static_cast<uint32_t>(points.size())) {
+		const uint32_t end = std::min<uint32_t>(vertices.getVertexCount(), begin + static_cast<uint32_t>(points.size()));
+		for(uint32_t i = begin; i < end; ++i) {
+			auto & point = points[i - begin];
+			const Vec3 position = accessor->getPosition(i);
+			point.position[0] = position.x();
+			point.position[1] = position.y();
+			point.position[2] = position.z();
+			const Util::Color4ub color(hasColor ? accessor->getColor4f(i) : Util::Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+			point.color[0] = color.getR();
+			point.color[1] = color.getG();
+			point.color[2] = color.getB();
+			point.color[3] = color.getA();
+		}
+		addPoints(points.data(), end - begin);
+	}
+}
+
+void PointCloudOctreeBuilder::selectSubsample(const std::vector<PointCloudPoint> & points, const Cube & cube, size_t maxCount,
+												std::vector<uint8_t> & selected) const {
+	// At most one point per cell of a regular grid; point clouds are mostly surfaces, so about
+	// gridResolution^2 cells are occupied.
+	const uint32_t gridResolution = std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(maxCount)))));
+	std::vector<bool> occupied(static_cast<size_t>(gridResolution) * gridResolution * gridResolution, false);
+	selected.assign(points.size(), 0);
+	size_t count = 0;
+	for(size_t i = 0; i < points.size() && count < maxCount; ++i) {
+		const auto & p = points[i].position;
+		const size_t cell = getCell(p[0], cube.min[0], cube.size, gridResolution)
+				+ (getCell(p[1], cube.min[1], cube.size, gridResolution)
+				+ static_cast<size_t>(getCell(p[2], cube.min[2], cube.size, gridResolution)) * gridResolution) * gridResolution;
+		if(!occupied[cell]) {
+			occupied[cell] = true;
+			selected[i] = 1;
+			++count;
+		}
+	}
+}
+
+uint32_t PointCloudOctreeBuilder::writeNode(const std::vector<PointCloudPoint> & points, const Cube & cube, uint32_t depth, std::ostream & output) {
+	PointCloudNode node;
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		node.bounds[a] = cube.min[a];
+		node.bounds[a + 3] = cube.min[a] + cube.size;
+	}
+	node.dataOffset = dataOffset;
+	node.pointCount = static_cast<uint32_t>(points.size());
+	node.depth = depth;
+	std::fill(std::begin(node.children), std::end(node.children), PointCloudNode::NO_CHILD);
+	write(output, points.data(), points.size());
+	dataOffset += points.size() * sizeof(PointCloudPoint);
+	nodes.push_back(node);
+	return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+uint32_t PointCloudOctreeBuilder::buildSubtree(std::vector<PointCloudPoint> & points, const Cube & cube, uint32_t depth, std::ostream & output) {
+	if(points.size() <= maxNodePoints || depth >= MAX_DEPTH)
+		return writeNode(points, cube, depth, output);
+
+	// The points are shuffled once per chunk, so the first point of each grid cell is a random choice.
+	std::vector<uint8_t> selected;
+	selectSubsample(points, cube, maxNodePoints, selected);
+
+	const float halfSize = cube.size * 0.5f;
+	std::vector<PointCloudPoint> nodePoints;
+	std::array<std::vector<PointCloudPoint>, 8> childPoints;
+	for(size_t i = 0; i < points.size(); ++i) {
+		if(selected[i])
+			nodePoints.push_back(points[i]);
+		else
+			childPoints[getOctant(points[i], cube.min, halfSize)].push_back(points[i]);
+	}
+	std::vector<PointCloudPoint>().swap(points);
+	std::vector<uint8_t>().swap(selected);
+
+	const uint32_t node = writeNode(nodePoints, cube, depth, output);
+	std::vector<PointCloudPoint>().swap(nodePoints);
+	for(uint32_t octant = 0; octant < 8; ++octant) {
+		if(childPoints[octant].empty())
+			continue;
+		Cube childCube;
+		childCube.size = halfSize;
+		for(uint_fast8_t a = 0; a < 3; ++a)
+			childCube.min[a] = cube.min[a] + ((octant >> a) & 1 ? halfSize : 0.0f);
+		const uint32_t child = buildSubtree(childPoints[octant], childCube, depth + 1, output);
+		nodes[node].children[octant] = child; // no reference: nodes may grow during the recursion
+	}
+	return node;
+}
+
+bool PointCloudOctreeBuilder::build(std::ostream & output) {
+	for(uint32_t chunk = 0; chunk < chunkBuffers.size(); ++chunk) {
+		flushChunk(chunk);
+		std::vector<PointCloudPoint>().swap(chunkBuffers[chunk]);
+	}
+	nodes.clear();
+	dataOffset = OCTREE_HEADER_SIZE;
+
+	const auto start = output.tellp();
+	const std::vector<char> placeholder(OCTREE_HEADER_SIZE, 0);
+	write(output, placeholder.data(), placeholder.size());
+
+	// subtrees of the chunks
+	const size_t sampleSize = std::max<size_t>(1, maxNodePoints / 8);
+	std::vector<uint32_t> levelNodes(chunkBuffers.size(), PointCloudNode::NO_CHILD);
+	std::vector<std::vector<PointCloudPoint>> levelSamples(chunkBuffers.size());
+	std::default_random_engine engine(0);
+	for(uint32_t chunk = 0; chunk < chunkBuffers.size(); ++chunk) {
+		if(chunkPointCounts[chunk] == 0)
+			continue;
+		std::vector<PointCloudPoint> points(chunkPointCounts[chunk]);
+		{
+			std::ifstream in(getChunkFileName(chunk), std::ios::binary);
+			read(in, points.data(), points.size());
+			if(!in.good()) {
+				WARN("PointCloudOctreeBuilder: Could not read chunk file " + getChunkFileName(chunk));
+				return false;
+			}
+		}
+		std::remove(getChunkFileName(chunk).c_str());
+		chunkPointCounts[chunk] = 0;
+
+		std::shuffle(points.begin(), points.end(), engine);
+		const Cube cube = getChunkCube(chunk);
+		std::vector<uint8_t> selected;
+		selectSubsample(points, cube, sampleSize, selected);
+		for(size_t i = 0; i < points.size(); ++i) {
+			if(selected[i])
+				levelSamples[chunk].push_back(points[i]);
+		}
+		levelNodes[chunk] = buildSubtree(points, cube, chunkLevels, output);
+	}
+
+	// levels above the chunks
+	for(uint32_t level = chunkLevels; level-- > 0;) {
+		const uint32_t resolution = 1u << level;
+		const uint32_t childResolution = resolution * 2;
+		std::vector<uint32_t> parentNodes(static_cast<size_t>(resolution) * resolution * resolution, PointCloudNode::NO_CHILD);
+		std::vector<std::vector<PointCloudPoint>> parentSamples(parentNodes.size());
+		for(uint32_t cell = 0; cell < parentNodes.size(); ++cell) {
+			const uint32_t x = cell % resolution;
+			const uint32_t y = (cell / resolution) % resolution;
+			const uint32_t z = cell / (resolution * resolution);
+			uint32_t children[8];
+			std::vector<PointCloudPoint> points;
+			for(uint32_t octant = 0; octant < 8; ++octant) {
+				const uint32_t childCell = (2 * x + (octant & 1))
+						+ ((2 * y + ((octant >> 1) & 1)) + (2 * z + ((octant >> 2) & 1)) * childResolution) * childResolution;
+				children[octant] = levelNodes[childCell];
+				points.insert(points.end(), levelSamples[childCell].begin(), levelSamples[childCell].end());
+			}
+			if(std::all_of(std::begin(children), std::end(children), [](uint32_t c) { return c == PointCloudNode::NO_CHILD; }))
+				continue;
+
+			Cube cube;
+			cube.size = rootCube.size / static_cast<float>(resolution);
+			cube.min[0] = rootCube.min[0] + static_cast<float>(x) * cube.size;
+			cube.min[1] = rootCube.min[1] + static_cast<float>(y) * cube.size;
+			cube.min[2] = rootCube.min[2] + static_cast<float>(z) * cube.size;
+
+			std::vector<uint8_t> selected;
+			selectSubsample(points, cube, maxNodePoints, selected);
+			std::vector<PointCloudPoint> nodePoints;
+			for(size_t i = 0; i < points.size(); ++i) {
+				if(selected[i])
+					nodePoints.push_back(points[i]);
+			}
+			const uint32_t node = writeNode(nodePoints, cube, level, output);
+			std::copy(std::begin(children), std::end(children), nodes[node].children);
+			parentNodes[cell] = node;
+
+			selectSubsample(nodePoints, cube, sampleSize, selected);
+			for(size_t i = 0; i < nodePoints.size(); ++i) {
+				if(selected[i])
+					parentSamples[cell].push_back(nodePoints[i]);
+			}
+		}
+		levelNodes.swap(parentNodes);
+		levelSamples.swap(parentSamples);
+	}
+	uint32_t rootNode = levelNodes.front();
+	if(rootNode == PointCloudNode::NO_CHILD)
+		rootNode = writeNode({}, rootCube, 0, output);
+
+	const uint64_t nodeTableOffset = dataOffset;
+	write(output, nodes.data(), nodes.size());
+	const auto end = output.tellp();
+
+	const uint32_t header[4] = {OCTREE_HEADER, OCTREE_VERSION, static_cast<uint32_t>(nodes.size()), rootNode};
+	output.seekp(start);
+	write(output, header, 4);
+	write(output, &pointCount, 1);
+	write(output, &nodeTableOffset, 1);
+	output.seekp(end);
+	return output.good();
+}
+
+// ------------------------------------------------------------------------------------------------
+// PointCloudOctree
+
+bool PointCloudOctree::open(std::istream & input) {
+	dataStart = static_cast<uint64_t>(input.tellg());
+	uint32_t header[4];
+	uint64_t nodeTableOffset = 0;
+	read(input, header, 4);
+	read(input, &pointCount, 1);
+	read(input, &nodeTableOffset, 1);
+	if(!input.good() || header[0] != OCTREE_HEADER) {
+		WARN("PointCloudOctree: Wrong format.");
+		return false;
+	}
+	if(header[1] > OCTREE_VERSION) {
+		WARN("PointCloudOctree: Can't read octree, version too high.");
+		return false;
+	}
+	nodes.resize(header[2]);
+	rootNode = header[3];
+	input.seekg(static_cast<std::streamoff>(dataStart + nodeTableOffset));
+	read(input, nodes.data(), nodes.size());
+	if(!input.good() || rootNode >= nodes.size()) {
+		WARN("PointCloudOctree: Invalid node table.");
+		nodes.clear();
+		rootNode = PointCloudNode::NO_CHILD;
+		return false;
+	}
+	return true;
+}
+
+std::vector<uint32_t> PointCloudOctree::query(const Geometry::Frustum & frustum, const Vec3 & cameraPosition, uint64_t pointBudget) const {
+	std::vector<uint32_t> result;
+	if(rootNode == PointCloudNode::NO_CHILD)
+		return result;
+
+	typedef std::pair<float, uint32_t> entry_t; // (projected size, node)
+	std::priority_queue<entry_t> queue;
+	const auto enqueue = [&](uint32_t index) {
+		const Geometry::Box box = nodes[index].getBox();
+		if(frustum.isBoxInFrustum(box) == Geometry::Frustum::OUTSIDE)
+			return;
+		const float radius = box.getDiameter() * 0.5f;
+		const float distance = (box.getCenter() - cameraPosition).length();
+		queue.emplace(distance > radius ? radius / distance : std::numeric_limits<float>::max(), index);
+	};
+	enqueue(rootNode);
+
+	uint64_t points = 0;
+	while(!queue.empty()) {
+		const uint32_t index = queue.top().second;
+		queue.pop();
+		const auto & node = nodes[index];
+		if(points + node.pointCount > pointBudget)
+			continue;
+		points += node.pointCount;
+		result.push_back(index);
+		for(uint32_t child : node.children) {
+			if(child != PointCloudNode::NO_CHILD)
+				enqueue(child);
+		}
+	}
+	return result;
+}
+
+Mesh * PointCloudOctree::loadNode(std::istream & input, uint32_t index) const {
+	if(index >= nodes.size())
+		INVALID_ARGUMENT_EXCEPTION("PointCloudOctree::loadNode: Invalid node.");
+	const auto & node = nodes[index];
+
+	VertexDescription vertexDesc;
+	vertexDesc.appendPosition3D();
+	vertexDesc.appendColorRGBAByte();
+	auto mesh = new Mesh(vertexDesc, node.pointCount, 0);
+
+	MeshVertexData & vd = mesh->openVertexData();
+	input.seekg(static_cast<std::streamoff>(dataStart + node.dataOffset));
+	read(input, reinterpret_cast<PointCloudPoint *>(vd.data()), node.pointCount);
+	if(!input.good())
+		WARN("PointCloudOctree::loadNode: Unexpected end of data.");
+	vd.markAsChanged();
+	vd.updateBoundingBox();
+
+	mesh->setDrawMode(Mesh::DRAW_POINTS);
+	mesh->setUseIndexData(false);
+	return mesh;
+}
+
+}
+}
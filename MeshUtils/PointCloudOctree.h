@@ -0,0 +1,147 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_POINTCLOUDOCTREE_H_
+#define RENDERING_MESHUTILS_POINTCLOUDOCTREE_H_
+
+#include <Geometry/Box.h>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Geometry {
+class Frustum;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+//! A point as stored in a point cloud octree (same layout as the vertices of StreamerXYZ: position3D + colorRGBAByte).
+struct PointCloudPoint {
+	float position[3];
+	uint8_t color[4];
+};
+
+/**
+ * Node of a point cloud octree.
+ * The octree is additive: an inner node contains a spatially uniform subsample of its subtree, which is
+ * refined by the points of its children.
+ */
+struct PointCloudNode {
+	static constexpr uint32_t NO_CHILD = 0xffffffff;
+	//! Cube of the node (minX, minY, minZ, maxX, maxY, maxZ)
+	float bounds[6];
+	//! Byte offset of the points of the node in the octree data
+	uint64_t dataOffset;
+	uint32_t pointCount;
+	uint32_t depth;
+	uint32_t children[8];
+
+	Geometry::Box getBox() const { return Geometry::Box(bounds[0], bounds[3], bounds[1], bounds[4], bounds[2], bounds[5]); }
+};
+
+/**
+ * Out-of-core builder for point cloud octrees.
+ *
+ * The points are streamed in (addPoints()) and sorted into 8^chunkLevels chunk files on disk.
+ * build() then loads one chunk at a time, builds its subtree (each node holds at most @p maxNodePoints points,
+ * inner nodes contain a grid subsample of their subtree) and writes the nodes to the output.
+ * The nodes above the chunk level are built from subsamples of the chunk roots (they contain copies of
+ * points that are also stored deeper in the tree).
+ * The memory requirement is bounded by the size of the largest chunk.
+ *
+ * Output format (binary little endian):
+ *   char[4] "pco"+chr(13), uint32 version (0x01), uint32 nodeCount, uint32 rootNode, uint64 pointCount,
+ *   uint64 nodeTableOffset, PointCloudPoint[] (the points of all nodes), PointCloudNode[nodeCount]
+ */
+class PointCloudOctreeBuilder {
+	public:
+		/**
+		 * @param bounds Bounds of all points (points outside are sorted into the nearest chunk)
+		 * @param tempFilePrefix Prefix (including the directory) of the temporary chunk files
+		 * @param maxNodePoints Maximum number of points per node (except for nodes at the maximum depth)
+		 * @param chunkLevels Number of octree levels used for the out-of-core sorting (8^chunkLevels chunk files)
+		 */
+		RENDERINGAPI PointCloudOctreeBuilder(const Geometry::Box & bounds, std::string tempFilePrefix,
+												uint32_t maxNodePoints = 20000, uint32_t chunkLevels = 3);
+		//! Removes the temporary files.
+		RENDERINGAPI ~PointCloudOctreeBuilder();
+
+		RENDERINGAPI void addPoints(const PointCloudPoint * points, size_t count);
+		//! Adds the vertices of a mesh (e.g. a batch loaded by StreamerXYZ::loadMesh(input, numPoints)).
+		RENDERINGAPI void addPoints(Mesh * mesh);
+
+		uint64_t getPointCount() const { return pointCount; }
+
+		/**
+		 * Builds the octree and writes it to the given (seekable) stream.
+		 * @return false if an error occurred
+		 */
+		RENDERINGAPI bool build(std::ostream & output);
+
+	private:
+		struct Cube {
+			float min[3];
+			float size;
+		};
+		Cube getChunkCube(uint32_t chunk) const;
+		std::string getChunkFileName(uint32_t chunk) const;
+		void flushChunk(uint32_t chunk);
+		uint32_t buildSubtree(std::vector<PointCloudPoint> & points, const Cube & cube, uint32_t depth, std::ostream & output);
+		uint32_t writeNode(const std::vector<PointCloudPoint> & points, const Cube & cube, uint32_t depth, std::ostream & output);
+		void selectSubsample(const std::vector<PointCloudPoint> & points, const Cube & cube, size_t maxCount, std::vector<uint8_t> & selected) const;
+
+		Cube rootCube;
+		std::string tempFilePrefix;
+		uint32_t maxNodePoints;
+		uint32_t chunkLevels;
+		uint32_t chunkResolution;
+		size_t bufferSize;
+		uint64_t pointCount;
+		std::vector<std::vector<PointCloudPoint>> chunkBuffers;
+		std::vector<uint64_t> chunkPointCounts;
+		std::vector<PointCloudNode> nodes;
+		uint64_t dataOffset;
+};
+
+/**
+ * Read access to an octree written by PointCloudOctreeBuilder.
+ * Only the node table is kept in memory, the points of the nodes are loaded on demand.
+ */
+class PointCloudOctree {
+	public:
+		//! Reads the header and the node table of the octree.
+		RENDERINGAPI bool open(std::istream & input);
+
+		const std::vector<PointCloudNode> & getNodes() const { return nodes; }
+		uint32_t getRootNode() const { return rootNode; }
+		uint64_t getPointCount() const { return pointCount; }
+
+		/**
+		 * Selects the nodes to render: starting at the root, the visible nodes with the largest projected size
+		 * are selected first until the point budget is reached. A node is only selected if its parent is selected.
+		 */
+		RENDERINGAPI std::vector<uint32_t> query(const Geometry::Frustum & frustum, const Geometry::Vec3 & cameraPosition, uint64_t pointBudget) const;
+
+		//! Loads the points of a node into a new mesh (DRAW_POINTS).
+		RENDERINGAPI Mesh * loadNode(std::istream & input, uint32_t node) const;
+
+	private:
+		std::vector<PointCloudNode> nodes;
+		uint32_t rootNode = PointCloudNode::NO_CHILD;
+		uint64_t pointCount = 0;
+		//! Stream position of the beginning of the octree data
+		uint64_t dataStart = 0;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHUTILS_POINTCLOUDOCTREE_H_ */
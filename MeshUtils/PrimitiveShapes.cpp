@@ -13,6 +13,7 @@
 
 #include "MeshBuilder.h"
 #include "MeshUtils.h"
+#include "internal/Parallel.h"
 #include "../Mesh/Mesh.h"
 
 #include <Geometry/Box.h>
@@ -27,8 +28,10 @@
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Graphics/Bitmap.h>
 
+#include <algorithm>
 #include <cmath>
 #include <map>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
@@ -468,57 +471,176 @@ Mesh* createHexGrid(const VertexDescription& vd, float width, float height, uint
 
 // ---------------------------------------------------------
 
-void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth) {
-	//Util::Reference<Util::PixelAccessor> colorAcc = Util::PixelAccessor::create(std::move(voxelBitmap));
+namespace {
+
+//! Voxels of a voxel bitmap, read once into a compact grid of packed RGBA values.
+struct VoxelGrid {
+	uint32_t res[3];
+	std::vector<uint32_t> colors;
+
+	VoxelGrid(const Util::PixelAccessor& colorAcc, uint32_t depth) : res{colorAcc.getWidth(), colorAcc.getHeight()/depth, depth},
+			colors(static_cast<size_t>(res[0]) * res[1] * res[2]) {
+		Parallel::forEach(0, res[2], [&](uint32_t z) {
+			uint32_t* ptr = colors.data() + static_cast<size_t>(z) * res[0] * res[1];
+			for(uint32_t y=0; y<res[1]; ++y) {
+				for(uint32_t x=0; x<res[0]; ++x) {
+					const Util::Color4ub c = colorAcc.readColor4ub(x, y + z*res[1]);
+					*ptr++ = static_cast<uint32_t>(c.getR()) | (static_cast<uint32_t>(c.getG()) << 8) | (static_cast<uint32_t>(c.getB()) << 16) | (static_cast<uint32_t>(c.getA()) << 24);
+				}
+			}
+		});
+	}
+	uint32_t get(const uint32_t p[3]) const { return colors[(static_cast<size_t>(p[2]) * res[1] + p[1]) * res[0] + p[0]]; }
+	//! A voxel is created for every pixel with a positive alpha value.
+	static bool isSolid(uint32_t color) { return (color >> 24) > 0; }
+	//! Only voxels with an alpha value of at least 0.1 hide the faces of their neighbors.
+	static bool isOccluder(uint32_t color) { return (color >> 24) >= 26; }
+	static Util::Color4ub unpack(uint32_t color) {
+		return Util::Color4ub(color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff, color >> 24);
+	}
+};
+
+//! The six face directions of a voxel.
+struct VoxelFace {
+	uint8_t axis;
+	int8_t direction;
+	//! Bit i of mod[a] is set if the i-th corner of the quad is offset along the axis a.
+	uint8_t mod[3];
+	float normal[3];
+};
+static const VoxelFace voxelFaces[6] = {
+	{0, -1, {0, 4|8, 2|4}, {-1,0,0}},
+	{0, 1, {1|2|4|8, 2|4, 4|8}, {1,0,0}},
+	{1, -1, {2|4, 0, 4|8}, {0,-1,0}},
+	{1, 1, {4|8, 1|2|4|8, 2|4}, {0,1,0}},
+	{2, -1, {4|8, 2|4, 0}, {0,0,-1}},
+	{2, 1, {2|4, 4|8, 1|2|4|8}, {0,0,1}},
+};
+
+//! Rectangle of coplanar voxel faces with the same color.
+struct VoxelQuad {
+	uint32_t origin[3];
+	uint32_t size[3];
+	uint32_t color;
+};
+
+static void addVoxelQuad(MeshBuilder& mb, const VoxelFace& face, const VoxelQuad& quad) {
+	uint32_t idx = mb.getNextIndex();
+	mb.color(VoxelGrid::unpack(quad.color));
+	mb.normal(Vec3(face.normal[0], face.normal[1], face.normal[2]));
+	for(uint8_t corner=0; corner<4; ++corner) {
+		float pos[3];
+		for(uint8_t a=0; a<3; ++a)
+			pos[a] = static_cast<float>(quad.origin[a]) + ((face.mod[a] & (1 << corner))>0 ? static_cast<float>(quad.size[a]) : 0.0f);
+		mb.position(Vec3(pos[0], pos[1], pos[2]));
+		mb.addVertex();
+	}
+	mb.addQuad(idx,idx+1,idx+2,idx+3);
+}
+
+/**
+ * Collect the visible faces of one slice of voxels for the given face direction.
+ * If @p greedy is true, neighboring faces with the same color are merged into maximal rectangles.
+ */
+static void collectVoxelQuads(const VoxelGrid& grid, const VoxelFace& face, uint32_t slice, bool greedy, std::vector<VoxelQuad>& quads) {
+	const uint8_t a = face.axis;
+	const uint8_t u = (a+1)%3;
+	const uint8_t v = (a+2)%3;
+	const uint32_t resU = grid.res[u];
+	const uint32_t resV = grid.res[v];
+	const bool hasNeighborSlice = face.direction < 0 ? slice > 0 : slice+1 < grid.res[a];
+
+	// mask of visible face colors; faces are visible if the neighbor in face direction does not occlude them.
+	static const uint64_t NO_FACE = ~0ULL;
+	std::vector<uint64_t> mask(static_cast<size_t>(resU) * resV, NO_FACE);
+	uint32_t p[3];
+	p[a] = slice;
+	for(uint32_t iv=0; iv<resV; ++iv) {
+		for(uint32_t iu=0; iu<resU; ++iu) {
+			p[u] = iu;
+			p[v] = iv;
+			const uint32_t color = grid.get(p);
+			if(!VoxelGrid::isSolid(color))
+				continue;
+			if(hasNeighborSlice) {
+				uint32_t n[3] = {p[0], p[1], p[2]};
+				n[a] = face.direction < 0 ? slice-1 : slice+1;
+				if(VoxelGrid::isOccluder(grid.get(n)))
+					continue;
+			}
+			mask[iv*resU + iu] = color;
+		}
+	}
+
+	for(uint32_t iv=0; iv<resV; ++iv) {
+		for(uint32_t iu=0; iu<resU; ) {
+			const uint64_t color = mask[iv*resU + iu];
+			if(color == NO_FACE) {
+				++iu;
+				continue;
+			}
+			uint32_t width = 1;
+			uint32_t height = 1;
+			if(greedy) {
+				while(iu+width < resU && mask[iv*resU + iu+width] == color)
+					++width;
+				for(; iv+height < resV; ++height) {
+					const uint64_t* row = mask.data() + (iv+height)*resU + iu;
+					if(!std::all_of(row, row+width, [color](uint64_t c) { return c == color; }))
+						break;
+				}
+				for(uint32_t h=0; h<height; ++h)
+					std::fill_n(mask.data() + (iv+h)*resU + iu, width, NO_FACE);
+			}
+			VoxelQuad quad;
+			quad.origin[a] = slice;
+			quad.origin[u] = iu;
+			quad.origin[v] = iv;
+			quad.size[a] = 1;
+			quad.size[u] = width;
+			quad.size[v] = height;
+			quad.color = static_cast<uint32_t>(color);
+			quads.emplace_back(quad);
+			iu += width;
+		}
+	}
+}
+
+}
+
+void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy) {
 	if( colorAcc.getPixelFormat().getComponentCount() < 4 ){
 		WARN("createVoxelMesh: unsupported color texture format. Requires 4 components.");
 		return;
 	}
-	if(colorAcc.getHeight()%depth != 0) {
+	if(depth == 0 || colorAcc.getHeight()%depth != 0) {
 		WARN("createVoxelMesh: Bitmap height is not divisible by depth.");
 		return;
 	}
-	
-	Vec3ui res(colorAcc.getWidth(), colorAcc.getHeight()/depth, depth);
-	
-	const auto createQuad = [&](uint32_t x, uint32_t y, uint32_t z, uint8_t xMod, uint8_t yMod, uint8_t zMod, const Vec3& normal){
-    uint32_t idx = mb.getNextIndex();
-    mb.normal(normal);
-    Vec3 pos(static_cast<float>(x),static_cast<float>(y),static_cast<float>(z));
-    mb.position(Vec3{pos.x() + ((xMod&1)>0?1.0f:0.0f),pos.y() + ((yMod&1)>0?1.0f:0.0f),pos.z() + ((zMod&1)>0?1.0f:0.0f)}); mb.addVertex();
-    mb.position(Vec3{pos.x() + ((xMod&2)>0?1.0f:0.0f),pos.y() + ((yMod&2)>0?1.0f:0.0f),pos.z() + ((zMod&2)>0?1.0f:0.0f)}); mb.addVertex();
-    mb.position(Vec3{pos.x() + ((xMod&4)>0?1.0f:0.0f),pos.y() + ((yMod&4)>0?1.0f:0.0f),pos.z() + ((zMod&4)>0?1.0f:0.0f)}); mb.addVertex();
-    mb.position(Vec3{pos.x() + ((xMod&8)>0?1.0f:0.0f),pos.y() + ((yMod&8)>0?1.0f:0.0f),pos.z() + ((zMod&8)>0?1.0f:0.0f)}); mb.addVertex();
-    mb.addQuad(idx,idx+1,idx+2,idx+3);
-	};
-	
-  for(uint32_t z=0; z<res.z(); ++z) {    
-    for(uint32_t y=0; y<res.y(); ++y) {      
-      for(uint32_t x=0; x<res.x(); ++x) {
-        auto color = colorAcc.readColor4f(x, y + z*res.y()); 
-        if(color.a() > 0) {
-          mb.color(color);
-          if(x==0 || colorAcc.readColor4f(x-1, y + z*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 0, 4|8, 2|4, {-1,0,0});
-          if(x==res.x()-1 || colorAcc.readColor4f(x+1, y + z*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 1|2|4|8, 2|4, 4|8, {1,0,0});
-          if(y==0 || colorAcc.readColor4f(x, y-1 + z*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 2|4, 0, 4|8, {0,-1,0});
-          if(y==res.y()-1 || colorAcc.readColor4f(x, y+1 + z*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 4|8, 1|2|4|8, 2|4, {0,1,0});
-          if(z==0 || colorAcc.readColor4f(x, y + (z-1)*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 4|8, 2|4, 0, {0,0,-1});
-          if(z==res.z()-1 || colorAcc.readColor4f(x, y + (z+1)*res.y()).a() < 0.1) 
-            createQuad(x, y, z, 2|4, 4|8, 1|2|4|8, {0,0,1});
-        }
-      }
-    }
-  }
+
+	const VoxelGrid grid(colorAcc, depth);
+
+	// every (face direction, slice) pair is processed independently
+	std::vector<std::pair<uint8_t, uint32_t>> tasks;
+	for(uint8_t f=0; f<6; ++f) {
+		for(uint32_t slice=0; slice<grid.res[voxelFaces[f].axis]; ++slice)
+			tasks.emplace_back(f, slice);
+	}
+	std::vector<std::vector<VoxelQuad>> quads(tasks.size());
+	Parallel::forEach(0, static_cast<uint32_t>(tasks.size()), [&](uint32_t t) {
+		collectVoxelQuads(grid, voxelFaces[tasks[t].first], tasks[t].second, greedy, quads[t]);
+	});
+
+	for(size_t t=0; t<tasks.size(); ++t) {
+		for(const auto& quad : quads[t])
+			addVoxelQuad(mb, voxelFaces[tasks[t].first], quad);
+		std::vector<VoxelQuad>().swap(quads[t]);
+	}
 }
 
-Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth) {
+Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy) {
   MeshBuilder mb(vd);
-  addVoxelMesh(mb, colorAcc, depth);
+  addVoxelMesh(mb, colorAcc, depth, greedy);
   return mb.buildMesh();
 }
 
@@ -577,9 +699,12 @@ void addMeshFromBitmaps(MeshBuilder& mb, Util::Reference<Util::PixelAccessor> de
 		WARN("createMeshFromBitmaps: unsupported color texture format");
 		return;
 	}
+	if(width == 0 || height == 0)
+		return;
 	const float xScale=2.0f / width;
 	const float yScale=2.0f / height;
 	const float cut=1;
+	mb.reserve(mb.getNextIndex() + width * height, mb.getIndexCount() + 6 * (width - 1) * (height - 1));
 
 	for(uint32_t y=0; y<height; ++y){
 		for(uint32_t x=0; x<width; ++x){
@@ -245,11 +245,13 @@ RENDERINGAPI void addHexGrid(MeshBuilder& mb, float width, float height, uint32_
  * @param vd Vertex description specifying the vertex information to generate
  * @param colorAcc the bitmap that defines the voxel grid. Every pixel with non-zero alpha value defines a voxel.
  * @param the depth of the voxel grid. The height of the bitmap should be divisible by this value
+ * @param greedy If true, coplanar neighboring faces with the same color are merged into maximal rectangles,
+ *   which greatly reduces the number of triangles. The faces of each slice are generated in parallel.
  */
-RENDERINGAPI Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth);
+RENDERINGAPI Mesh* createVoxelMesh(const VertexDescription& vd, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy=false);
 
-//! Adds a voxel mesh to the given meshBuilder. \see createHexGrid(...)
-RENDERINGAPI void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth);
+//! Adds a voxel mesh to the given meshBuilder. \see createVoxelMesh(...)
+RENDERINGAPI void addVoxelMesh(MeshBuilder& mb, const Util::PixelAccessor& colorAcc, uint32_t depth, bool greedy=false);
 
  /**
  * Creates a torus mesh.
@@ -9,15 +9,26 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "QuadtreeMeshBuilder.h"
-#include "MeshBuilder.h"
+#include "internal/Parallel.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAccessor.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
 
 #include <Geometry/Vec2.h>
 #include <Geometry/Vec3.h>
 
+#include <Util/Graphics/Color.h>
 #include <Util/Graphics/PixelAccessor.h>
+#include <Util/Macros.h>
 
+#include <atomic>
+#include <iostream>
 #include <limits>
-#include <map>
+#include <memory>
+#include <numeric>
 
 #ifndef NDEBUG
 #define NDEBUG
@@ -29,44 +40,21 @@ namespace MeshUtils {
 using namespace Util;
 using namespace std;
 
-QuadtreeMeshBuilder::QuadTree::QuadTree(uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height) :
-	children(),
-	neighbors(),
-	parent(nullptr),
-	x(_x),
-	y(_y),
-	width(_width),
-	height(_height) {
-
-	neighbors.WEST = nullptr;
-	neighbors.NORTH = nullptr;
-	neighbors.EAST = nullptr;
-	neighbors.SOUTH = nullptr;
+QuadtreeMeshBuilder::QuadTreeArena::QuadTreeArena(uint16_t width, uint16_t height) {
+	nodes.emplace_back(QuadTree::INVALID_NODE, 0, 0, width, height);
 }
 
-QuadtreeMeshBuilder::QuadTree::QuadTree(QuadtreeMeshBuilder::QuadTree* _parent, uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height) :
-	children(),
-	neighbors(),
-	parent(_parent),
-	x(_x),
-	y(_y),
-	width(_width),
-	height(_height) {
-
-	neighbors.WEST = nullptr;
-	neighbors.NORTH = nullptr;
-	neighbors.EAST = nullptr;
-	neighbors.SOUTH = nullptr;
-}
-
-QuadtreeMeshBuilder::QuadTree::~QuadTree() = default;
-
-bool QuadtreeMeshBuilder::QuadTree::split() {
-	if (!isLeaf()) {
+bool QuadtreeMeshBuilder::QuadTreeArena::split(uint32_t node) {
+	if (!nodes[node].isLeaf()) {
 		cerr << " (inner) BAD !!! \n";
 		return false; // current node has been already split
 	}
 
+	// copy the values: nodes may be reallocated when the children are added
+	const uint16_t x = nodes[node].x;
+	const uint16_t y = nodes[node].y;
+	const uint16_t width = nodes[node].width;
+	const uint16_t height = nodes[node].height;
 	if (width == 1 && height == 1) {
 		return false; // no need for further split (representing a single pixel)
 	}
@@ -75,155 +63,164 @@ bool QuadtreeMeshBuilder::QuadTree::split() {
 	const uint16_t height1 = height - height / 2u;
 
 	// create (maximum) four children (sometimes a quad-tree node can only contain the children NW and NE, or NW and SW)
-	children.NW.reset(new QuadTree(this, x, y, width1, height1));
+	uint32_t children[4] = {size(), QuadTree::INVALID_NODE, QuadTree::INVALID_NODE, QuadTree::INVALID_NODE};
+	nodes.emplace_back(node, x, y, width1, height1);
 	if (width > 1) {
-		children.NE.reset(new QuadTree(this, x+width1, y, width-width1, height1));
+		children[QuadTree::NE] = size();
+		nodes.emplace_back(node, x+width1, y, width-width1, height1);
 	}
 	if (height > 1) {
-		children.SW.reset(new QuadTree(this, x, y+height1, width1, height-height1));
+		children[QuadTree::SW] = size();
+		nodes.emplace_back(node, x, y+height1, width1, height-height1);
 	}
 	if (width > 1 && height > 1) {
-		children.SE.reset(new QuadTree(this, x+width1, y+height1, width-width1, height-height1));
+		children[QuadTree::SE] = size();
+		nodes.emplace_back(node, x+width1, y+height1, width-width1, height-height1);
 	}
+	std::copy(children, children + 4, nodes[node].children);
 
 	// rearrange the neighbors and do balancing where necessary
-	arrangeNeighbors();
+	arrangeNeighbors(node);
 
 	return true;
 }
 
-void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
-	QuadTree * west = neighbors.WEST;
-	QuadTree * north = neighbors.NORTH;
-	QuadTree * east = neighbors.EAST;
-	QuadTree * south = neighbors.SOUTH;
+void QuadtreeMeshBuilder::QuadTreeArena::arrangeNeighbors(uint32_t node) {
+	static const uint32_t NONE = QuadTree::INVALID_NODE;
+	// copy the node: splitting a neighbor may reallocate the nodes
+	const QuadTree current = nodes[node];
 
-	QuadTree * nw = children.NW.get();
-	QuadTree * ne = children.NE.get();
-	QuadTree * sw = children.SW.get();
-	QuadTree * se = children.SE.get();
+	const uint32_t west = current.neighbors[QuadTree::WEST];
+	const uint32_t north = current.neighbors[QuadTree::NORTH];
+	const uint32_t east = current.neighbors[QuadTree::EAST];
+	const uint32_t south = current.neighbors[QuadTree::SOUTH];
+
+	const uint32_t nw = current.children[QuadTree::NW];
+	const uint32_t ne = current.children[QuadTree::NE];
+	const uint32_t sw = current.children[QuadTree::SW];
+	const uint32_t se = current.children[QuadTree::SE];
 
 
 	// west side
-	if (west && west->getHeight() > height) { // west must be split
-		if (west->isLeaf()) {
-			west->split();
-		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NW.get() == this) ? west->children.NE.get() : west->children.SE.get();
-		nw->neighbors.WEST = neighbor;
-		if (sw != nullptr)
-			sw->neighbors.WEST = neighbor;
-	} else if (west && !west->isLeaf()) {
-		makeHorizontalNeighbors(west->children.NE.get(), nw);
-		if (sw != nullptr) {
-			makeHorizontalNeighbors(west->children.SE.get(), sw);
+	if (west != NONE && nodes[west].height > current.height) { // west must be split
+		if (nodes[west].isLeaf()) {
+			split(west);
+		}
+		const uint32_t neighbor = isChild(node, QuadTree::NW) ? getChild(west, QuadTree::NE) : getChild(west, QuadTree::SE);
+		nodes[nw].neighbors[QuadTree::WEST] = neighbor;
+		if (sw != NONE)
+			nodes[sw].neighbors[QuadTree::WEST] = neighbor;
+	} else if (west != NONE && !nodes[west].isLeaf()) {
+		makeHorizontalNeighbors(getChild(west, QuadTree::NE), nw);
+		if (sw != NONE) {
+			makeHorizontalNeighbors(getChild(west, QuadTree::SE), sw);
 		}
 	} else {
-		nw->neighbors.WEST = west;
-		if (sw != nullptr) {
-			sw->neighbors.WEST = west;
+		nodes[nw].neighbors[QuadTree::WEST] = west;
+		if (sw != NONE) {
+			nodes[sw].neighbors[QuadTree::WEST] = west;
 		}
 	}
 
 	// north side
-	if (north && north->getWidth() > width) { // north must be split
-		if (north->isLeaf()) {
-			north->split();
-		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NW.get() == this) ? north->children.SW.get() : north->children.SE.get();
-		nw->neighbors.NORTH = neighbor;
-		if (ne != nullptr)
-			ne->neighbors.NORTH = neighbor;
-	} else if (north && !north->isLeaf()) {
-		makeVerticalNeighbors(north->children.SW.get(), nw);
-		if (ne != nullptr) {
-			makeVerticalNeighbors(north->children.SE.get(), ne);
+	if (north != NONE && nodes[north].width > current.width) { // north must be split
+		if (nodes[north].isLeaf()) {
+			split(north);
+		}
+		const uint32_t neighbor = isChild(node, QuadTree::NW) ? getChild(north, QuadTree::SW) : getChild(north, QuadTree::SE);
+		nodes[nw].neighbors[QuadTree::NORTH] = neighbor;
+		if (ne != NONE)
+			nodes[ne].neighbors[QuadTree::NORTH] = neighbor;
+	} else if (north != NONE && !nodes[north].isLeaf()) {
+		makeVerticalNeighbors(getChild(north, QuadTree::SW), nw);
+		if (ne != NONE) {
+			makeVerticalNeighbors(getChild(north, QuadTree::SE), ne);
 		}
 	} else {
-		nw->neighbors.NORTH = north;
-		if (ne != nullptr) {
-			ne->neighbors.NORTH = north;
+		nodes[nw].neighbors[QuadTree::NORTH] = north;
+		if (ne != NONE) {
+			nodes[ne].neighbors[QuadTree::NORTH] = north;
 		}
 	}
 
 	// east side
-	if (east && east->getHeight() > height) { // east must be split
-		if (east->isLeaf()) {
-			east->split();
-		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.NE.get() == this) ? east->children.NW.get() : east->children.SW.get();
-		if (ne == nullptr) {
-			nw->neighbors.EAST = neighbor;
-			sw->neighbors.EAST = neighbor;
+	if (east != NONE && nodes[east].height > current.height) { // east must be split
+		if (nodes[east].isLeaf()) {
+			split(east);
+		}
+		const uint32_t neighbor = isChild(node, QuadTree::NE) ? getChild(east, QuadTree::NW) : getChild(east, QuadTree::SW);
+		if (ne == NONE) {
+			nodes[nw].neighbors[QuadTree::EAST] = neighbor;
+			nodes[sw].neighbors[QuadTree::EAST] = neighbor;
 		} else {
-			ne->neighbors.EAST = neighbor;
-			if (se != nullptr) {
-				se->neighbors.EAST = neighbor;
+			nodes[ne].neighbors[QuadTree::EAST] = neighbor;
+			if (se != NONE) {
+				nodes[se].neighbors[QuadTree::EAST] = neighbor;
 			}
 		}
-	} else if (east && !east->isLeaf()) {
-		if (ne == nullptr) {
-			makeHorizontalNeighbors(nw, east->children.NW.get());
-			makeHorizontalNeighbors(sw, east->children.SW.get());
+	} else if (east != NONE && !nodes[east].isLeaf()) {
+		if (ne == NONE) {
+			makeHorizontalNeighbors(nw, getChild(east, QuadTree::NW));
+			makeHorizontalNeighbors(sw, getChild(east, QuadTree::SW));
 		} else {
-			makeHorizontalNeighbors(ne, east->children.NW.get());
-			if (se != nullptr) {
-				makeHorizontalNeighbors(se, east->children.SW.get());
+			makeHorizontalNeighbors(ne, getChild(east, QuadTree::NW));
+			if (se != NONE) {
+				makeHorizontalNeighbors(se, getChild(east, QuadTree::SW));
 			}
 		}
 	} else {
-		if (ne == nullptr) {
-			nw->neighbors.EAST = east;
-			sw->neighbors.EAST = east;
+		if (ne == NONE) {
+			nodes[nw].neighbors[QuadTree::EAST] = east;
+			nodes[sw].neighbors[QuadTree::EAST] = east;
 		} else {
-			ne->neighbors.EAST = east;
-			if (se != nullptr) {
-				se->neighbors.EAST = east;
+			nodes[ne].neighbors[QuadTree::EAST] = east;
+			if (se != NONE) {
+				nodes[se].neighbors[QuadTree::EAST] = east;
 			}
 		}
 	}
 
 	// south side
-	if (south && south->getWidth() > width) { // south must be split
-		if (south->isLeaf()) {
-			south->split();
-		}
-		QuadTree * neighbor = (parent != nullptr && parent->children.SE.get() == this) ? south->children.NE.get() : south->children.NW.get();
-		if (sw == nullptr) {
-			nw->neighbors.SOUTH = neighbor;
-			ne->neighbors.SOUTH = neighbor;
+	if (south != NONE && nodes[south].width > current.width) { // south must be split
+		if (nodes[south].isLeaf()) {
+			split(south);
+		}
+		const uint32_t neighbor = isChild(node, QuadTree::SE) ? getChild(south, QuadTree::NE) : getChild(south, QuadTree::NW);
+		if (sw == NONE) {
+			nodes[nw].neighbors[QuadTree::SOUTH] = neighbor;
+			nodes[ne].neighbors[QuadTree::SOUTH] = neighbor;
 		} else {
-			sw->neighbors.SOUTH = neighbor;
-			if (se != nullptr)
-				se->neighbors.SOUTH = neighbor;
-		}
-	} else if (south && !south->isLeaf()) {
-		if (sw == nullptr) {
-			makeVerticalNeighbors(nw, south->children.NW.get());
-			makeVerticalNeighbors(ne, south->children.NE.get());
+			nodes[sw].neighbors[QuadTree::SOUTH] = neighbor;
+			if (se != NONE)
+				nodes[se].neighbors[QuadTree::SOUTH] = neighbor;
+		}
+	} else if (south != NONE && !nodes[south].isLeaf()) {
+		if (sw == NONE) {
+			makeVerticalNeighbors(nw, getChild(south, QuadTree::NW));
+			makeVerticalNeighbors(ne, getChild(south, QuadTree::NE));
 		} else {
-			makeVerticalNeighbors(sw, south->children.NW.get());
-			if (se != nullptr) {
-				makeVerticalNeighbors(se, south->children.NE.get());
+			makeVerticalNeighbors(sw, getChild(south, QuadTree::NW));
+			if (se != NONE) {
+				makeVerticalNeighbors(se, getChild(south, QuadTree::NE));
 			}
 		}
 	} else {
-		if (sw == nullptr) {
-			nw->neighbors.SOUTH = south;
-			ne->neighbors.SOUTH = south;
+		if (sw == NONE) {
+			nodes[nw].neighbors[QuadTree::SOUTH] = south;
+			nodes[ne].neighbors[QuadTree::SOUTH] = south;
 		} else {
-			sw->neighbors.SOUTH = south;
-			if (se != nullptr) {
-				se->neighbors.SOUTH = south;
+			nodes[sw].neighbors[QuadTree::SOUTH] = south;
+			if (se != NONE) {
+				nodes[se].neighbors[QuadTree::SOUTH] = south;
 			}
 		}
 	}
 
 
 	// arrange relation between the direct children
-	if (ne == nullptr) {
+	if (ne == NONE) {
 		makeVerticalNeighbors(nw, sw);
-	} else if (sw == nullptr) {
+	} else if (sw == NONE) {
 		makeHorizontalNeighbors(nw, ne);
 	} else {
 		makeHorizontalNeighbors(nw, ne);
@@ -234,69 +231,72 @@ void QuadtreeMeshBuilder::QuadTree::arrangeNeighbors() {
 	}
 }
 
-void QuadtreeMeshBuilder::QuadTree::collectLeaves(deque<QuadTree *> & leaves) {
-	if (isLeaf()) {
-		leaves.push_back(this);
-	} else {
-		if (children.NW) {
-			children.NW->collectLeaves(leaves);
-		}
-		if (children.NE) {
-			children.NE->collectLeaves(leaves);
-		}
-		if (children.SW) {
-			children.SW->collectLeaves(leaves);
+void QuadtreeMeshBuilder::QuadTreeArena::collectLeaves(uint32_t node, vector<uint32_t> & leaves) const {
+	if (nodes[node].isLeaf()) {
+		leaves.push_back(node);
+		return;
+	}
+	vector<uint32_t> stack(1, node);
+	while (!stack.empty()) {
+		const QuadTree & current = nodes[stack.back()];
+		const uint32_t index = stack.back();
+		stack.pop_back();
+		if (current.isLeaf()) {
+			leaves.push_back(index);
+			continue;
 		}
-		if (children.SE) {
-			children.SE->collectLeaves(leaves);
+		// push in reverse order to collect the leaves in the order NW, NE, SW, SE
+		for (uint_fast8_t child = 4; child-- > 0;) {
+			if (current.children[child] != QuadTree::INVALID_NODE) {
+				stack.push_back(current.children[child]);
+			}
 		}
 	}
 }
 
-uint8_t QuadtreeMeshBuilder::QuadTree::collectVertices(std::vector<QuadtreeMeshBuilder::vertex_t> & vertices) const {
+uint8_t QuadtreeMeshBuilder::QuadTreeArena::collectVertices(uint32_t node, std::vector<QuadtreeMeshBuilder::vertex_t> & vertices) const {
+	const QuadTree & current = nodes[node];
+	const auto isSplit = [&](QuadTree::side_t side) {
+		const uint32_t neighbor = current.neighbors[side];
+		return neighbor != QuadTree::INVALID_NODE && !nodes[neighbor].isLeaf();
+	};
 	uint8_t pattern = 0x00;
 
-	const uint16_t widthHalf = width - width / 2u;
-	const uint16_t heightHalf = height - height / 2u;
+	const uint16_t widthHalf = current.width - current.width / 2u;
+	const uint16_t heightHalf = current.height - current.height / 2u;
+	const uint16_t x = current.x;
+	const uint16_t y = current.y;
 	const uint16_t xHalf = x + widthHalf;
 	const uint16_t yHalf = y + heightHalf;
-	const uint16_t xFull = x + width;
-	const uint16_t yFull = y + height;
+	const uint16_t xFull = x + current.width;
+	const uint16_t yFull = y + current.height;
 	// South-West corner
 	vertices.emplace_back(x, yFull);
-	{ // West side
-		QuadTree * neighbor = neighbors.WEST;
-		if (neighbor != nullptr && !neighbor->isLeaf()) {
-			vertices.emplace_back(x, yHalf);
-			pattern |= 0x01;
-		}
+	// West side
+	if (isSplit(QuadTree::WEST)) {
+		vertices.emplace_back(x, yHalf);
+		pattern |= 0x01;
 	}
 	// North-west corner
 	vertices.emplace_back(x, y);
-	{ // North side
-		QuadTree *neighbor = neighbors.NORTH;
-		if (neighbor && !neighbor->isLeaf()) {
-			vertices.emplace_back(xHalf, y);
-			pattern |= 0x02;
-		}
+	// North side
+	if (isSplit(QuadTree::NORTH)) {
+		vertices.emplace_back(xHalf, y);
+		pattern |= 0x02;
 	}
 	// North-east corner
 	vertices.emplace_back(xFull, y);
-	{ // East side
-		QuadTree * neighbor = neighbors.EAST;
-		if (neighbor && !neighbor->isLeaf()) {
-			vertices.emplace_back(xFull, yHalf);
-			pattern |= 0x04;
-		}
+	// East side
+	if (isSplit(QuadTree::EAST)) {
+		vertices.emplace_back(xFull, yHalf);
+		pattern |= 0x04;
 	}
 	// South-East corner
 	vertices.emplace_back(xFull, yFull);
-	{ // South side
-		QuadTree * neighbor = neighbors.SOUTH;
-		if (neighbor && !neighbor->isLeaf()) {
-			vertices.emplace_back(xHalf, yFull);
-			pattern |= 0x08;
-		}
+	// South side
+	if (isSplit(QuadTree::SOUTH)) {
+		vertices.emplace_back(xHalf, yFull);
+		pattern |= 0x08;
 	}
 	return pattern;
 }
@@ -326,11 +326,11 @@ QuadtreeMeshBuilder::DepthSplitFunction::DepthSplitFunction(Util::Reference<Util
 	}
 }
 
-bool QuadtreeMeshBuilder::DepthSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
-	const uint16_t xMin = node->getX();
-	const uint16_t yMin = node->getY();
-	const uint16_t xMax = node->getWidth() + xMin;
-	const uint16_t yMax = node->getHeight() + yMin;
+bool QuadtreeMeshBuilder::DepthSplitFunction::operator()(const QuadtreeMeshBuilder::QuadTree & node) {
+	const uint16_t xMin = node.getX();
+	const uint16_t yMin = node.getY();
+	const uint16_t xMax = node.getWidth() + xMin;
+	const uint16_t yMax = node.getHeight() + yMin;
 
 	const float minDisruption = disruptionFactor * (maxDepth - minDepth);
 	// If there is a continuous change of depth values, then do not split.
@@ -376,11 +376,11 @@ QuadtreeMeshBuilder::ColorSplitFunction::ColorSplitFunction(Util::Reference<Util
 	}
 }
 
-bool QuadtreeMeshBuilder::ColorSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
-	const uint16_t xMin = node->getX();
-	const uint16_t yMin = node->getY();
-	const uint16_t xMax = node->getWidth() + xMin;
-	const uint16_t yMax = node->getHeight() + yMin;
+bool QuadtreeMeshBuilder::ColorSplitFunction::operator()(const QuadtreeMeshBuilder::QuadTree & node) {
+	const uint16_t xMin = node.getX();
+	const uint16_t yMin = node.getY();
+	const uint16_t xMax = node.getWidth() + xMin;
+	const uint16_t yMax = node.getHeight() + yMin;
 
 	const uint16_t minDisruption = 255;
 	// If there is a continuous change of color values, then do not split.
@@ -429,11 +429,11 @@ QuadtreeMeshBuilder::StencilSplitFunction::StencilSplitFunction(Util::Reference<
 	}
 }
 
-bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(QuadtreeMeshBuilder::QuadTree * node) {
-	const uint16_t xMin = node->getX();
-	const uint16_t yMin = node->getY();
-	const uint16_t xMax = node->getWidth() + xMin;
-	const uint16_t yMax = node->getHeight() + yMin;
+bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(const QuadtreeMeshBuilder::QuadTree & node) {
+	const uint16_t xMin = node.getX();
+	const uint16_t yMin = node.getY();
+	const uint16_t xMax = node.getWidth() + xMin;
+	const uint16_t yMax = node.getHeight() + yMin;
 
 	// If there is a disruption of stencil values, then split.
 	for (uint_fast16_t y = yMin; y < yMax; ++y) {
@@ -460,52 +460,122 @@ bool QuadtreeMeshBuilder::StencilSplitFunction::operator()(QuadtreeMeshBuilder::
 // ############################################## QuadtreeMeshBuilder ###################################################
 
 static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
-static void addTriangle(MeshBuilder & builder, uint32_t a, uint32_t b, uint32_t c) {
+
+//! Number of leaves processed as one task when creating the vertices and triangles.
+static const uint32_t LEAF_GRAIN_SIZE = 4096;
+
+//! Triangles of a single leaf (at most six).
+struct LeafTriangles {
+	uint32_t indices[18];
+	uint32_t count = 0;
+};
+
+static void addTriangle(LeafTriangles & triangles, uint32_t a, uint32_t b, uint32_t c) {
 	if(a != INVALID_INDEX && b != INVALID_INDEX && c != INVALID_INDEX) {
-		builder.addTriangle(a, b, c);
+		uint32_t * target = triangles.indices + 3 * triangles.count++;
+		target[0] = a;
+		target[1] = b;
+		target[2] = c;
 	}
 }
 
-static void buildFaceTypeA(MeshBuilder & builder, const vector<uint32_t> & indices) {
-	addTriangle(builder, indices[0], indices[1], indices[3]);
-	addTriangle(builder, indices[1], indices[2], indices[3]);
+static void buildFaceTypeA(LeafTriangles & triangles, const vector<uint32_t> & indices) {
+	addTriangle(triangles, indices[0], indices[1], indices[3]);
+	addTriangle(triangles, indices[1], indices[2], indices[3]);
 }
 
-static void buildFaceTypeB(MeshBuilder & builder, const vector<uint32_t> & indices, uint32_t basis) {
-	addTriangle(builder, indices[basis], indices[(basis+1)%5], indices[(basis+4)%5]);
-	addTriangle(builder, indices[(basis+1)%5], indices[(basis+2)%5], indices[(basis+3)%5]);
-	addTriangle(builder, indices[(basis+3)%5], indices[(basis+4)%5], indices[(basis+1)%5]);
+static void buildFaceTypeB(LeafTriangles & triangles, const vector<uint32_t> & indices, uint32_t basis) {
+	addTriangle(triangles, indices[basis], indices[(basis+1)%5], indices[(basis+4)%5]);
+	addTriangle(triangles, indices[(basis+1)%5], indices[(basis+2)%5], indices[(basis+3)%5]);
+	addTriangle(triangles, indices[(basis+3)%5], indices[(basis+4)%5], indices[(basis+1)%5]);
 }
 
-static void buildFaceTypeC(MeshBuilder & builder, const vector<uint32_t> & indices, uint32_t basis) {
-	addTriangle(builder, indices[basis], indices[(basis+1)%6], indices[(basis+5)%6]);
-	addTriangle(builder, indices[(basis+1)%6], indices[(basis+2)%6], indices[(basis+3)%6]);
-	addTriangle(builder, indices[(basis+3)%6], indices[(basis+4)%6], indices[(basis+5)%6]);
-	addTriangle(builder, indices[(basis+1)%6], indices[(basis+3)%6], indices[(basis+5)%6]);
+static void buildFaceTypeC(LeafTriangles & triangles, const vector<uint32_t> & indices, uint32_t basis) {
+	addTriangle(triangles, indices[basis], indices[(basis+1)%6], indices[(basis+5)%6]);
+	addTriangle(triangles, indices[(basis+1)%6], indices[(basis+2)%6], indices[(basis+3)%6]);
+	addTriangle(triangles, indices[(basis+3)%6], indices[(basis+4)%6], indices[(basis+5)%6]);
+	addTriangle(triangles, indices[(basis+1)%6], indices[(basis+3)%6], indices[(basis+5)%6]);
 }
 
-static void buildFaceTypeD(MeshBuilder & builder, const vector<uint32_t> & indices, uint32_t basis) {
-	addTriangle(builder, indices[basis], indices[(basis+1)%6], indices[(basis+5)%6]);
-	addTriangle(builder, indices[(basis+1)%6], indices[(basis+2)%6], indices[(basis+4)%6]);
-	addTriangle(builder, indices[(basis+2)%6], indices[(basis+3)%6], indices[(basis+4)%6]);
-	addTriangle(builder, indices[(basis+1)%6], indices[(basis+4)%6], indices[(basis+5)%6]);
+static void buildFaceTypeD(LeafTriangles & triangles, const vector<uint32_t> & indices, uint32_t basis) {
+	addTriangle(triangles, indices[basis], indices[(basis+1)%6], indices[(basis+5)%6]);
+	addTriangle(triangles, indices[(basis+1)%6], indices[(basis+2)%6], indices[(basis+4)%6]);
+	addTriangle(triangles, indices[(basis+2)%6], indices[(basis+3)%6], indices[(basis+4)%6]);
+	addTriangle(triangles, indices[(basis+1)%6], indices[(basis+4)%6], indices[(basis+5)%6]);
 }
 
-static void buildFaceTypeE(MeshBuilder & builder, const vector<uint32_t> & indices, uint32_t basis) {
-	addTriangle(builder, indices[basis], indices[(basis+1)%7], indices[(basis+6)%7]);
-	addTriangle(builder, indices[(basis+1)%7], indices[(basis+2)%7], indices[(basis+6)%7]);
-	addTriangle(builder, indices[(basis+2)%7], indices[(basis+3)%7], indices[(basis+4)%7]);
-	addTriangle(builder, indices[(basis+4)%7], indices[(basis+5)%7], indices[(basis+6)%7]);
-	addTriangle(builder, indices[(basis+2)%7], indices[(basis+4)%7], indices[(basis+6)%7]);
+static void buildFaceTypeE(LeafTriangles & triangles, const vector<uint32_t> & indices, uint32_t basis) {
+	addTriangle(triangles, indices[basis], indices[(basis+1)%7], indices[(basis+6)%7]);
+	addTriangle(triangles, indices[(basis+1)%7], indices[(basis+2)%7], indices[(basis+6)%7]);
+	addTriangle(triangles, indices[(basis+2)%7], indices[(basis+3)%7], indices[(basis+4)%7]);
+	addTriangle(triangles, indices[(basis+4)%7], indices[(basis+5)%7], indices[(basis+6)%7]);
+	addTriangle(triangles, indices[(basis+2)%7], indices[(basis+4)%7], indices[(basis+6)%7]);
 }
 
-static void buildFaceTypeF(MeshBuilder & builder, const vector<uint32_t> & indices) {
-	addTriangle(builder, indices[0], indices[1], indices[7]);
-	addTriangle(builder, indices[1], indices[2], indices[3]);
-	addTriangle(builder, indices[3], indices[4], indices[5]);
-	addTriangle(builder, indices[5], indices[6], indices[7]);
-	addTriangle(builder, indices[3], indices[5], indices[7]);
-	addTriangle(builder, indices[1], indices[3], indices[7]);
+static void buildFaceTypeF(LeafTriangles & triangles, const vector<uint32_t> & indices) {
+	addTriangle(triangles, indices[0], indices[1], indices[7]);
+	addTriangle(triangles, indices[1], indices[2], indices[3]);
+	addTriangle(triangles, indices[3], indices[4], indices[5]);
+	addTriangle(triangles, indices[5], indices[6], indices[7]);
+	addTriangle(triangles, indices[3], indices[5], indices[7]);
+	addTriangle(triangles, indices[1], indices[3], indices[7]);
+}
+
+static void buildFaces(LeafTriangles & triangles, const vector<uint32_t> & indices, uint8_t pattern) {
+	triangles.count = 0;
+	switch (pattern) {
+		case 0: // 0000
+			buildFaceTypeA(triangles, indices);
+			break;
+		case 1: // 0001
+			buildFaceTypeB(triangles, indices, 0);
+			break;
+		case 2: // 0010
+			buildFaceTypeB(triangles, indices, 1);
+			break;
+		case 4: // 0100
+			buildFaceTypeB(triangles, indices, 2);
+			break;
+		case 8: // 1000
+			buildFaceTypeB(triangles, indices, 3);
+			break;
+		case 3: // 0011
+			buildFaceTypeC(triangles, indices, 0);
+			break;
+		case 6: // 0110
+			buildFaceTypeC(triangles, indices, 1);
+			break;
+		case 12: // 1100
+			buildFaceTypeC(triangles, indices, 0);
+			break;
+		case 9: // 1001
+			buildFaceTypeC(triangles, indices, 0);
+			break;
+		case 5: // 0101
+			buildFaceTypeD(triangles, indices, 0);
+			break;
+		case 10: // 1010
+			buildFaceTypeD(triangles, indices, 1);
+			break;
+		case 7: // 0111
+			buildFaceTypeE(triangles, indices, 6);
+			break;
+		case 11: // 1011
+			buildFaceTypeE(triangles, indices, 4);
+			break;
+		case 13: // 1101
+			buildFaceTypeE(triangles, indices, 2);
+			break;
+		case 14: // 1110
+			buildFaceTypeE(triangles, indices, 0);
+			break;
+		case 15: // 1111
+			buildFaceTypeF(triangles, indices);
+			break;
+		default:
+			WARN("Invalid pattern.");
+			break;
+	}
 }
 
 Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
@@ -524,158 +594,169 @@ Mesh * QuadtreeMeshBuilder::createMesh(const VertexDescription& vd,
 	const uint16_t width  = static_cast<uint16_t>(depthReader->getWidth()) - 1;
 	const uint16_t height = static_cast<uint16_t>(depthReader->getHeight()) - 1;
 
-	// 1: create queue used to build up a quad-tree (it usually contains the leaves, but could also contain some inner nodes)
-	deque<QuadTree*> quadtrees;
+	// 1: create the root quad-tree; 'pending' contains the leaves that still have to be tested
+	QuadTreeArena tree(width, height);
+	vector<uint32_t> pending(1, QuadTreeArena::ROOT);
+	vector<uint32_t> nextPending;
+	vector<uint8_t> splitRequests;
+
+	// 2: refine the tree level by level
+	while (!pending.empty()) {
+		// 2-A: evaluate the split function for all pending leaves in parallel (the tree is not modified meanwhile)
+		splitRequests.assign(pending.size(), 0);
+		Parallel::forEach(0, static_cast<uint32_t>(pending.size()), [&](uint32_t i) {
+			if (tree[pending[i]].isLeaf())
+				splitRequests[i] = function(tree[pending[i]]) ? 1 : 0;
+		});
+
+		// 2-B: perform the splits; balancing is implicitly done during every splitting-step
+		nextPending.clear();
+		for (size_t i = 0; i < pending.size(); ++i) {
+			const uint32_t node = pending[i];
+			if (!tree[node].isLeaf()) { // node has been already split during balancing
+				tree.collectLeaves(node, nextPending);
+			} else if (splitRequests[i] != 0 && tree.split(node)) {
+				tree.collectLeaves(node, nextPending);
+			}
+		}
+		pending.swap(nextPending);
+	}
 
-	// 2: create the root quad-tree and add it to the queue
-	QuadTree root(0, 0, width, height);
-	quadtrees.push_back(&root);
+	// 3: collect the quadtree-leaves
+	vector<uint32_t> leaves;
+	tree.collectLeaves(QuadTreeArena::ROOT, leaves);
+	const uint32_t leafCount = static_cast<uint32_t>(leaves.size());
 
-	// 3: as long as there are further leaf-nodes
-	while (!quadtrees.empty()) {
-		QuadTree* quadtree = quadtrees.front();
-		quadtrees.pop_front();
+#ifndef NDEBUG
+	createDebugOutput(tree, leaves, depthReader.get(), colorReader.get());
+#endif
 
-		if (!quadtree->isLeaf()) { // node has been already split during balancing
-			quadtree->collectLeaves(quadtrees);
-			continue;
+	// 4: mark the grid points used by the leaves
+	const uint32_t gridWidth = width + 1u;
+	const uint32_t gridHeight = height + 1u;
+	std::unique_ptr<std::atomic<uint8_t>[]> used(new std::atomic<uint8_t>[static_cast<size_t>(gridWidth) * gridHeight]());
+	Parallel::forRange(0, leafCount, LEAF_GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		vector<vertex_t> vertices;
+		for (uint32_t leaf = begin; leaf < end; ++leaf) {
+			vertices.clear();
+			tree.collectVertices(leaves[leaf], vertices);
+			for (const auto & vertex : vertices) {
+				used[static_cast<size_t>(vertex.second) * gridWidth + vertex.first].store(1, std::memory_order_relaxed);
+			}
 		}
-
-		// split the quadtree if necessary
-		if (function(quadtree)) {
-			if (quadtree->split()) {
-				quadtree->collectLeaves(quadtrees);
+	});
+
+	// 5: number the vertices row by row (first relative to their row); pixels with a stencil value of zero belong to the background and get no vertex
+	vector<uint32_t> vertexIndices(static_cast<size_t>(gridWidth) * gridHeight, INVALID_INDEX);
+	vector<uint32_t> rowOffsets(gridHeight + 1, 0);
+	Parallel::forEach(0, gridHeight, [&](uint32_t y) {
+		uint32_t count = 0;
+		for (uint32_t x = 0; x < gridWidth; ++x) {
+			const size_t key = static_cast<size_t>(y) * gridWidth + x;
+			if (used[key].load(std::memory_order_relaxed) != 0 && (stencilReader.isNull() || stencilReader->readSingleValueByte(x, y) != 0)) {
+				vertexIndices[key] = count++;
 			}
 		}
+		rowOffsets[y + 1] = count;
+	});
+	used.reset();
+	std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+	const uint32_t vertexCount = rowOffsets.back();
+	if (vertexCount == 0) {
+		WARN("QuadtreeMeshBuilder: Empty mesh.");
+		return nullptr;
 	}
 
+	// 6: count the triangles of each block of leaves
+	const auto buildLeafFaces = [&](uint32_t leaf, vector<vertex_t> & vertices, vector<uint32_t> & indices, LeafTriangles & triangles) {
+		vertices.clear();
+		indices.clear();
+		const uint8_t pattern = tree.collectVertices(leaf, vertices);
+		for (const auto & vertex : vertices) {
+			indices.push_back(vertexIndices[static_cast<size_t>(vertex.second) * gridWidth + vertex.first]);
+		}
+		buildFaces(triangles, indices, pattern);
+	};
+	const uint32_t blockCount = (leafCount + LEAF_GRAIN_SIZE - 1) / LEAF_GRAIN_SIZE;
+	vector<uint32_t> blockOffsets(blockCount + 1, 0);
+	Parallel::forRange(0, leafCount, LEAF_GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		vector<vertex_t> vertices;
+		vector<uint32_t> indices;
+		LeafTriangles triangles;
+		uint32_t count = 0;
+		for (uint32_t leaf = begin; leaf < end; ++leaf) {
+			buildLeafFaces(leaves[leaf], vertices, indices, triangles);
+			count += triangles.count;
+		}
+		blockOffsets[begin / LEAF_GRAIN_SIZE + 1] = count;
+	});
+	std::partial_sum(blockOffsets.begin(), blockOffsets.end(), blockOffsets.begin());
+	const uint32_t triangleCount = blockOffsets.back();
+
+	// 7: create the vertices
+	auto mesh = new Mesh(vd, vertexCount, 3 * triangleCount);
+	MeshVertexData & vertexData = mesh->openVertexData();
+	const VertexDescription & description = vertexData.getVertexDescription();
+	const bool hasColor = description.hasAttribute(VertexAttributeIds::COLOR);
+	const bool hasNormal = normalReader.isNotNull() && description.hasAttribute(VertexAttributeIds::NORMAL);
+	const bool hasTexCoord = description.hasAttribute(VertexAttributeIds::TEXCOORD0);
+	auto accessor = VertexAccessor::create(vertexData);
 
-	// 4: balancing is implicitly done during every splitting-step
-
-	// 5: create the mesh
-	MeshBuilder builder(vd);
 	const float xScale = 2.0f / static_cast<float>(width);
 	const float yScale = 2.0f / static_cast<float>(height);
 	const float uScale = 1.0f / static_cast<float>(width);
 	const float vScale = 1.0f / static_cast<float>(height);
+	Parallel::forEach(0, gridHeight, [&](uint32_t y) {
+		for (uint32_t x = 0; x < gridWidth; ++x) {
+			uint32_t & index = vertexIndices[static_cast<size_t>(y) * gridWidth + x];
+			if (index == INVALID_INDEX) {
+				continue;
+			}
+			index += rowOffsets[y];
 
-	// 5-A: collect the quadtree-leaves
-	deque<QuadTree*> leaves;
-	root.collectLeaves(leaves);
-
-#ifndef NDEBUG
-	createDebugOutput(leaves, depthReader.get(), colorReader.get());
-#endif
-
-	// 5-B: as long as there are leaves
-	map<vertex_t, uint32_t> indexMap; // index map containing indices to already created vertices
-	vector<uint32_t> indices;
-	vector<vertex_t> vertices;
-	indices.reserve(8);
-	vertices.reserve(8);
-
+			const float depthValue = depthReader->readSingleValueFloat(x, y);
+			accessor->setPosition(index, Geometry::Vec3(xScale * x - 1.0f, yScale * y - 1.0f, 2.0f * depthValue - 1.0f));
 
-	while (!leaves.empty()) {
-		QuadTree * quadtree = leaves.front();
-		leaves.pop_front();
+			if (hasColor) {
+				accessor->setColor(index, colorReader.isNotNull() ? colorReader->readColor4f(x, y) : Util::Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+			}
 
-		indices.clear();
-		vertices.clear();
+			if (hasNormal) {
+				const Util::Color4ub normalColor = normalReader->readColor4ub(x, y);
+				const Geometry::Vec3b normal(normalColor.getR() - 128, normalColor.getG() - 128, normalColor.getB() - 128);
+				accessor->setNormal(index, Geometry::Vec3(normal));
+			}
 
-		uint8_t pattern = 0x00; // pattern coding the side containing additional vertex with "1"
-
-		// determine the pattern and collect indices
-		pattern = quadtree->collectVertices(vertices);
-		for(const auto & vertex : vertices) {
-			const uint16_t x = vertex.first;
-			const uint16_t y = vertex.second;
-			auto lb = indexMap.lower_bound(vertex);
-			if(lb != indexMap.end() && !(indexMap.key_comp()(vertex, lb->first))) {
-				indices.push_back(lb->second); // try to get an index of the specified vertex
-			} else if(stencilReader.isNotNull() && stencilReader->readSingleValueByte(x, y) == 0) {
-				// Generate a dummy vertex only, because the pixel belongs to the background
-				indexMap.insert(lb, std::make_pair(vertex, INVALID_INDEX));
-				indices.push_back(INVALID_INDEX);
-			} else {
-				// create new position
-				const float depthValue = depthReader->readSingleValueFloat(x, y);
-
-				builder.position(Geometry::Vec3(xScale * x - 1.0f, yScale * y - 1.0f, 2.0f * depthValue - 1.0f));
-
-				if(colorReader.isNotNull()) {
-					builder.color(colorReader->readColor4f(x, y));
-				}
-
-				if(normalReader.isNotNull()) {
-					const Util::Color4ub normalColor = normalReader->readColor4ub(x, y);
-					const Geometry::Vec3b normal(normalColor.getR() - 128, normalColor.getG() - 128, normalColor.getB() - 128);
-					builder.normal(normal);
-				}
-
-				builder.texCoord0(Geometry::Vec2(x * uScale, y * vScale));
-
-				const uint32_t index = builder.addVertex();
-				indexMap.insert(lb, std::make_pair(vertex, index)); // insert into the indexMap
-				indices.push_back(index);
+			if (hasTexCoord) {
+				accessor->setTexCoord(index, Geometry::Vec2(x * uScale, y * vScale));
 			}
 		}
+	});
+	accessor = nullptr;
+	vertexData.markAsChanged();
+	vertexData.updateBoundingBox();
+
+	// 8: create the triangles
+	MeshIndexData & indexData = mesh->openIndexData();
+	uint32_t * indexTarget = indexData.data();
+	Parallel::forRange(0, leafCount, LEAF_GRAIN_SIZE, [&](uint32_t begin, uint32_t end) {
+		vector<vertex_t> vertices;
+		vector<uint32_t> indices;
+		LeafTriangles triangles;
+		uint32_t * target = indexTarget + 3 * blockOffsets[begin / LEAF_GRAIN_SIZE];
+		for (uint32_t leaf = begin; leaf < end; ++leaf) {
+			buildLeafFaces(leaves[leaf], vertices, indices, triangles);
+			target = std::copy(triangles.indices, triangles.indices + 3 * triangles.count, target);
+		}
+	});
+	if (triangleCount > 0) {
+		indexData.markAsChanged();
+		indexData.updateIndexRange();
+	} else {
+		mesh->setUseIndexData(false);
+	}
 
-		switch (pattern) {
-			case 0: // 0000
-				buildFaceTypeA(builder, indices);
-				break;
-			case 1: // 0001
-				buildFaceTypeB(builder, indices, 0);
-				break;
-			case 2: // 0010
-				buildFaceTypeB(builder, indices, 1);
-				break;
-			case 4: // 0100
-				buildFaceTypeB(builder, indices, 2);
-				break;
-			case 8: // 1000
-				buildFaceTypeB(builder, indices, 3);
-				break;
-			case 3: // 0011
-				buildFaceTypeC(builder, indices, 0);
-				break;
-			case 6: // 0110
-				buildFaceTypeC(builder, indices, 1);
-				break;
-			case 12: // 1100
-				buildFaceTypeC(builder, indices, 0);
-				break;
-			case 9: // 1001
-				buildFaceTypeC(builder, indices, 0);
-				break;
-			case 5: // 0101
-				buildFaceTypeD(builder, indices, 0);
-				break;
-			case 10: // 1010
-				buildFaceTypeD(builder, indices, 1);
-				break;
-			case 7: // 0111
-				buildFaceTypeE(builder, indices, 6);
-				break;
-			case 11: // 1011
-				buildFaceTypeE(builder, indices, 4);
-				break;
-			case 13: // 1101
-				buildFaceTypeE(builder, indices, 2);
-				break;
-			case 14: // 1110
-				buildFaceTypeE(builder, indices, 0);
-				break;
-			case 15: // 1111
-				buildFaceTypeF(builder, indices);
-				break;
-			default:
-				WARN("Invalid pattern.");
-				break;
-		}
-	}
-
-	return builder.buildMesh();
+	return mesh;
 }
 
 }
@@ -15,7 +15,6 @@
 #include <cstdint>
 #include <deque>
 #include <functional>
-#include <memory>
 #include <utility>
 #include <vector>
 
@@ -37,27 +36,29 @@ class QuadtreeMeshBuilder {
 public:
 	typedef std::pair<uint16_t, uint16_t> vertex_t;
 
-	/** quad tree used to subdivide the texture into areas */
+	class QuadTreeArena;
+
+	/**
+	 * node of the quad tree used to subdivide the texture into areas.
+	 * The nodes are stored in a QuadTreeArena and reference each other by their index in the arena.
+	 */
 	class QuadTree {
+	public:
+		static constexpr uint32_t INVALID_NODE = 0xffffffff;
+		enum child_t : uint8_t { NW = 0, NE = 1, SW = 2, SE = 3 };
+		enum side_t : uint8_t { WEST = 0, NORTH = 1, EAST = 2, SOUTH = 3 };
+
 	private:
-		/** array containing the pointers to the four children. */
-		struct {
-			std::unique_ptr<QuadTree> NW;
-			std::unique_ptr<QuadTree> NE;
-			std::unique_ptr<QuadTree> SW;
-			std::unique_ptr<QuadTree> SE;
-		} children;
-
-		/** array containing the pointers to the neighbors */
-		struct {
-			QuadTree * WEST;
-			QuadTree * NORTH;
-			QuadTree * EAST;
-			QuadTree * SOUTH;
-		} neighbors;
+		friend class QuadTreeArena;
+
+		/** indices of the four children (NW, NE, SW, SE); NW always exists if the node has been split. */
+		uint32_t children[4];
+
+		/** indices of the neighbors (WEST, NORTH, EAST, SOUTH) */
+		uint32_t neighbors[4];
 
 		/** parent of current quad-tree node */
-		QuadTree * parent;
+		uint32_t parent;
 
 		/** x-position of the first pixel */
 		uint16_t x;
@@ -71,84 +72,109 @@ public:
 		/** the height of the texture area */
 		uint16_t height;
 
-
-	private:
-		QuadTree(const QuadTree &) = delete;
-		QuadTree(QuadTree &&) = delete;
-		QuadTree & operator=(const QuadTree &) = delete;
-		QuadTree & operator=(QuadTree &&) = delete;
 	public:
-		/** [ctor] creates a QuadTree-root width specified x, y, width and height */
-		RENDERINGAPI QuadTree(uint16_t x, uint16_t y, uint16_t _width, uint16_t _height);
-
 		/** [ctor] creates a QuadTree-node with specified parent, x, y, width and height */
-		RENDERINGAPI QuadTree(QuadTree * parent, uint16_t x, uint16_t y, uint16_t _width, uint16_t _height);
-
-		/** [dtor] */
-		RENDERINGAPI ~QuadTree();
+		QuadTree(uint32_t _parent, uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height) :
+			children{INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE},
+			neighbors{INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE},
+			parent(_parent), x(_x), y(_y), width(_width), height(_height) {
+		}
 
 		/**
 		 * checks whether current quad-tree is leaf (has got no children)
 		 * @return true if current quad-tree has no children, otherwise false
 		 */
-		inline bool isLeaf() const			{	return (!children.NW && !children.NE && !children.SW && !children.SE);	}
+		inline bool isLeaf() const			{	return children[NW] == INVALID_NODE;	}
 
 		inline uint16_t getWidth() const	{	return this->width;			}
 		inline uint16_t getHeight() const	{	return this->height;		}
 		inline uint16_t getX() const		{	return this->x;				}
 		inline uint16_t getY() const 		{	return this->y;				}
 
-		const QuadTree * getParent() const			{	return parent;	}
+		uint32_t getParent() const					{	return parent;				}
+		uint32_t getNeighbor(side_t side) const		{	return neighbors[side];		}
+		uint32_t getChild(child_t child) const		{	return children[child];		}
+	};
 
-		const QuadTree * getWestNeighbor() const	{	return neighbors.WEST;	}
-		const QuadTree * getNorthNeighbor() const	{	return neighbors.NORTH;	}
-		const QuadTree * getEastNeighbor() const	{	return neighbors.EAST;	}
-		const QuadTree * getSouthNeighbor() const	{	return neighbors.SOUTH;	}
+	/**
+	 * Contiguous storage for the nodes of a quad tree.
+	 * The root has the index ROOT; nodes are never removed, so indices stay valid while the tree grows.
+	 */
+	class QuadTreeArena {
+	public:
+		static constexpr uint32_t ROOT = 0;
 
-		const QuadTree * getNorthWestChild() const	{	return children.NW.get();		}
-		const QuadTree * getNorthEastChild() const	{	return children.NE.get();		}
-		const QuadTree * getSouthWestChild() const	{	return children.SW.get();		}
-		const QuadTree * getSouthEastChild() const	{	return children.SE.get();		}
+		/** [ctor] creates the root node covering the area (0, 0, width, height) */
+		RENDERINGAPI QuadTreeArena(uint16_t width, uint16_t height);
+
+		const QuadTree & operator[](uint32_t node) const	{	return nodes[node];		}
+		uint32_t size() const								{	return static_cast<uint32_t>(nodes.size());	}
+		//! Returns the neighbor on the given side or nullptr.
+		const QuadTree * getNeighbor(uint32_t node, QuadTree::side_t side) const {
+			const uint32_t neighbor = nodes[node].neighbors[side];
+			return neighbor == QuadTree::INVALID_NODE ? nullptr : &nodes[neighbor];
+		}
 
 		/**
-		 * simply tries to split the current node into four smaller nodes
+		 * simply tries to split the given node into four smaller nodes.
+		 * Neighbors that are more than one level coarser are split as well (balancing).
 		 * @return true if splitting was successful, or false if the node has been already split
 		 */
-		RENDERINGAPI bool split();
+		RENDERINGAPI bool split(uint32_t node);
+
+		/**
+		 * collects all leaf-nodes from the node's subtree (depth-first, without recursion)
+		 * @param leaves : list to that the indices of all leaves will be appended
+		 */
+		RENDERINGAPI void collectLeaves(uint32_t node, std::vector<uint32_t> & leaves) const;
 
 		/**
-		 * collects all leaf-nodes from current node's subtree
-		 * @param leaves : list to that all leaves will be collected
+		 * collects the corners of a leaf and the midpoints of the sides with split neighbors (counter-clockwise, starting at the south-west corner)
+		 * @return pattern coding the sides containing an additional vertex (west: 1, north: 2, east: 4, south: 8)
 		 */
-		RENDERINGAPI void collectLeaves(std::deque<QuadTree *> & leaves);
-		RENDERINGAPI uint8_t collectVertices(std::vector<vertex_t> & vertices) const;
+		RENDERINGAPI uint8_t collectVertices(uint32_t node, std::vector<vertex_t> & vertices) const;
 
 	private:
+		std::vector<QuadTree> nodes;
+
 		/**
 		 * arranges the neighbors and performs balancing the quadtree
 		 */
-		RENDERINGAPI void arrangeNeighbors();
+		void arrangeNeighbors(uint32_t node);
+		bool isChild(uint32_t node, QuadTree::child_t child) const {
+			const uint32_t parent = nodes[node].parent;
+			return parent != QuadTree::INVALID_NODE && nodes[parent].children[child] == node;
+		}
+		uint32_t getChild(uint32_t node, QuadTree::child_t child) const {
+			return node == QuadTree::INVALID_NODE ? QuadTree::INVALID_NODE : nodes[node].children[child];
+		}
 
-		static void makeHorizontalNeighbors(QuadTree * left, QuadTree * right) {
-			if(left != nullptr) {
-				left->neighbors.EAST = right;
+		void makeHorizontalNeighbors(uint32_t left, uint32_t right) {
+			if(left != QuadTree::INVALID_NODE) {
+				nodes[left].neighbors[QuadTree::EAST] = right;
 			}
-			if(right != nullptr) {
-				right->neighbors.WEST = left;
+			if(right != QuadTree::INVALID_NODE) {
+				nodes[right].neighbors[QuadTree::WEST] = left;
 			}
 		}
-		static void makeVerticalNeighbors(QuadTree * top, QuadTree * bottom) {
-			if(top != nullptr) {
-				top->neighbors.SOUTH = bottom;
+		void makeVerticalNeighbors(uint32_t top, uint32_t bottom) {
+			if(top != QuadTree::INVALID_NODE) {
+				nodes[top].neighbors[QuadTree::SOUTH] = bottom;
 			}
-			if(bottom != nullptr) {
-				bottom->neighbors.NORTH = top;
+			if(bottom != QuadTree::INVALID_NODE) {
+				nodes[bottom].neighbors[QuadTree::NORTH] = top;
 			}
 		}
 	};
 
-	//! Type for all split functions.
-	typedef std::function<bool (QuadTree *)> split_function_t;
+	/**
+	 * Type for all split functions.
+	 * \note The split functions are called concurrently for different nodes.
+	 * \note A split function only gets the node itself (read-only); the parent and neighbor indices
+	 * (QuadTree::getParent(), QuadTree::getNeighbor()) refer to the internal QuadTreeArena and cannot be
+	 * resolved by the function.
+	 */
+	typedef std::function<bool (const QuadTree &)> split_function_t;
 
 	//! Split function that only uses the depth values.
 	class DepthSplitFunction {
@@ -170,7 +196,7 @@ public:
 			 * @param node Quad tree node that is to be analyzed
 			 * @return @c true if the specified quad tree node should be split, @c false otherwise
 			 */
-			RENDERINGAPI bool operator()(QuadTree * node);
+			RENDERINGAPI bool operator()(const QuadTree & node);
 
 		private:
 			//! Access to the depth values.
@@ -198,7 +224,7 @@ public:
 			 * @param node Quad tree node that is to be analyzed
 			 * @return @c true if the specified quad tree node should be split, @c false otherwise
 			 */
-			RENDERINGAPI bool operator()(QuadTree * node);
+			RENDERINGAPI bool operator()(const QuadTree & node);
 
 		private:
 			//! Access to the color values.
@@ -220,7 +246,7 @@ public:
 			 * @param node Quad tree node that is to be analyzed
 			 * @return @c true if the specified quad tree node should be split, @c false otherwise
 			 */
-			RENDERINGAPI bool operator()(QuadTree * node);
+			RENDERINGAPI bool operator()(const QuadTree & node);
 
 		private:
 			//! Access to the stencil values.
@@ -244,7 +270,7 @@ public:
 			 * @param node Quad tree node that is to be analyzed
 			 * @return @c true if the specified quad tree node should be split, @c false otherwise
 			 */
-			bool operator()(QuadTree * node) {
+			bool operator()(const QuadTree & node) {
 				for(auto & splitFunc : functions) {
 					if(splitFunc(node)) {
 						return true;
@@ -270,6 +296,10 @@ public:
 	 * If the stencil value of a pixel is zero, no vertices will be generated for that pixel.
 	 * @param function split function determines whether a quad-tree node requires a split
 	 * @return created mesh
+	 *
+	 * The tree is refined level by level: the split function is evaluated for all leaves of a level in parallel,
+	 * the resulting splits (including balancing) are applied sequentially. The vertices and triangles are
+	 * written in parallel directly into the mesh.
 	 */
 	RENDERINGAPI static Mesh * createMesh(const VertexDescription & vd,
 							 Util::WeakPointer<Util::PixelAccessor> depthTexture,
@@ -283,7 +313,7 @@ private:
 	~QuadtreeMeshBuilder() {}
 
 #ifndef NDEBUG
-	RENDERINGAPI static void createDebugOutput(const std::deque<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * depth, Util::PixelAccessor * color);
+	RENDERINGAPI static void createDebugOutput(const QuadTreeArena & tree, const std::vector<uint32_t> & leaves, Util::PixelAccessor * depth, Util::PixelAccessor * color);
 #endif
 };
 
@@ -49,7 +49,7 @@ static void drawLine(Util::PixelAccessor * pixelAccessor, const Util::Color4ub &
 	}
 }
 
-void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder::QuadTree *> & leaves, Util::PixelAccessor * sourceDepth, Util::PixelAccessor * sourceColor) {
+void QuadtreeMeshBuilder::createDebugOutput(const QuadTreeArena & tree, const std::vector<uint32_t> & leaves, Util::PixelAccessor * sourceDepth, Util::PixelAccessor * sourceColor) {
 	const uint32_t bitmapWidth = static_cast<uint32_t> (sourceDepth->getWidth());
 	const uint32_t bitmapHeight = static_cast<uint32_t> (sourceDepth->getHeight());
 	Util::Reference<Util::Bitmap> depthDebugBitmap = new Util::Bitmap(bitmapWidth, bitmapHeight, Util::PixelFormat::MONO_FLOAT);
@@ -79,7 +79,8 @@ void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder
 			}
 		}
 	}
-	for (const auto & leaf : leaves) {
+	for (const auto & leafIndex : leaves) {
+		const QuadtreeMeshBuilder::QuadTree * leaf = &tree[leafIndex];
 		const uint16_t xMin = leaf->getX();
 		const uint16_t yMin = leaf->getY();
 		const uint16_t xMax = leaf->getWidth() + xMin;
@@ -96,7 +97,7 @@ void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder
 		const Util::Color4ub errorColor(255, 0, 255, 255);
 
 		Util::Color4ub drawColor(255, 0, 0, 127);
-		const QuadtreeMeshBuilder::QuadTree * west = leaf->getWestNeighbor();
+		const QuadtreeMeshBuilder::QuadTree * west = tree.getNeighbor(leafIndex, QuadtreeMeshBuilder::QuadTree::WEST);
 		if(west != nullptr) {
 			const uint16_t westXHalf = west->getX() + west->getWidth() / 2;
 			const uint16_t westYHalf = west->getY() + west->getHeight() / 2;
@@ -117,7 +118,7 @@ void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder
 		}
 
 		drawColor = Util::Color4ub(255, 255, 0, 127);
-		const QuadtreeMeshBuilder::QuadTree * east = leaf->getEastNeighbor();
+		const QuadtreeMeshBuilder::QuadTree * east = tree.getNeighbor(leafIndex, QuadtreeMeshBuilder::QuadTree::EAST);
 		if(east != nullptr) {
 			const uint16_t eastXHalf = east->getX() + east->getWidth() / 2;
 			const uint16_t eastYHalf = east->getY() + east->getHeight() / 2;
@@ -138,7 +139,7 @@ void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder
 		}
 
 		drawColor = Util::Color4ub(0, 0, 255, 127);
-		const QuadtreeMeshBuilder::QuadTree * north = leaf->getNorthNeighbor();
+		const QuadtreeMeshBuilder::QuadTree * north = tree.getNeighbor(leafIndex, QuadtreeMeshBuilder::QuadTree::NORTH);
 		if(north != nullptr) {
 			const uint16_t northXHalf = north->getX() + north->getWidth() / 2;
 			const uint16_t northYHalf = north->getY() + north->getHeight() / 2;
@@ -159,7 +160,7 @@ void QuadtreeMeshBuilder::createDebugOutput(const std::deque<QuadtreeMeshBuilder
 		}
 
 		drawColor = Util::Color4ub(0, 255, 255, 127);
-		const QuadtreeMeshBuilder::QuadTree * south = leaf->getSouthNeighbor();
+		const QuadtreeMeshBuilder::QuadTree * south = tree.getNeighbor(leafIndex, QuadtreeMeshBuilder::QuadTree::SOUTH);
 		if(south != nullptr) {
 			const uint16_t southXHalf = south->getX() + south->getWidth() / 2;
 			const uint16_t southYHalf = south->getY() + south->getHeight() / 2;
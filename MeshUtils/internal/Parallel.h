@@ -0,0 +1,96 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_PARALLEL_H_
+#define RENDERING_MESHUTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! @internal
+namespace Parallel {
+
+//! Number of worker threads used for @p numTasks independent tasks (including the calling thread).
+inline uint32_t getWorkerCount(uint32_t numTasks) {
+	const uint32_t hw = std::max(1u, std::thread::hardware_concurrency());
+	return std::max(1u, std::min(hw, numTasks));
+}
+
+/**
+ * Call @p fn(i) for every i in [begin, end).
+ * The tasks are distributed dynamically over up to getWorkerCount() threads; the calling thread participates.
+ * The first exception thrown by a task is rethrown after all workers have finished.
+ * \note @p fn must be safe to be called concurrently for different i.
+ */
+template<typename Fn>
+void forEach(uint32_t begin, uint32_t end, Fn fn) {
+	if(end <= begin)
+		return;
+	const uint32_t numWorkers = getWorkerCount(end - begin);
+	if(numWorkers == 1) {
+		for(uint32_t i = begin; i < end; ++i)
+			fn(i);
+		return;
+	}
+	std::atomic<uint32_t> next(begin);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	auto worker = [&]() {
+		try {
+			for(uint32_t i = next++; i < end; i = next++)
+				fn(i);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if(!error)
+				error = std::current_exception();
+			next = end;
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(numWorkers - 1);
+	for(uint32_t t = 1; t < numWorkers; ++t)
+		threads.emplace_back(worker);
+	worker();
+	for(auto & thread : threads)
+		thread.join();
+	if(error)
+		std::rethrow_exception(error);
+}
+
+/**
+ * Split [begin, end) into chunks of at most @p grainSize elements and call @p fn(chunkBegin, chunkEnd) for each chunk in parallel.
+ * \see forEach
+ */
+template<typename Fn>
+void forRange(uint32_t begin, uint32_t end, uint32_t grainSize, Fn fn) {
+	if(end <= begin)
+		return;
+	grainSize = std::max(1u, grainSize);
+	const uint32_t numChunks = (end - begin + grainSize - 1) / grainSize;
+	forEach(0, numChunks, [&](uint32_t chunk) {
+		const uint32_t chunkBegin = begin + chunk * grainSize;
+		fn(chunkBegin, std::min(end, chunkBegin + grainSize));
+	});
+}
+
+}
+}
+}
+
+#endif /* RENDERING_MESHUTILS_PARALLEL_H_ */
@@ -0,0 +1,395 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "CommandBuffer.h"
+#include "RenderingContext.h"
+#include "../Draw.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/VertexDescription.h"
+#include "../Shader/Shader.h"
+#include "../Texture/Texture.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+namespace Rendering {
+
+const Util::StringIdentifier CommandBuffer::INSTANCE_MATRIX_ATTRIBUTE("sg_instanceModelToCamera");
+
+CommandBuffer::CommandBuffer() : instancingEnabled(false) {
+}
+
+// ---------------------------------------------------------------------------------------------
+// Recording
+
+void CommandBuffer::pushState() {
+	recordingStack.emplace_back(recording);
+}
+
+void CommandBuffer::popState() {
+	if(recordingStack.empty()) {
+		WARN("CommandBuffer::popState: Empty state stack.");
+		return;
+	}
+	recording = std::move(recordingStack.back());
+	recordingStack.pop_back();
+}
+
+void CommandBuffer::setShader(Shader * shader) {
+	recording.state.shader = shader;
+	recording.state.shaderSet = true;
+}
+
+void CommandBuffer::setTexture(uint8_t unit, Texture * texture, TexUnitUsageParameter usage) {
+	if(unit >= MAX_TEXTURE_UNITS) {
+		WARN("CommandBuffer::setTexture: Invalid texture unit.");
+		return;
+	}
+	recording.state.textures[unit] = texture;
+	recording.state.textureUsages[unit] = usage;
+	recording.state.textureMask |= static_cast<uint8_t>(1 << unit);
+}
+
+void CommandBuffer::setMaterial(const MaterialParameters & material) {
+	if(recording.state.material == NONE || materials[recording.state.material] != material) {
+		recording.state.material = static_cast<uint32_t>(materials.size());
+		materials.emplace_back(material);
+	}
+}
+
+void CommandBuffer::setMatrix_modelToCamera(const Geometry::Matrix4x4 & matrix) {
+	recording.matrix = matrix;
+	recording.matrixSet = true;
+	recording.matrixChanged = true;
+}
+
+void CommandBuffer::multMatrix_modelToCamera(const Geometry::Matrix4x4 & matrix) {
+	if(!recording.matrixSet) {
+		WARN("CommandBuffer::multMatrix_modelToCamera: The matrix has not been set in the command buffer.");
+		return;
+	}
+	recording.matrix *= matrix;
+	recording.matrixChanged = true;
+}
+
+void CommandBuffer::setUniform(const Uniform & uniform) {
+	auto it = std::find_if(recording.uniforms.begin(), recording.uniforms.end(), [&uniform](const Uniform & u) {
+		return u.getNameId() == uniform.getNameId();
+	});
+	if(it == recording.uniforms.end()) {
+		recording.uniforms.emplace_back(uniform);
+	} else if(!(*it == uniform)) {
+		*it = uniform;
+	} else {
+		return;
+	}
+	recording.uniformsChanged = true;
+}
+
+//! (internal) Stores the pending changes of the recorded state and returns the index of the state.
+uint32_t CommandBuffer::finishState() {
+	if(recording.matrixChanged) {
+		recording.state.matrix = static_cast<uint32_t>(matrices.size());
+		matrices.emplace_back(recording.matrix);
+		recording.matrixChanged = false;
+	}
+	if(recording.uniformsChanged) {
+		recording.state.uniformsBegin = static_cast<uint32_t>(uniforms.size());
+		uniforms.insert(uniforms.end(), recording.uniforms.begin(), recording.uniforms.end());
+		recording.state.uniformsEnd = static_cast<uint32_t>(uniforms.size());
+		recording.uniformsChanged = false;
+	}
+	if(states.empty() || !(states.back() == recording.state))
+		states.emplace_back(recording.state);
+	return static_cast<uint32_t>(states.size() - 1);
+}
+
+void CommandBuffer::displayMesh(Mesh * mesh, uint32_t firstElement, uint32_t elementCount, float sortDepth) {
+	if(mesh == nullptr)
+		return;
+	const uint32_t state = finishState();
+	draws.push_back({0, mesh, firstElement, elementCount, state, sortDepth});
+}
+
+void CommandBuffer::displayMesh(Mesh * mesh, float sortDepth) {
+	if(mesh == nullptr)
+		return;
+	displayMesh(mesh, 0, mesh->isUsingIndexData() ? mesh->getIndexCount() : mesh->getVertexCount(), sortDepth);
+}
+
+// ---------------------------------------------------------------------------------------------
+
+//! (internal) Append the first @p count elements of @p source; @p source may be @p target.
+template<typename T>
+static void appendElements(std::vector<T> & target, const std::vector<T> & source, size_t count) {
+	target.reserve(target.size() + count);
+	for(size_t i = 0; i < count; ++i)
+		target.push_back(source[i]);
+}
+
+void CommandBuffer::append(const CommandBuffer & other) {
+	// sizes and indices are used instead of iterators, as other may be this buffer
+	const auto stateOffset = static_cast<uint32_t>(states.size());
+	const auto matrixOffset = static_cast<uint32_t>(matrices.size());
+	const auto materialOffset = static_cast<uint32_t>(materials.size());
+	const auto uniformOffset = static_cast<uint32_t>(uniforms.size());
+	const size_t stateCount = other.states.size();
+	const size_t drawCount = other.draws.size();
+
+	appendElements(matrices, other.matrices, other.matrices.size());
+	appendElements(materials, other.materials, other.materials.size());
+	appendElements(uniforms, other.uniforms, other.uniforms.size());
+
+	states.reserve(states.size() + stateCount);
+	for(size_t i = 0; i < stateCount; ++i) {
+		State state = other.states[i];
+		if(state.matrix != NONE)
+			state.matrix += matrixOffset;
+		if(state.material != NONE)
+			state.material += materialOffset;
+		state.uniformsBegin += uniformOffset;
+		state.uniformsEnd += uniformOffset;
+		states.emplace_back(state);
+	}
+
+	draws.reserve(draws.size() + drawCount);
+	for(size_t i = 0; i < drawCount; ++i) {
+		Draw draw = other.draws[i];
+		draw.state += stateOffset;
+		draws.emplace_back(draw);
+	}
+}
+
+void CommandBuffer::sort() {
+	// ids by first appearance
+	std::unordered_map<const Shader *, uint64_t> shaderIds;
+	std::map<std::pair<std::array<Texture *, MAX_TEXTURE_UNITS>, uint8_t>, uint64_t> textureSetIds;
+	std::vector<const VertexDescription *> vertexDescriptions;
+	std::unordered_map<const Mesh *, uint64_t> meshIds;
+	const Mesh * lastMesh = nullptr;
+	uint64_t lastVertexDescriptionId = 0;
+
+	for(auto & draw : draws) {
+		const State & state = states[draw.state];
+		const uint64_t shaderId = shaderIds.emplace(state.shaderSet ? state.shader : nullptr, shaderIds.size()).first->second;
+		const uint64_t textureSetId = textureSetIds.emplace(std::make_pair(state.textures, state.textureMask), textureSetIds.size()).first->second;
+		if(draw.mesh != lastMesh) {
+			const VertexDescription & vd = draw.mesh->getVertexDescription();
+			auto it = std::find_if(vertexDescriptions.begin(), vertexDescriptions.end(), [&vd](const VertexDescription * other) {
+				return *other == vd;
+			});
+			if(it == vertexDescriptions.end())
+				it = vertexDescriptions.insert(it, &vd);
+			lastVertexDescriptionId = static_cast<uint64_t>(std::distance(vertexDescriptions.begin(), it));
+			lastMesh = draw.mesh;
+		}
+		// the bit pattern of non-negative floats has the same order as their values
+		uint32_t depthBits = 0;
+		const float depth = std::max(draw.sortDepth, 0.0f);
+		std::memcpy(&depthBits, &depth, sizeof(float));
+
+		// with automatic instancing, the mesh ranks above the depth to make draws of the same mesh consecutive
+		const uint64_t meshId = std::min<uint64_t>(meshIds.emplace(draw.mesh, meshIds.size()).first->second, 0xfff);
+		const uint64_t depthId = depthBits >> 16;
+
+		draw.sortKey = (std::min<uint64_t>(shaderId, 0xffff) << 48) |
+						(std::min<uint64_t>(textureSetId, 0xfff) << 36) |
+						(std::min<uint64_t>(lastVertexDescriptionId, 0xff) << 28) |
+						(instancingEnabled ? (meshId << 16) | depthId : (depthId << 12) | meshId);
+	}
+	std::stable_sort(draws.begin(), draws.end(), [](const Draw & a, const Draw & b) {
+		return a.sortKey < b.sortKey;
+	});
+}
+
+void CommandBuffer::execute(RenderingContext & context) const {
+	if(draws.empty())
+		return;
+
+	uint8_t usedTextureUnits = 0;
+	bool usesMaterial = false;
+	for(const auto & state : states) {
+		usedTextureUnits |= state.textureMask;
+		usesMaterial |= (state.material != NONE);
+	}
+
+	const bool immediate = context.getImmediateMode();
+	context.setImmediateMode(false);
+
+	// save the state of the context
+	context.pushShader();
+	Shader * const originalShader = context.getActiveShader();
+	std::array<Texture *, MAX_TEXTURE_UNITS> originalTextures;
+	std::array<TexUnitUsageParameter, MAX_TEXTURE_UNITS> originalUsages;
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+		originalTextures[unit] = context.getTexture(unit);
+		originalUsages[unit] = context.getTextureUsage(unit);
+		if(usedTextureUnits & (1 << unit))
+			context.pushTexture(unit);
+	}
+	context.pushMatrix_modelToCamera();
+	const Geometry::Matrix4x4 originalMatrix = context.getMatrix_modelToCamera();
+	if(usesMaterial)
+		context.pushMaterial();
+
+	// currently active state
+	Shader * activeShader = originalShader;
+	std::array<Texture *, MAX_TEXTURE_UNITS> activeTextures = originalTextures;
+	std::array<TexUnitUsageParameter, MAX_TEXTURE_UNITS> activeUsages = originalUsages;
+	uint32_t activeMaterial = NONE;
+	uint32_t activeMatrix = NONE;
+	uint32_t activeUniformsBegin = 0;
+	uint32_t activeUniformsEnd = 0;
+	uint32_t activeState = NONE;
+
+	int32_t instanceLocation = instancingEnabled && activeShader ? activeShader->getVertexAttributeLocation(INSTANCE_MATRIX_ATTRIBUTE) : -1;
+	std::vector<float> instanceData;
+
+	// original values of the recorded uniforms of each used shader; they are set again if a state does not set
+	// the uniform and when the execution is finished (null if the uniform is not defined by the shader)
+	std::vector<Util::StringIdentifier> uniformNames;
+	for(const auto & uniform : uniforms) {
+		if(std::find(uniformNames.begin(), uniformNames.end(), uniform.getNameId()) == uniformNames.end())
+			uniformNames.emplace_back(uniform.getNameId());
+	}
+	std::unordered_map<Shader *, std::vector<Uniform>> originalUniforms;
+	const auto getOriginalUniforms = [&](Shader * shader) -> const std::vector<Uniform> & {
+		auto it = originalUniforms.find(shader);
+		if(it == originalUniforms.end()) {
+			it = originalUniforms.emplace(shader, std::vector<Uniform>()).first;
+			it->second.reserve(uniformNames.size());
+			for(const auto & name : uniformNames)
+				it->second.emplace_back(shader->getUniform(name));
+		}
+		return it->second;
+	};
+
+	for(size_t drawIndex = 0; drawIndex < draws.size(); ) {
+		const Draw & draw = draws[drawIndex];
+		if(draw.state != activeState) {
+			const State & state = states[draw.state];
+			activeState = draw.state;
+
+			Shader * shader = state.shaderSet ? state.shader : originalShader;
+			const bool shaderChanged = (shader != activeShader);
+			if(shaderChanged) {
+				context.setShader(shader);
+				activeShader = shader;
+				instanceLocation = instancingEnabled && activeShader ? activeShader->getVertexAttributeLocation(INSTANCE_MATRIX_ATTRIBUTE) : -1;
+			}
+			for(uint_fast8_t unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+				if((usedTextureUnits & (1 << unit)) == 0)
+					continue;
+				const bool set = (state.textureMask & (1 << unit)) != 0;
+				Texture * texture = set ? state.textures[unit] : originalTextures[unit];
+				const TexUnitUsageParameter usage = set ? state.textureUsages[unit] : originalUsages[unit];
+				if(texture != activeTextures[unit] || usage != activeUsages[unit]) {
+					context.setTexture(unit, texture, usage);
+					activeTextures[unit] = texture;
+					activeUsages[unit] = usage;
+				}
+			}
+			if(state.material != activeMaterial) {
+				if(state.material == NONE) { // restore the original material
+					context.popMaterial();
+					context.pushMaterial();
+				} else {
+					context.setMaterial(materials[state.material]);
+				}
+				activeMaterial = state.material;
+			}
+			if(state.matrix != activeMatrix) {
+				context.setMatrix_modelToCamera(state.matrix == NONE ? originalMatrix : matrices[state.matrix]);
+				activeMatrix = state.matrix;
+			}
+			if(shaderChanged || state.uniformsBegin != activeUniformsBegin || state.uniformsEnd != activeUniformsEnd) {
+				if(activeShader && !uniformNames.empty()) {
+					// unchanged values are filtered by the uniform registry of the shader
+					for(const auto & original : getOriginalUniforms(activeShader)) {
+						if(original.isNull())
+							continue;
+						const auto recorded = std::find_if(uniforms.begin() + state.uniformsBegin, uniforms.begin() + state.uniformsEnd,
+								[&original](const Uniform & u) { return u.getNameId() == original.getNameId(); });
+						if(recorded == uniforms.begin() + state.uniformsEnd)
+							activeShader->setUniform(context, original, false);
+					}
+					for(uint32_t i = state.uniformsBegin; i < state.uniformsEnd; ++i)
+						activeShader->setUniform(context, uniforms[i], false);
+				}
+				activeUniformsBegin = state.uniformsBegin;
+				activeUniformsEnd = state.uniformsEnd;
+			}
+		}
+
+		if(instanceLocation < 0) {
+			context.displayMesh(draw.mesh, draw.firstElement, draw.elementCount);
+			++statistics.drawCalls;
+			++drawIndex;
+			continue;
+		}
+
+		// automatic instancing: collect the following draws of the same mesh that only differ in the matrix
+		const State & state = states[draw.state];
+		size_t runEnd = drawIndex + 1;
+		while(runEnd < draws.size() && runEnd - drawIndex < MAX_INSTANCES) {
+			const Draw & other = draws[runEnd];
+			if(other.mesh != draw.mesh || other.firstElement != draw.firstElement || other.elementCount != draw.elementCount ||
+					!(other.state == draw.state || states[other.state].equalsIgnoringMatrix(state)))
+				break;
+			++runEnd;
+		}
+		instanceData.resize((runEnd - drawIndex) * 16);
+		for(size_t i = drawIndex; i < runEnd; ++i) {
+			const uint32_t matrix = states[draws[i].state].matrix;
+			// the columns of the matrix are stored consecutively (like uniform matrices)
+			const Geometry::Matrix4x4 transposed = (matrix == NONE ? originalMatrix : matrices[matrix]).getTransposed();
+			std::copy(transposed.getData(), transposed.getData() + 16, instanceData.begin() + static_cast<std::ptrdiff_t>((i - drawIndex) * 16));
+		}
+		instanceBuffer.uploadData(BufferObject::TARGET_ARRAY_BUFFER, instanceData, BufferObject::USAGE_STREAM_DRAW);
+		enableInstanceBuffer(context, instanceBuffer, instanceLocation, 16);
+		drawInstances(context, draw.mesh, draw.firstElement, draw.elementCount, static_cast<uint32_t>(runEnd - drawIndex));
+		disableInstanceBuffer(context, instanceBuffer, instanceLocation, 16);
+
+		++statistics.drawCalls;
+		++statistics.instancedDrawCalls;
+		statistics.mergedDraws += static_cast<uint32_t>(runEnd - drawIndex - 1);
+		drawIndex = runEnd;
+	}
+	statistics.draws += static_cast<uint32_t>(draws.size());
+
+	// restore the state of the context
+	for(const auto & entry : originalUniforms) {
+		for(const auto & original : entry.second) {
+			if(!original.isNull())
+				entry.first->setUniform(context, original, false);
+		}
+	}
+	if(usesMaterial)
+		context.popMaterial();
+	context.popMatrix_modelToCamera();
+	for(uint_fast8_t unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+		if(usedTextureUnits & (1 << unit))
+			context.popTexture(unit);
+	}
+	context.popShader();
+	context.setImmediateMode(immediate);
+}
+
+void CommandBuffer::clear() {
+	draws.clear();
+	states.clear();
+	matrices.clear();
+	materials.clear();
+	uniforms.clear();
+	recording = RecordingState();
+	recordingStack.clear();
+}
+
+}
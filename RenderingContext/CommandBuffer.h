@@ -0,0 +1,184 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_COMMANDBUFFER_H_
+#define RENDERING_COMMANDBUFFER_H_
+
+#include "RenderingParameters.h"
+#include "../BufferObject.h"
+#include "../Shader/Uniform.h"
+#include <Geometry/Matrix4x4.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+class Shader;
+class Texture;
+
+/**
+ * Recorded list of draw calls together with the state (shader, textures, material, modelToCamera matrix and uniforms)
+ * they are executed with.
+ *
+ * Recording does not access the RenderingContext or OpenGL, so several command buffers can be recorded in parallel
+ * on worker threads (one buffer per thread). The buffers are then combined with append(), optionally sorted by a
+ * state key (shader, textures, vertex format, sort depth, mesh) and executed on the rendering thread. During execution,
+ * a state is only changed if it differs from the state of the previous draw.
+ *
+ * State that is not set in the command buffer (e.g. no shader) is taken from the RenderingContext when execute()
+ * is called; all states changed by the command buffer are restored afterwards.
+ *
+ * @note The recorded objects (meshes, shaders, textures) are not reference counted by the command buffer and have
+ *	to be kept alive until the command buffer is executed or cleared.
+ * @ingroup context
+ */
+class CommandBuffer {
+	public:
+		//! Number of texture units that can be set in a command buffer.
+		static constexpr uint8_t MAX_TEXTURE_UNITS = 8;
+
+		RENDERINGAPI CommandBuffer();
+
+		//! @name Recording
+		//	@{
+		//! Save the current recorded state (shader, textures, material, matrix, uniforms).
+		RENDERINGAPI void pushState();
+		//! Restore the last saved state.
+		RENDERINGAPI void popState();
+
+		RENDERINGAPI void setShader(Shader * shader);
+		RENDERINGAPI void setTexture(uint8_t unit, Texture * texture, TexUnitUsageParameter usage = TexUnitUsageParameter::TEXTURE_MAPPING);
+		RENDERINGAPI void setMaterial(const MaterialParameters & material);
+		RENDERINGAPI void setMatrix_modelToCamera(const Geometry::Matrix4x4 & matrix);
+		RENDERINGAPI void multMatrix_modelToCamera(const Geometry::Matrix4x4 & matrix);
+		/*! The uniform is set on the shader used for the following draws. Draws recorded without the uniform use the
+			value the shader had before execute(). */
+		RENDERINGAPI void setUniform(const Uniform & uniform);
+
+		/*! Record a draw of the mesh with the current state.
+			@param sortDepth Used in the sort key after the vertex format (e.g. the distance to the camera for front-to-back sorting) */
+		RENDERINGAPI void displayMesh(Mesh * mesh, uint32_t firstElement, uint32_t elementCount, float sortDepth = 0.0f);
+		RENDERINGAPI void displayMesh(Mesh * mesh, float sortDepth = 0.0f);
+		//	@}
+
+		// ------
+
+		/*! Append the commands of another command buffer (e.g. one that was recorded on another thread).
+			The recorded state of this buffer is not changed. */
+		RENDERINGAPI void append(const CommandBuffer & other);
+
+		/*! Sort the draws (stable) by shader, textures, vertex format, sort depth (ascending) and mesh.
+			If automatic instancing is enabled, the mesh ranks above the sort depth, so that draws of the same mesh
+			become consecutive and can be combined; the draws are then only ordered by depth within each mesh.
+			@note Must be called on the rendering thread, as the vertex formats of the meshes are accessed. */
+		RENDERINGAPI void sort();
+
+		//! Execute the recorded draws. Must be called on the rendering thread.
+		RENDERINGAPI void execute(RenderingContext & context) const;
+
+		RENDERINGAPI void clear();
+
+		size_t getDrawCount() const				{	return draws.size();	}
+		bool empty() const						{	return draws.empty();	}
+
+		//! @name Automatic instancing
+		//	@{
+		/*! Name of the per-instance vertex attribute (mat4) containing the modelToCamera matrix.
+			If instancing is enabled and the active shader declares this attribute, consecutive draws of the same mesh
+			that only differ in their modelToCamera matrix are combined into one drawInstances() call. Such a shader has
+			to use the attribute instead of sg_matrix_modelToCamera (and sg_matrix_modelToClipping) for all its draws.
+			The draw function of the RenderingContext (RenderingContext::setDisplayMeshFn()) is not used for these draws. */
+		RENDERINGAPI static const Util::StringIdentifier INSTANCE_MATRIX_ATTRIBUTE;
+		//! Maximum number of draws combined into one instanced draw call.
+		static constexpr uint32_t MAX_INSTANCES = 1024;
+
+		void setInstancingEnabled(bool enabled)	{	instancingEnabled = enabled;	}
+		bool isInstancingEnabled() const		{	return instancingEnabled;	}
+
+		//! Counters accumulated over all calls of execute()
+		struct Statistics {
+			//! Executed draws
+			uint32_t draws = 0;
+			//! Issued draw calls (including instanced draw calls)
+			uint32_t drawCalls = 0;
+			uint32_t instancedDrawCalls = 0;
+			//! Draws that were merged into an instanced draw call of a preceding draw
+			uint32_t mergedDraws = 0;
+		};
+		const Statistics & getStatistics() const	{	return statistics;	}
+		void resetStatistics()						{	statistics = Statistics();	}
+		//	@}
+
+	private:
+		static constexpr uint32_t NONE = 0xffffffff;
+
+		struct State {
+			Shader * shader = nullptr;
+			std::array<Texture *, MAX_TEXTURE_UNITS> textures;
+			std::array<TexUnitUsageParameter, MAX_TEXTURE_UNITS> textureUsages;
+			//! Bit i is set if the texture of unit i has been set
+			uint8_t textureMask = 0;
+			bool shaderSet = false;
+			uint32_t material = NONE;
+			uint32_t matrix = NONE;
+			//! Range in uniforms
+			uint32_t uniformsBegin = 0;
+			uint32_t uniformsEnd = 0;
+
+			State() {
+				textures.fill(nullptr);
+				textureUsages.fill(TexUnitUsageParameter::TEXTURE_MAPPING);
+			}
+			bool equalsIgnoringMatrix(const State & other) const {
+				return shader == other.shader && shaderSet == other.shaderSet && textureMask == other.textureMask &&
+						textures == other.textures && textureUsages == other.textureUsages && material == other.material &&
+						uniformsBegin == other.uniformsBegin && uniformsEnd == other.uniformsEnd;
+			}
+			bool operator==(const State & other) const {
+				return matrix == other.matrix && equalsIgnoringMatrix(other);
+			}
+		};
+		struct Draw {
+			uint64_t sortKey;
+			Mesh * mesh;
+			uint32_t firstElement;
+			uint32_t elementCount;
+			uint32_t state;
+			float sortDepth;
+		};
+		//! State while recording
+		struct RecordingState {
+			State state;
+			Geometry::Matrix4x4 matrix;
+			bool matrixSet = false;
+			bool matrixChanged = false;
+			bool uniformsChanged = false;
+			std::vector<Uniform> uniforms;
+		};
+
+		std::vector<Draw> draws;
+		std::vector<State> states;
+		std::vector<Geometry::Matrix4x4> matrices;
+		std::vector<MaterialParameters> materials;
+		std::vector<Uniform> uniforms;
+
+		RecordingState recording;
+		std::vector<RecordingState> recordingStack;
+
+		bool instancingEnabled;
+		mutable BufferObject instanceBuffer;
+		mutable Statistics statistics;
+
+		uint32_t finishState();
+};
+
+}
+
+#endif /* RENDERING_COMMANDBUFFER_H_ */
@@ -15,8 +15,10 @@
 #include "internal/RenderingStatus.h"
 #include "internal/StatusHandler_glCompatibility.h"
 #include "internal/StatusHandler_glCore.h"
+#include "internal/StatusHandler_sgUniformBlocks.h"
 #include "internal/StatusHandler_sgUniforms.h"
 #include "RenderingParameters.h"
+#include "StateBlock.h"
 #include "../BufferObject.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexDescription.h"
@@ -26,6 +28,7 @@
 #include "../FBO.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include "../IndirectDrawBuilder.h"
 #include <Geometry/Matrix4x4.h>
 #include <Geometry/Rect.h>
 #include <Util/Graphics/ColorLibrary.h>
@@ -79,6 +82,8 @@ class RenderingContext::InternalData {
 		std::stack<ScissorParameters> scissorParametersStack;
 		ScissorParameters currentScissorParameters;
 		std::stack<StencilParameters> stencilParameterStack;
+		//! Saved states of pushStateBlock(); the vector keeps its capacity, so pushing does not allocate after warm-up
+		std::vector<StateBlock> stateBlockStack;
 		
 		std::array<std::stack<ClipPlaneParameters>, MAX_CLIP_PLANES> clipPlaneStacks;
 		std::array<ClipPlaneParameters, MAX_CLIP_PLANES> activeClipPlanes;
@@ -88,6 +93,10 @@ class RenderingContext::InternalData {
 
 		UniformRegistry globalUniforms;
 
+		bool sgUniformBlocksEnabled;
+		RenderingStatus sgUniformBlockStatus;
+		BufferObject sgUniformBuffer;
+
 		std::stack<Geometry::Matrix4x4> matrixStack;
 		std::stack<Geometry::Matrix4x4> projectionMatrixStack;
 
@@ -108,8 +117,10 @@ class RenderingContext::InternalData {
 		Geometry::Rect_i windowClientArea;
 		
 		InternalData() : targetRenderingStatus(), openGLRenderingStatus(), activeRenderingStatus(nullptr),
-			actualCoreRenderingStatus(), appliedCoreRenderingStatus(), globalUniforms(), textureStacks(),
+			actualCoreRenderingStatus(), appliedCoreRenderingStatus(), globalUniforms(),
+			sgUniformBlocksEnabled(false), sgUniformBlockStatus(), sgUniformBuffer(), textureStacks(),
 			currentViewport(0, 0, 0, 0) {
+			stateBlockStack.reserve(16);
 		}
 };
 
@@ -147,6 +158,78 @@ void RenderingContext::displayMesh(Mesh * mesh){
 	displayMeshFn(*this, mesh,0,mesh->isUsingIndexData()? mesh->getIndexCount() : mesh->getVertexCount());
 }
 
+//! (static internal) Binds the vertex and index data of @p mesh and the @p commandBuffer, calls @p drawFn(glDrawMode) and unbinds them.
+template<typename DrawFn_t>
+static void drawIndexedIndirect(RenderingContext & rc, Mesh * mesh, BufferObject & commandBuffer, DrawFn_t drawFn) {
+	rc.applyChanges();
+
+	MeshVertexData & vd = mesh->_getVertexData();
+	if(!vd.isUploaded())
+		vd.upload();
+	vd.bind(rc, vd.isUploaded());
+
+	MeshIndexData & id = mesh->_getIndexData();
+	if(!id.isUploaded())
+		id.upload();
+	BufferObject indexBuffer;
+	id._swapBufferObject(indexBuffer);
+	indexBuffer.bind(BufferObject::TARGET_ELEMENT_ARRAY_BUFFER);
+	commandBuffer.bind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+
+	drawFn(mesh->getGLDrawMode());
+	GET_GL_ERROR();
+
+	commandBuffer.unbind(BufferObject::TARGET_DRAW_INDIRECT_BUFFER);
+	indexBuffer.unbind(BufferObject::TARGET_ELEMENT_ARRAY_BUFFER);
+	id._swapBufferObject(indexBuffer);
+	vd.unbind(rc, vd.isUploaded());
+}
+
+void RenderingContext::multiDrawIndirect(Mesh * mesh, BufferObject & commandBuffer, uint32_t drawCount, size_t offset) {
+	if(mesh->empty() || drawCount == 0)
+		return;
+	if(!mesh->isUsingIndexData()) {
+		WARN("multiDrawIndirect: The mesh has no index data.");
+		return;
+	}
+	#if defined(LIB_GL) && defined(GL_VERSION_4_3)
+		drawIndexedIndirect(*this, mesh, commandBuffer, [&](uint32_t mode) {
+			glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+										static_cast<GLsizei>(drawCount), sizeof(DrawElementsIndirectCommand));
+		});
+	#else
+		WARN("multiDrawIndirect: Multi draw indirect is not supported.");
+	#endif
+}
+
+//! (static)
+bool RenderingContext::isMultiDrawIndirectCountSupported() {
+	static const bool support = isExtensionSupported("GL_ARB_indirect_parameters");
+	return support;
+}
+
+void RenderingContext::multiDrawIndirectCount(Mesh * mesh, BufferObject & commandBuffer, BufferObject & countBuffer, uint32_t maxDrawCount, size_t offset, size_t countOffset) {
+	if(mesh->empty() || maxDrawCount == 0)
+		return;
+	if(!mesh->isUsingIndexData()) {
+		WARN("multiDrawIndirectCount: The mesh has no index data.");
+		return;
+	}
+	#if defined(LIB_GL) && defined(GL_ARB_indirect_parameters)
+		if(isMultiDrawIndirectCountSupported()) {
+			countBuffer.bind(GL_PARAMETER_BUFFER_ARB);
+			drawIndexedIndirect(*this, mesh, commandBuffer, [&](uint32_t mode) {
+				glMultiDrawElementsIndirectCountARB(mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+													static_cast<GLintptr>(countOffset), static_cast<GLsizei>(maxDrawCount),
+													sizeof(DrawElementsIndirectCommand));
+			});
+			countBuffer.unbind(GL_PARAMETER_BUFFER_ARB);
+			return;
+		}
+	#endif
+	WARN("multiDrawIndirectCount: ARB_indirect_parameters is not supported.");
+}
+
 void RenderingContext::setImmediateMode(const bool enabled) {
 	immediate = enabled;
 	if(immediate)
@@ -267,8 +350,127 @@ void RenderingContext::barrier(uint32_t flags) {
 	applyChanges();
 	glMemoryBarrier(flags == 0 ? GL_ALL_BARRIER_BITS : static_cast<GLbitfield>(flags));
 }
+// State blocks ************************************************************************************
+
+StateBlock RenderingContext::captureStateBlock(uint32_t groups) const {
+	const CoreRenderingStatus & core = internalData->actualCoreRenderingStatus;
+	const RenderingStatus & status = internalData->targetRenderingStatus;
+	StateBlock block;
+	if(groups & StateBlock::ALPHA_TEST)
+		block = block.withAlphaTest(core.getAlphaTestParameters());
+	if(groups & StateBlock::BLENDING)
+		block = block.withBlending(core.getBlendingParameters());
+	if(groups & StateBlock::COLOR_BUFFER)
+		block = block.withColorBuffer(core.getColorBufferParameters());
+	if(groups & StateBlock::CULL_FACE)
+		block = block.withCullFace(core.getCullFaceParameters());
+	if(groups & StateBlock::DEPTH_BUFFER)
+		block = block.withDepthBuffer(core.getDepthBufferParameters());
+	if(groups & StateBlock::LIGHTING)
+		block = block.withLighting(core.getLightingParameters());
+	if(groups & StateBlock::LINE)
+		block = block.withLine(core.getLineParameters());
+	if(groups & StateBlock::MATERIAL)
+		block = status.isMaterialEnabled() ? block.withMaterial(status.getMaterialParameters()) : block.withMaterialDisabled();
+	if(groups & StateBlock::POINT)
+		block = block.withPoint(status.getPointParameters());
+	if(groups & StateBlock::POLYGON_MODE)
+		block = block.withPolygonMode(core.getPolygonModeParameters());
+	if(groups & StateBlock::POLYGON_OFFSET)
+		block = block.withPolygonOffset(core.getPolygonOffsetParameters());
+	if(groups & StateBlock::PRIMITIVE_RESTART)
+		block = block.withPrimitiveRestart(core.getPrimitiveRestartParameters());
+	if(groups & StateBlock::STENCIL)
+		block = block.withStencil(core.getStencilParameters());
+	return block;
+}
+
+void RenderingContext::applyStateBlock(const StateBlock & block) {
+	CoreRenderingStatus & core = internalData->actualCoreRenderingStatus;
+	RenderingStatus & status = internalData->targetRenderingStatus;
+	// the core status detects equal values itself
+	if(block.contains(StateBlock::ALPHA_TEST))
+		core.setAlphaTestParameters(block.getAlphaTest());
+	if(block.contains(StateBlock::BLENDING))
+		core.setBlendingParameters(block.getBlending());
+	if(block.contains(StateBlock::COLOR_BUFFER))
+		core.setColorBufferParameters(block.getColorBuffer());
+	if(block.contains(StateBlock::CULL_FACE))
+		core.setCullFaceParameters(block.getCullFace());
+	if(block.contains(StateBlock::DEPTH_BUFFER))
+		core.setDepthBufferParameters(block.getDepthBuffer());
+	if(block.contains(StateBlock::LIGHTING))
+		core.setLightingParameters(block.getLighting());
+	if(block.contains(StateBlock::LINE))
+		core.setLineParameters(block.getLine());
+	if(block.contains(StateBlock::POLYGON_MODE))
+		core.setPolygonModeParameters(block.getPolygonMode());
+	if(block.contains(StateBlock::POLYGON_OFFSET))
+		core.setPolygonOffsetParameters(block.getPolygonOffset());
+	if(block.contains(StateBlock::PRIMITIVE_RESTART))
+		core.setPrimitiveRestartParameters(block.getPrimitiveRestart());
+	if(block.contains(StateBlock::STENCIL))
+		core.setStencilParameters(block.getStencil());
+	// setting these would always trigger an update of the sg_ uniforms
+	if(block.contains(StateBlock::MATERIAL)) {
+		if(!block.isMaterialEnabled()) {
+			if(status.isMaterialEnabled())
+				status.disableMaterial();
+		} else if(!status.isMaterialEnabled() || status.getMaterialParameters() != block.getMaterial()) {
+			status.setMaterial(block.getMaterial());
+		}
+	}
+	if(block.contains(StateBlock::POINT) && status.getPointParameters() != block.getPoint())
+		status.setPointParameters(block.getPoint());
+	if(immediate)
+		applyChanges();
+}
+
+void RenderingContext::pushStateBlock(const StateBlock & block) {
+	internalData->stateBlockStack.emplace_back(captureStateBlock(block.getGroups()));
+	applyStateBlock(block);
+}
+
+void RenderingContext::popStateBlock() {
+	if(internalData->stateBlockStack.empty()) {
+		WARN("popStateBlock: Empty StateBlock-Stack");
+		return;
+	}
+	applyStateBlock(internalData->stateBlockStack.back());
+	internalData->stateBlockStack.pop_back();
+}
+
 // Applying changes ***************************************************************************
 
+RenderingContext::StateCallCounters RenderingContext::getStateCallCounters() const {
+	StateCallCounters counters;
+	counters.issued = internalData->actualCoreRenderingStatus.getIssuedStateCalls();
+	counters.elided = internalData->actualCoreRenderingStatus.getElidedStateCalls();
+	return counters;
+}
+
+void RenderingContext::resetStateCallCounters() {
+	internalData->actualCoreRenderingStatus.resetStateCallCounters();
+}
+
+void RenderingContext::setSGUniformBlocksEnabled(bool enabled) {
+	if(internalData->sgUniformBlocksEnabled == enabled)
+		return;
+	internalData->sgUniformBlocksEnabled = enabled;
+	// re-upload and re-bind the whole blocks on the next use
+	internalData->sgUniformBlockStatus = RenderingStatus();
+	// the blocks are not updated anymore, so do not leave stale values bound
+	if(!enabled)
+		StatusHandler_sgUniformBlocks::unbind();
+	// each shader sets all of its loose sg_ uniforms when it is applied with a different set of blocks
+	if(immediate)
+		applyChanges();
+}
+
+bool RenderingContext::isSGUniformBlocksEnabled() const {
+	return internalData->sgUniformBlocksEnabled;
+}
+
 void RenderingContext::applyChanges(bool forced) {
 	try {
 		StatusHandler_glCore::apply(internalData->appliedCoreRenderingStatus, internalData->actualCoreRenderingStatus, forced);
@@ -278,7 +480,10 @@ void RenderingContext::applyChanges(bool forced) {
 				StatusHandler_glCompatibility::apply(internalData->openGLRenderingStatus, internalData->targetRenderingStatus, forced);
 
 			if(shader->usesSGUniforms()) {
-				StatusHandler_sgUniforms::apply(*shader->getRenderingStatus(), internalData->targetRenderingStatus, forced);
+				const uint8_t uniformBlocks = internalData->sgUniformBlocksEnabled ? shader->getSGUniformBlocks() : 0;
+				if(uniformBlocks != 0)
+					StatusHandler_sgUniformBlocks::apply(internalData->sgUniformBlockStatus, internalData->targetRenderingStatus, internalData->sgUniformBuffer, forced);
+				StatusHandler_sgUniforms::apply(*shader->getRenderingStatus(), internalData->targetRenderingStatus, forced, uniformBlocks);
 				if(immediate && getActiveShader() == shader) {
 					shader->applyUniforms(false); // forced is false here, as this forced means to re-apply all uniforms
 				}
@@ -1143,7 +1348,11 @@ void RenderingContext::drawMeshTask(uint32_t count, uint32_t first) {
 }
 
 void RenderingContext::_setUniformOnShader(Shader * shader, const Uniform & uniform, bool warnIfUnused, bool forced) {
-	shader->_getUniformRegistry()->setUniform(uniform, warnIfUnused, forced);
+	_setUniformOnShader(shader, UniformRegistry::getHandle(uniform.getNameId()), uniform, warnIfUnused, forced);
+}
+
+void RenderingContext::_setUniformOnShader(Shader * shader, uint32_t uniformHandle, const Uniform & uniform, bool warnIfUnused, bool forced) {
+	shader->_getUniformRegistry()->setUniform(uniformHandle, uniform, warnIfUnused, forced);
 	if(immediate && getActiveShader() == shader)
 		shader->applyUniforms(false); // forced is false here, as this forced means to re-apply all uniforms
 }
@@ -1187,11 +1396,10 @@ void RenderingContext::setTexture(uint8_t unit, Texture * texture) {
 
 void RenderingContext::setTexture(uint8_t unit, Texture * texture, TexUnitUsageParameter usage) {
 	Texture * oldTexture = getTexture(unit);
-	if(texture != oldTexture) {
-		if(texture) 
-			texture->_prepareForBinding(*this);
-		internalData->actualCoreRenderingStatus.setTexture(unit, texture);
-	}
+	if(texture && texture != oldTexture)
+		texture->_prepareForBinding(*this);
+	// redundant sets are detected (and counted) by the status
+	internalData->actualCoreRenderingStatus.setTexture(unit, texture);
 	const auto oldUsage = internalData->targetRenderingStatus.getTextureUnitParams(unit).first;
 	if(!texture){
 		if( oldUsage!= TexUnitUsageParameter::DISABLED )
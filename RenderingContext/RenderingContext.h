@@ -52,6 +52,7 @@ class PrimitiveRestartParameters;
 class ScissorParameters;
 class StencilParameters;
 class Shader;
+class StateBlock;
 class Texture;
 class Uniform;
 class UniformRegistry;
@@ -90,6 +91,18 @@ public:
 	void displayMesh(Mesh * mesh,uint32_t firstElement,uint32_t elementCount){ displayMeshFn(*this, mesh,firstElement,elementCount); }
 	RENDERINGAPI void displayMesh(Mesh * mesh);
 
+	/*! Draw several ranges of the indexed @p mesh with a single glMultiDrawElementsIndirect call.
+		@param commandBuffer Buffer containing @p drawCount DrawElementsIndirectCommand structs starting at @p offset
+			(see IndirectDrawBuilder). The index and vertex ranges of the commands refer to the index and vertex data of @p mesh.
+		@note The draw function set with setDisplayMeshFn() is not used. Per-draw data can be fetched in the shader from a
+			shader storage buffer indexed by gl_DrawIDARB (see IndirectDrawData). */
+	RENDERINGAPI void multiDrawIndirect(Mesh * mesh, BufferObject & commandBuffer, uint32_t drawCount, size_t offset = 0);
+	/*! Like multiDrawIndirect(), but the number of draws (at most @p maxDrawCount) is read from the uint32_t at
+		@p countOffset in @p countBuffer (e.g. written by a compute shader, see GPUCulling). Requires ARB_indirect_parameters. */
+	RENDERINGAPI void multiDrawIndirectCount(Mesh * mesh, BufferObject & commandBuffer, BufferObject & countBuffer, uint32_t maxDrawCount,
+												size_t offset = 0, size_t countOffset = 0);
+	RENDERINGAPI static bool isMultiDrawIndirectCountSupported();
+
 	RENDERINGAPI void setImmediateMode(const bool enabled);
 	bool getImmediateMode() const {
 		return immediate;
@@ -99,6 +112,43 @@ public:
 	}
 
 	RENDERINGAPI void applyChanges(bool forced = false);
+
+	//! Counters of the OpenGL calls for the core state (blending, depth buffer, stencil, textures, ...).
+	struct StateCallCounters {
+		//! Issued OpenGL state calls
+		uint32_t issued = 0;
+		//! Redundant state changes detected when setting a state or when applying the changes
+		uint32_t elided = 0;
+	};
+	//! Returns the counters accumulated since the last call of resetStateCallCounters() (e.g. at the start of a frame).
+	RENDERINGAPI StateCallCounters getStateCallCounters() const;
+	RENDERINGAPI void resetStateCallCounters();
+
+	/*! If enabled, the camera, transformation, light and material sg_ uniforms are stored in std140 uniform blocks
+		(sg_CameraBlock, sg_TransformBlock, sg_LightBlock, sg_MaterialBlock) in a single uniform buffer, which is
+		updated once per change and shared by all shaders. Shaders that do not declare a block still get the
+		corresponding loose sg_ uniforms. The block layouts and the reserved binding points are listed in
+		internal/StatusHandler_sgUniformBlocks.h. Disabled by default.
+		The mode can be switched at any time; afterwards, every shader re-sets all of its loose sg_ uniforms when it is
+		used next. While the mode is disabled, no buffer is bound to the blocks, so shaders declaring a block require
+		the mode to be enabled. */
+	RENDERINGAPI void setSGUniformBlocksEnabled(bool enabled);
+	RENDERINGAPI bool isSGUniformBlocksEnabled() const;
+	//	@}
+
+	// -----------------------------------
+
+	/*!	@name State blocks
+		A state block (see StateBlock) combines several parameter groups (blending, depth buffer, material, ...).
+		Pushing a block saves the current values of the contained groups on a single stack (instead of one push per
+		parameter stack) and only changes the groups whose values differ. */
+	//	@{
+	//! Returns a block containing the current values of the given groups (bit mask of StateBlock::group_t).
+	RENDERINGAPI StateBlock captureStateBlock(uint32_t groups) const;
+	//! Set the groups contained in the block; groups with equal values are skipped.
+	RENDERINGAPI void applyStateBlock(const StateBlock & block);
+	RENDERINGAPI void pushStateBlock(const StateBlock & block);
+	RENDERINGAPI void popStateBlock();
 	//	@}
 
 	// -----------------------------------
@@ -431,6 +481,7 @@ public:
 
 	//! (internal) called by Shader::setUniform(...)
 	RENDERINGAPI void _setUniformOnShader(Shader * shader, const Uniform & uniform, bool warnIfUnused, bool forced);
+	RENDERINGAPI void _setUniformOnShader(Shader * shader, uint32_t uniformHandle, const Uniform & uniform, bool warnIfUnused, bool forced);
 
 	// @}
 
@@ -0,0 +1,163 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StateBlock.h"
+#include <Util/Graphics/Color.h>
+#include <functional>
+
+namespace Rendering {
+
+template<typename T>
+static void hashCombine(size_t & seed, const T & value) {
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+template<typename Parameters_t>
+StateBlock StateBlock::with(Parameters_t StateBlock::* member, const Parameters_t & p, group_t group) const {
+	StateBlock block(*this);
+	block.*member = p;
+	block.groups |= group;
+	block.updateHash();
+	return block;
+}
+
+StateBlock StateBlock::withAlphaTest(const AlphaTestParameters & p) const {
+	return with(&StateBlock::alphaTest, p, ALPHA_TEST);
+}
+StateBlock StateBlock::withBlending(const BlendingParameters & p) const {
+	return with(&StateBlock::blending, p, BLENDING);
+}
+StateBlock StateBlock::withColorBuffer(const ColorBufferParameters & p) const {
+	return with(&StateBlock::colorBuffer, p, COLOR_BUFFER);
+}
+StateBlock StateBlock::withCullFace(const CullFaceParameters & p) const {
+	return with(&StateBlock::cullFace, p, CULL_FACE);
+}
+StateBlock StateBlock::withDepthBuffer(const DepthBufferParameters & p) const {
+	return with(&StateBlock::depthBuffer, p, DEPTH_BUFFER);
+}
+StateBlock StateBlock::withLighting(const LightingParameters & p) const {
+	return with(&StateBlock::lighting, p, LIGHTING);
+}
+StateBlock StateBlock::withLine(const LineParameters & p) const {
+	return with(&StateBlock::line, p, LINE);
+}
+StateBlock StateBlock::withPoint(const PointParameters & p) const {
+	return with(&StateBlock::point, p, POINT);
+}
+StateBlock StateBlock::withPolygonMode(const PolygonModeParameters & p) const {
+	return with(&StateBlock::polygonMode, p, POLYGON_MODE);
+}
+StateBlock StateBlock::withPolygonOffset(const PolygonOffsetParameters & p) const {
+	return with(&StateBlock::polygonOffset, p, POLYGON_OFFSET);
+}
+StateBlock StateBlock::withPrimitiveRestart(const PrimitiveRestartParameters & p) const {
+	return with(&StateBlock::primitiveRestart, p, PRIMITIVE_RESTART);
+}
+StateBlock StateBlock::withStencil(const StencilParameters & p) const {
+	return with(&StateBlock::stencil, p, STENCIL);
+}
+
+StateBlock StateBlock::withMaterial(const MaterialParameters & p) const {
+	StateBlock block(*this);
+	block.material = p;
+	block.materialEnabled = true;
+	block.groups |= MATERIAL;
+	block.updateHash();
+	return block;
+}
+
+StateBlock StateBlock::withMaterialDisabled() const {
+	StateBlock block(*this);
+	block.material = MaterialParameters();
+	block.materialEnabled = false;
+	block.groups |= MATERIAL;
+	block.updateHash();
+	return block;
+}
+
+bool StateBlock::operator==(const StateBlock & other) const {
+	return hash == other.hash && groups == other.groups &&
+			(!contains(ALPHA_TEST) || alphaTest == other.alphaTest) &&
+			(!contains(BLENDING) || blending == other.blending) &&
+			(!contains(COLOR_BUFFER) || colorBuffer == other.colorBuffer) &&
+			(!contains(CULL_FACE) || cullFace == other.cullFace) &&
+			(!contains(DEPTH_BUFFER) || depthBuffer == other.depthBuffer) &&
+			(!contains(LIGHTING) || lighting == other.lighting) &&
+			(!contains(LINE) || line == other.line) &&
+			(!contains(MATERIAL) || (materialEnabled == other.materialEnabled && material == other.material)) &&
+			(!contains(POINT) || point == other.point) &&
+			(!contains(POLYGON_MODE) || polygonMode == other.polygonMode) &&
+			(!contains(POLYGON_OFFSET) || polygonOffset == other.polygonOffset) &&
+			(!contains(PRIMITIVE_RESTART) || primitiveRestart == other.primitiveRestart) &&
+			(!contains(STENCIL) || stencil == other.stencil);
+}
+
+//! (internal) Only the most distinctive values of each group are hashed; operator== compares all values.
+void StateBlock::updateHash() {
+	size_t h = 0;
+	hashCombine(h, groups);
+	if(contains(ALPHA_TEST)) {
+		hashCombine(h, alphaTest.isEnabled());
+		hashCombine(h, static_cast<int>(alphaTest.getMode()));
+		hashCombine(h, alphaTest.getReferenceValue());
+	}
+	if(contains(BLENDING)) {
+		hashCombine(h, blending.isEnabled());
+		hashCombine(h, static_cast<int>(blending.getBlendFuncSrcRGB()));
+		hashCombine(h, static_cast<int>(blending.getBlendFuncDstRGB()));
+		hashCombine(h, static_cast<int>(blending.getBlendEquationRGB()));
+	}
+	if(contains(COLOR_BUFFER)) {
+		hashCombine(h, colorBuffer.isRedWritingEnabled());
+		hashCombine(h, colorBuffer.isAlphaWritingEnabled());
+	}
+	if(contains(CULL_FACE)) {
+		hashCombine(h, cullFace.isEnabled());
+		hashCombine(h, static_cast<int>(cullFace.getMode()));
+	}
+	if(contains(DEPTH_BUFFER)) {
+		hashCombine(h, depthBuffer.isTestEnabled());
+		hashCombine(h, depthBuffer.isWritingEnabled());
+		hashCombine(h, static_cast<int>(depthBuffer.getFunction()));
+	}
+	if(contains(LIGHTING))
+		hashCombine(h, lighting.isEnabled());
+	if(contains(LINE))
+		hashCombine(h, line.getWidth());
+	if(contains(MATERIAL)) {
+		hashCombine(h, materialEnabled);
+		hashCombine(h, material.getDiffuse().getR());
+		hashCombine(h, material.getDiffuse().getG());
+		hashCombine(h, material.getDiffuse().getB());
+		hashCombine(h, material.getDiffuse().getA());
+	}
+	if(contains(POINT)) {
+		hashCombine(h, point.getSize());
+		hashCombine(h, point.isPointSmoothingEnabled());
+	}
+	if(contains(POLYGON_MODE))
+		hashCombine(h, static_cast<int>(polygonMode.getMode()));
+	if(contains(POLYGON_OFFSET)) {
+		hashCombine(h, polygonOffset.isEnabled());
+		hashCombine(h, polygonOffset.getFactor());
+		hashCombine(h, polygonOffset.getUnits());
+	}
+	if(contains(PRIMITIVE_RESTART)) {
+		hashCombine(h, primitiveRestart.isEnabled());
+		hashCombine(h, primitiveRestart.getIndex());
+	}
+	if(contains(STENCIL)) {
+		hashCombine(h, stencil.isEnabled());
+		hashCombine(h, static_cast<int>(stencil.getFunction()));
+		hashCombine(h, stencil.getReferenceValue());
+	}
+	hash = h;
+}
+
+}
@@ -0,0 +1,135 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STATEBLOCK_H_
+#define RENDERING_STATEBLOCK_H_
+
+#include "RenderingParameters.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Rendering {
+
+/**
+ * Immutable snapshot of a chosen set of parameter groups of the RenderingContext.
+ * A block is created either by capturing the current state (RenderingContext::captureStateBlock()) or by
+ * adding groups to an empty block, e.g.
+ * \code
+ * static const StateBlock textState = StateBlock()
+ *		.withBlending(BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA))
+ *		.withDepthBuffer(DepthBufferParameters(false, false, Comparison::LESS));
+ * context.pushStateBlock(textState);
+ * ...
+ * context.popStateBlock();
+ * \endcode
+ * Two blocks are equal if they contain the same groups with equal values; the hash is computed once on creation.
+ * @ingroup context
+ */
+class StateBlock {
+	public:
+		enum group_t : uint32_t {
+			ALPHA_TEST = 1 << 0,
+			BLENDING = 1 << 1,
+			COLOR_BUFFER = 1 << 2,
+			CULL_FACE = 1 << 3,
+			DEPTH_BUFFER = 1 << 4,
+			LIGHTING = 1 << 5,
+			LINE = 1 << 6,
+			MATERIAL = 1 << 7,
+			POINT = 1 << 8,
+			POLYGON_MODE = 1 << 9,
+			POLYGON_OFFSET = 1 << 10,
+			PRIMITIVE_RESTART = 1 << 11,
+			STENCIL = 1 << 12,
+			ALL_GROUPS = (1 << 13) - 1
+		};
+
+		//! Create an empty block (containing no group).
+		StateBlock() : groups(0), hash(0), materialEnabled(false) {}
+
+		//! @name Creation (each function returns a copy of this block with the group added or replaced)
+		//	@{
+		RENDERINGAPI StateBlock withAlphaTest(const AlphaTestParameters & p) const;
+		RENDERINGAPI StateBlock withBlending(const BlendingParameters & p) const;
+		RENDERINGAPI StateBlock withColorBuffer(const ColorBufferParameters & p) const;
+		RENDERINGAPI StateBlock withCullFace(const CullFaceParameters & p) const;
+		RENDERINGAPI StateBlock withDepthBuffer(const DepthBufferParameters & p) const;
+		RENDERINGAPI StateBlock withLighting(const LightingParameters & p) const;
+		RENDERINGAPI StateBlock withLine(const LineParameters & p) const;
+		RENDERINGAPI StateBlock withMaterial(const MaterialParameters & p) const;
+		//! The material group with disabled material (as after popping the last material).
+		RENDERINGAPI StateBlock withMaterialDisabled() const;
+		RENDERINGAPI StateBlock withPoint(const PointParameters & p) const;
+		RENDERINGAPI StateBlock withPolygonMode(const PolygonModeParameters & p) const;
+		RENDERINGAPI StateBlock withPolygonOffset(const PolygonOffsetParameters & p) const;
+		RENDERINGAPI StateBlock withPrimitiveRestart(const PrimitiveRestartParameters & p) const;
+		RENDERINGAPI StateBlock withStencil(const StencilParameters & p) const;
+		//	@}
+
+		//! Bit mask of the contained groups (group_t).
+		uint32_t getGroups() const								{	return groups;	}
+		bool contains(group_t group) const						{	return (groups & group) != 0;	}
+
+		//! @name Values (only valid if the group is contained)
+		//	@{
+		const AlphaTestParameters & getAlphaTest() const				{	return alphaTest;	}
+		const BlendingParameters & getBlending() const					{	return blending;	}
+		const ColorBufferParameters & getColorBuffer() const			{	return colorBuffer;	}
+		const CullFaceParameters & getCullFace() const					{	return cullFace;	}
+		const DepthBufferParameters & getDepthBuffer() const			{	return depthBuffer;	}
+		const LightingParameters & getLighting() const					{	return lighting;	}
+		const LineParameters & getLine() const							{	return line;	}
+		const MaterialParameters & getMaterial() const					{	return material;	}
+		bool isMaterialEnabled() const									{	return materialEnabled;	}
+		const PointParameters & getPoint() const						{	return point;	}
+		const PolygonModeParameters & getPolygonMode() const			{	return polygonMode;	}
+		const PolygonOffsetParameters & getPolygonOffset() const		{	return polygonOffset;	}
+		const PrimitiveRestartParameters & getPrimitiveRestart() const	{	return primitiveRestart;	}
+		const StencilParameters & getStencil() const					{	return stencil;	}
+		//	@}
+
+		size_t getHash() const									{	return hash;	}
+		RENDERINGAPI bool operator==(const StateBlock & other) const;
+		bool operator!=(const StateBlock & other) const			{	return !(*this == other);	}
+
+	private:
+		uint32_t groups;
+		size_t hash;
+
+		AlphaTestParameters alphaTest;
+		BlendingParameters blending;
+		ColorBufferParameters colorBuffer;
+		CullFaceParameters cullFace;
+		DepthBufferParameters depthBuffer;
+		LightingParameters lighting;
+		LineParameters line;
+		MaterialParameters material;
+		bool materialEnabled;
+		PointParameters point;
+		PolygonModeParameters polygonMode;
+		PolygonOffsetParameters polygonOffset;
+		PrimitiveRestartParameters primitiveRestart;
+		StencilParameters stencil;
+
+		template<typename Parameters_t>
+		StateBlock with(Parameters_t StateBlock::* member, const Parameters_t & p, group_t group) const;
+		void updateHash();
+};
+
+}
+
+namespace std {
+template <> struct hash<Rendering::StateBlock> {
+	size_t operator()(const Rendering::StateBlock & block) const noexcept {
+		return block.getHash();
+	}
+};
+}
+
+#endif /* RENDERING_STATEBLOCK_H_ */
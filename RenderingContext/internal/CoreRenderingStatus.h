@@ -25,8 +25,11 @@ class CoreRenderingStatus {
 	//	@{
 	public:
 		CoreRenderingStatus() :
+			dirtyGroups(ALL_GROUPS),
+			dirtyTextureUnits(ALL_TEXTURE_UNITS),
+			issuedStateCalls(0),
+			elidedStateCalls(0),
 			alphaTestParameters(),
-			blendingCheckNumber(0),
 			blendingParameters(),
 			colorBufferParameters(), 
 			cullFaceParameters(),
@@ -36,15 +39,78 @@ class CoreRenderingStatus {
 			polygonModeParameters(),
 			polygonOffsetParameters(),
 			primitiveRestartParameters(),
-			stencilCheckNumber(),
 			stencilParameters(),
-			texturesCheckNumber(),
 			boundTextures() {
 		}
 	//	@}
 
 	// -------------------------------
 
+	/*!	@name Dirty groups
+		The set* functions mark the changed parameter group as dirty, so that StatusHandler_glCore::apply() only has to
+		check the dirty groups. Setting a value that equals the current one is detected here and counted as an
+		elided state call. The update* functions are used for the status that mirrors the applied OpenGL state
+		and do not change the dirty groups or the counters. */
+	//	@{
+	public:
+		enum group_t : uint32_t {
+			ALPHA_TEST = 1 << 0,
+			BLENDING = 1 << 1,
+			COLOR_BUFFER = 1 << 2,
+			CULL_FACE = 1 << 3,
+			DEPTH_BUFFER = 1 << 4,
+			LIGHTING = 1 << 5,
+			LINE = 1 << 6,
+			POLYGON_MODE = 1 << 7,
+			POLYGON_OFFSET = 1 << 8,
+			PRIMITIVE_RESTART = 1 << 9,
+			STENCIL = 1 << 10,
+			TEXTURES = 1 << 11,
+			ALL_GROUPS = (1 << 12) - 1
+		};
+		static constexpr uint32_t ALL_TEXTURE_UNITS = MAX_TEXTURES >= 32 ? 0xffffffffu : ((1u << MAX_TEXTURES) - 1);
+		static_assert(MAX_TEXTURES <= 32, "dirtyTextureUnits has to be extended.");
+
+		uint32_t getDirtyGroups() const					{	return dirtyGroups;	}
+		uint32_t getDirtyTextureUnits() const			{	return dirtyTextureUnits;	}
+		void clearDirtyGroups() {
+			dirtyGroups = 0;
+			dirtyTextureUnits = 0;
+		}
+
+		//! Number of issued OpenGL state calls (counted by StatusHandler_glCore::apply())
+		uint32_t getIssuedStateCalls() const			{	return issuedStateCalls;	}
+		//! Number of redundant state changes that did not result in an OpenGL call
+		uint32_t getElidedStateCalls() const			{	return elidedStateCalls;	}
+		void countStateCalls(uint32_t issued, uint32_t elided) {
+			issuedStateCalls += issued;
+			elidedStateCalls += elided;
+		}
+		void resetStateCallCounters() {
+			issuedStateCalls = 0;
+			elidedStateCalls = 0;
+		}
+
+	private:
+		uint32_t dirtyGroups;
+		//! Bit i is set if the texture of unit i has been changed
+		uint32_t dirtyTextureUnits;
+		uint32_t issuedStateCalls;
+		uint32_t elidedStateCalls;
+
+		template<typename Parameters_t>
+		void setParameters(Parameters_t & parameters, const Parameters_t & p, group_t group) {
+			if(parameters == p) {
+				++elidedStateCalls;
+			} else {
+				parameters = p;
+				dirtyGroups |= group;
+			}
+		}
+	//	@}
+
+	// -------------------------------
+
 	//!	@name AlphaTest
 	//	@{
 	private:
@@ -56,8 +122,11 @@ class CoreRenderingStatus {
 		const AlphaTestParameters & getAlphaTestParameters()const {
 			return alphaTestParameters;
 		}
-		void setAlphaTestParameters(const AlphaTestParameters & p){
-			alphaTestParameters=p;
+		void setAlphaTestParameters(const AlphaTestParameters & p) {
+			setParameters(alphaTestParameters, p, ALPHA_TEST);
+		}
+		void updateAlphaTestParameters(const CoreRenderingStatus & actual) {
+			alphaTestParameters = actual.alphaTestParameters;
 		}
 
 	//	@}
@@ -67,28 +136,20 @@ class CoreRenderingStatus {
 	//!	@name Blending
 	//	@{
 	private:
-		uint32_t blendingCheckNumber;
 		BlendingParameters blendingParameters;
 
 	public:
 		bool blendingParametersChanged(const CoreRenderingStatus & actual) const {
-			return (blendingCheckNumber == actual.blendingCheckNumber) ? false :
-					(blendingParameters != actual.blendingParameters);
+			return blendingParameters != actual.blendingParameters;
 		}
 		const BlendingParameters & getBlendingParameters() const {
 			return blendingParameters;
 		}
 		void setBlendingParameters(const BlendingParameters & p) {
-			blendingParameters = p;
-			++blendingCheckNumber;
-		}
-		void updateBlendingParameters(const BlendingParameters & p,uint32_t _checkNumber) {
-			blendingParameters = p;
-			blendingCheckNumber = _checkNumber;
+			setParameters(blendingParameters, p, BLENDING);
 		}
 		void updateBlendingParameters(const CoreRenderingStatus & other) {
 			blendingParameters = other.blendingParameters;
-			blendingCheckNumber = other.blendingCheckNumber;
 		}
 
 	//	@}
@@ -107,7 +168,10 @@ class CoreRenderingStatus {
 			return colorBufferParameters;
 		}
 		void setColorBufferParameters(const ColorBufferParameters & p) {
-			colorBufferParameters = p;
+			setParameters(colorBufferParameters, p, COLOR_BUFFER);
+		}
+		void updateColorBufferParameters(const CoreRenderingStatus & actual) {
+			colorBufferParameters = actual.colorBufferParameters;
 		}
 	//	@}
 
@@ -124,8 +188,11 @@ class CoreRenderingStatus {
 		const CullFaceParameters & getCullFaceParameters()const {
 			return cullFaceParameters;
 		}
-		void setCullFaceParameters(const CullFaceParameters & p){
-			cullFaceParameters=p;
+		void setCullFaceParameters(const CullFaceParameters & p) {
+			setParameters(cullFaceParameters, p, CULL_FACE);
+		}
+		void updateCullFaceParameters(const CoreRenderingStatus & actual) {
+			cullFaceParameters = actual.cullFaceParameters;
 		}
 
 	//	@}
@@ -144,7 +211,10 @@ class CoreRenderingStatus {
 			return depthBufferParameters;
 		}
 		void setDepthBufferParameters(const DepthBufferParameters & p) {
-			depthBufferParameters = p;
+			setParameters(depthBufferParameters, p, DEPTH_BUFFER);
+		}
+		void updateDepthBufferParameters(const CoreRenderingStatus & actual) {
+			depthBufferParameters = actual.depthBufferParameters;
 		}
 	//	@}
 
@@ -162,7 +232,10 @@ class CoreRenderingStatus {
 			return lightingParameters;
 		}
 		void setLightingParameters(const LightingParameters & p) {
-			lightingParameters = p;
+			setParameters(lightingParameters, p, LIGHTING);
+		}
+		void updateLightingParameters(const CoreRenderingStatus & actual) {
+			lightingParameters = actual.lightingParameters;
 		}
 	//	@}
 
@@ -180,7 +253,10 @@ class CoreRenderingStatus {
 			return lineParameters;
 		}
 		void setLineParameters(const LineParameters & p) {
-			lineParameters = p;
+			setParameters(lineParameters, p, LINE);
+		}
+		void updateLineParameters(const CoreRenderingStatus & actual) {
+			lineParameters = actual.lineParameters;
 		}
 	//	@}
 
@@ -197,8 +273,11 @@ class CoreRenderingStatus {
 		const PolygonModeParameters & getPolygonModeParameters()const {
 			return polygonModeParameters;
 		}
-		void setPolygonModeParameters(const PolygonModeParameters & p){
-			polygonModeParameters=p;
+		void setPolygonModeParameters(const PolygonModeParameters & p) {
+			setParameters(polygonModeParameters, p, POLYGON_MODE);
+		}
+		void updatePolygonModeParameters(const CoreRenderingStatus & actual) {
+			polygonModeParameters = actual.polygonModeParameters;
 		}
 
 	//	@}
@@ -217,7 +296,10 @@ class CoreRenderingStatus {
 			return polygonOffsetParameters;
 		}
 		void setPolygonOffsetParameters(const PolygonOffsetParameters & p) {
-			polygonOffsetParameters = p;
+			setParameters(polygonOffsetParameters, p, POLYGON_OFFSET);
+		}
+		void updatePolygonOffsetParameters(const CoreRenderingStatus & actual) {
+			polygonOffsetParameters = actual.polygonOffsetParameters;
 		}
 	//	@}
 
@@ -235,7 +317,10 @@ class CoreRenderingStatus {
 			return primitiveRestartParameters;
 		}
 		void setPrimitiveRestartParameters(const PrimitiveRestartParameters & p) {
-			primitiveRestartParameters = p;
+			setParameters(primitiveRestartParameters, p, PRIMITIVE_RESTART);
+		}
+		void updatePrimitiveRestartParameters(const CoreRenderingStatus & actual) {
+			primitiveRestartParameters = actual.primitiveRestartParameters;
 		}
 	//	@}
 
@@ -244,50 +329,46 @@ class CoreRenderingStatus {
 	//!	@name Stencil
 	//	@{
 	private:
-		uint32_t stencilCheckNumber;
 		StencilParameters stencilParameters;
 
 	public:
 		bool stencilParametersChanged(const CoreRenderingStatus & actual) const {
-			return (stencilCheckNumber == actual.stencilCheckNumber) ? false : (stencilParameters != actual.stencilParameters);
+			return stencilParameters != actual.stencilParameters;
 		}
 		const StencilParameters & getStencilParameters() const {
 			return stencilParameters;
 		}
 		void setStencilParameters(const StencilParameters & p) {
-			stencilParameters = p;
-			++stencilCheckNumber;
-		}
-		void updateStencilParameters(const StencilParameters & p, uint32_t _checkNumber) {
-			stencilParameters = p;
-			stencilCheckNumber = _checkNumber;
+			setParameters(stencilParameters, p, STENCIL);
 		}
 		void updateStencilParameters(const CoreRenderingStatus & other) {
 			stencilParameters = other.stencilParameters;
-			stencilCheckNumber = other.stencilCheckNumber;
 		}
 	//	@}
 
 	//!	@name Textures
 	//	@{
 	private:
-		uint32_t texturesCheckNumber;
 		std::array<Util::Reference<Texture>, MAX_TEXTURES> boundTextures;
 
 	public:
 		void setTexture(uint8_t unit, Util::Reference<Texture> texture) {
-			++texturesCheckNumber;
-			boundTextures.at(unit) = std::move(texture);
+			if(boundTextures.at(unit) == texture) {
+				++elidedStateCalls;
+			} else {
+				boundTextures[unit] = std::move(texture);
+				dirtyGroups |= TEXTURES;
+				dirtyTextureUnits |= 1u << unit;
+			}
 		}
 		const Util::Reference<Texture> & getTexture(uint8_t unit) const {
 			return boundTextures.at(unit);
 		}
 		bool texturesChanged(const CoreRenderingStatus & actual) const {
-			return (texturesCheckNumber == actual.texturesCheckNumber) ? false : (boundTextures != actual.boundTextures);
+			return boundTextures != actual.boundTextures;
 		}
-		void updateTextures(const CoreRenderingStatus & actual) {
-			boundTextures = actual.boundTextures;
-			texturesCheckNumber = actual.texturesCheckNumber;
+		void updateTexture(uint8_t unit, const CoreRenderingStatus & actual) {
+			boundTextures.at(unit) = actual.boundTextures.at(unit);
 		}
 	//	@}
 };
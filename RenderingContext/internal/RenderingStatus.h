@@ -33,11 +33,13 @@ class RenderingStatus {
 	private:
 		Util::Reference<Shader> shader;
 		bool initialized;
+		uint8_t sgUniformBlocks;
 
 	public:
 		explicit RenderingStatus(Shader * _shader = nullptr) : 
 			shader(_shader), 
 			initialized(false),
+			sgUniformBlocks(0),
 			checkNumber_matrixCameraWorld(0),
 			matrix_worldToCamera(),
 			matrix_cameraToWorld(),
@@ -58,6 +60,9 @@ class RenderingStatus {
 		Shader * getShader() 						{	return shader.get();	}
 		bool isInitialized()const					{	return initialized;	}
 		void markInitialized()						{	initialized=true;	}
+		//! sg_ uniform blocks (see StatusHandler_sgUniformBlocks) used when the status was last applied
+		uint8_t getSGUniformBlocks()const			{	return sgUniformBlocks;	}
+		void setSGUniformBlocks(uint8_t blocks)		{	sgUniformBlocks = blocks;	}
 	//	@}
 
 	// -------------------------------
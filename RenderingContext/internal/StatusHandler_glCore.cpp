@@ -46,205 +46,278 @@ static GLenum convertStencilAction(StencilParameters::action_t action) {
 	throw std::invalid_argument("Invalid StencilParameters::action_t enumerator");
 }
 
-void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced) {
+void apply(CoreRenderingStatus & target, CoreRenderingStatus & actual, bool forced) {
+	const uint32_t dirty = forced ? static_cast<uint32_t>(CoreRenderingStatus::ALL_GROUPS) : actual.getDirtyGroups();
+	if(dirty == 0)
+		return;
+	// number of issued OpenGL calls and of dirty groups that did not need any call
+	uint32_t issued = 0;
+	uint32_t elided = 0;
+
 	// Blending
-	if(forced || target.blendingParametersChanged(actual)) {
-		const BlendingParameters & targetParams = target.getBlendingParameters();
-		const BlendingParameters & actualParams = actual.getBlendingParameters();
-		if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
-			if(actualParams.isEnabled()) {
-				glEnable(GL_BLEND);
-			} else {
-				glDisable(GL_BLEND);
+	if(dirty & CoreRenderingStatus::BLENDING) {
+		if(forced || target.blendingParametersChanged(actual)) {
+			const BlendingParameters & targetParams = target.getBlendingParameters();
+			const BlendingParameters & actualParams = actual.getBlendingParameters();
+			if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
+				if(actualParams.isEnabled()) {
+					glEnable(GL_BLEND);
+				} else {
+					glDisable(GL_BLEND);
+				}
+				++issued;
 			}
+			if(forced ||
+					targetParams.getBlendFuncSrcRGB() != actualParams.getBlendFuncSrcRGB() ||
+					targetParams.getBlendFuncDstRGB() != actualParams.getBlendFuncDstRGB() ||
+					targetParams.getBlendFuncSrcAlpha() != actualParams.getBlendFuncSrcAlpha() ||
+					targetParams.getBlendFuncDstAlpha() != actualParams.getBlendFuncDstAlpha()) {
+				glBlendFuncSeparate(BlendingParameters::functionToGL(actualParams.getBlendFuncSrcRGB()),
+									BlendingParameters::functionToGL(actualParams.getBlendFuncDstRGB()),
+									BlendingParameters::functionToGL(actualParams.getBlendFuncSrcAlpha()),
+									BlendingParameters::functionToGL(actualParams.getBlendFuncDstAlpha()));
+				++issued;
+			}
+			if(forced || targetParams.getBlendColor() != actualParams.getBlendColor()) {
+				glBlendColor(actualParams.getBlendColor().getR(),
+							 actualParams.getBlendColor().getG(),
+							 actualParams.getBlendColor().getB(),
+							 actualParams.getBlendColor().getA());
+				++issued;
+			}
+			if(forced ||
+					targetParams.getBlendEquationRGB() != actualParams.getBlendEquationRGB() ||
+					targetParams.getBlendEquationAlpha() != actualParams.getBlendEquationAlpha()) {
+				glBlendEquationSeparate(BlendingParameters::equationToGL(actualParams.getBlendEquationRGB()),
+										BlendingParameters::equationToGL(actualParams.getBlendEquationAlpha()));
+				++issued;
+			}
+			target.updateBlendingParameters(actual);
+		} else {
+			++elided;
 		}
-		if(forced ||
-				targetParams.getBlendFuncSrcRGB() != actualParams.getBlendFuncSrcRGB() ||
-				targetParams.getBlendFuncDstRGB() != actualParams.getBlendFuncDstRGB() ||
-				targetParams.getBlendFuncSrcAlpha() != actualParams.getBlendFuncSrcAlpha() ||
-				targetParams.getBlendFuncDstAlpha() != actualParams.getBlendFuncDstAlpha()) {
-			glBlendFuncSeparate(BlendingParameters::functionToGL(actualParams.getBlendFuncSrcRGB()),
-								BlendingParameters::functionToGL(actualParams.getBlendFuncDstRGB()),
-								BlendingParameters::functionToGL(actualParams.getBlendFuncSrcAlpha()),
-								BlendingParameters::functionToGL(actualParams.getBlendFuncDstAlpha()));
-		}
-		if(forced || targetParams.getBlendColor() != actualParams.getBlendColor()) {
-			glBlendColor(actualParams.getBlendColor().getR(),
-						 actualParams.getBlendColor().getG(),
-						 actualParams.getBlendColor().getB(),
-						 actualParams.getBlendColor().getA());
-		}
-		if(forced ||
-				targetParams.getBlendEquationRGB() != actualParams.getBlendEquationRGB() ||
-				targetParams.getBlendEquationAlpha() != actualParams.getBlendEquationAlpha()) {
-			glBlendEquationSeparate(BlendingParameters::equationToGL(actualParams.getBlendEquationRGB()),
-									BlendingParameters::equationToGL(actualParams.getBlendEquationAlpha()));
-		}
-		target.updateBlendingParameters(actual);
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 
 	// ColorBuffer
-	if(forced || target.colorBufferParametersChanged(actual)) {
-		glColorMask(
-			actual.getColorBufferParameters().isRedWritingEnabled() ? GL_TRUE : GL_FALSE,
-			actual.getColorBufferParameters().isGreenWritingEnabled() ? GL_TRUE : GL_FALSE,
-			actual.getColorBufferParameters().isBlueWritingEnabled() ? GL_TRUE : GL_FALSE,
-			actual.getColorBufferParameters().isAlphaWritingEnabled() ? GL_TRUE : GL_FALSE
-		);
-		target.setColorBufferParameters(actual.getColorBufferParameters());
+	if(dirty & CoreRenderingStatus::COLOR_BUFFER) {
+		if(forced || target.colorBufferParametersChanged(actual)) {
+			glColorMask(
+				actual.getColorBufferParameters().isRedWritingEnabled() ? GL_TRUE : GL_FALSE,
+				actual.getColorBufferParameters().isGreenWritingEnabled() ? GL_TRUE : GL_FALSE,
+				actual.getColorBufferParameters().isBlueWritingEnabled() ? GL_TRUE : GL_FALSE,
+				actual.getColorBufferParameters().isAlphaWritingEnabled() ? GL_TRUE : GL_FALSE
+			);
+			++issued;
+			target.updateColorBufferParameters(actual);
+		} else {
+			++elided;
+		}
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 
 	// CullFace
-	if(forced || target.cullFaceParametersChanged(actual)) {
-		if(actual.getCullFaceParameters().isEnabled()) {
-			glEnable(GL_CULL_FACE);
+	if(dirty & CoreRenderingStatus::CULL_FACE) {
+		if(forced || target.cullFaceParametersChanged(actual)) {
+			if(actual.getCullFaceParameters().isEnabled()) {
+				glEnable(GL_CULL_FACE);
 
+			} else {
+				glDisable(GL_CULL_FACE);
+			}
+			switch(actual.getCullFaceParameters().getMode()) {
+				case CullFaceParameters::CULL_BACK:
+					glCullFace(GL_BACK);
+					break;
+				case CullFaceParameters::CULL_FRONT:
+					glCullFace(GL_FRONT);
+					break;
+				case CullFaceParameters::CULL_FRONT_AND_BACK:
+					glCullFace(GL_FRONT_AND_BACK);
+					break;
+				default:
+					throw std::invalid_argument("Invalid CullFaceParameters::cullFaceMode_t enumerator");
+			}
+			issued += 2;
+			target.updateCullFaceParameters(actual);
 		} else {
-			glDisable(GL_CULL_FACE);
+			++elided;
 		}
-		switch(actual.getCullFaceParameters().getMode()) {
-			case CullFaceParameters::CULL_BACK:
-				glCullFace(GL_BACK);
-				break;
-			case CullFaceParameters::CULL_FRONT:
-				glCullFace(GL_FRONT);
-				break;
-			case CullFaceParameters::CULL_FRONT_AND_BACK:
-				glCullFace(GL_FRONT_AND_BACK);
-				break;
-			default:
-				throw std::invalid_argument("Invalid CullFaceParameters::cullFaceMode_t enumerator");
-		}
-		target.setCullFaceParameters(actual.getCullFaceParameters());
 	}
 
 	// DepthBuffer
-	if(forced || target.depthBufferParametersChanged(actual)) {
-		if(actual.getDepthBufferParameters().isTestEnabled()) {
-			glEnable(GL_DEPTH_TEST);
-		} else {
-			glDisable(GL_DEPTH_TEST);
-		}
-		if(actual.getDepthBufferParameters().isWritingEnabled()) {
-			glDepthMask(GL_TRUE);
+	if(dirty & CoreRenderingStatus::DEPTH_BUFFER) {
+		if(forced || target.depthBufferParametersChanged(actual)) {
+			if(actual.getDepthBufferParameters().isTestEnabled()) {
+				glEnable(GL_DEPTH_TEST);
+			} else {
+				glDisable(GL_DEPTH_TEST);
+			}
+			if(actual.getDepthBufferParameters().isWritingEnabled()) {
+				glDepthMask(GL_TRUE);
+			} else {
+				glDepthMask(GL_FALSE);
+			}
+			glDepthFunc(Comparison::functionToGL(actual.getDepthBufferParameters().getFunction()));
+			issued += 3;
+			target.updateDepthBufferParameters(actual);
 		} else {
-			glDepthMask(GL_FALSE);
+			++elided;
 		}
-		glDepthFunc(Comparison::functionToGL(actual.getDepthBufferParameters().getFunction()));
-		target.setDepthBufferParameters(actual.getDepthBufferParameters());
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 
 	// Line
-	if(forced || target.lineParametersChanged(actual)) {
-		auto width = actual.getLineParameters().getWidth();
-		glLineWidth(RenderingContext::getCompabilityMode() ? width : std::min(width, 1.0f));
-		target.setLineParameters(actual.getLineParameters());
+	if(dirty & CoreRenderingStatus::LINE) {
+		if(forced || target.lineParametersChanged(actual)) {
+			auto width = actual.getLineParameters().getWidth();
+			glLineWidth(RenderingContext::getCompabilityMode() ? width : std::min(width, 1.0f));
+			++issued;
+			target.updateLineParameters(actual);
+		} else {
+			++elided;
+		}
 	}
 
 	// stencil
-	if (forced || target.stencilParametersChanged(actual)) {
-		const StencilParameters & targetParams = target.getStencilParameters();
-		const StencilParameters & actualParams = actual.getStencilParameters();
-		if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
-			if(actualParams.isEnabled()) {
-				glEnable(GL_STENCIL_TEST);
-			} else {
-				glDisable(GL_STENCIL_TEST);
+	if(dirty & CoreRenderingStatus::STENCIL) {
+		if(forced || target.stencilParametersChanged(actual)) {
+			const StencilParameters & targetParams = target.getStencilParameters();
+			const StencilParameters & actualParams = actual.getStencilParameters();
+			if(forced || targetParams.isEnabled() != actualParams.isEnabled()) {
+				if(actualParams.isEnabled()) {
+					glEnable(GL_STENCIL_TEST);
+				} else {
+					glDisable(GL_STENCIL_TEST);
+				}
+				++issued;
 			}
+			if(forced || targetParams.differentFunctionParameters(actualParams)) {
+				glStencilFunc(Comparison::functionToGL(actualParams.getFunction()), actualParams.getReferenceValue(), actualParams.getBitMask().to_ulong());
+				++issued;
+			}
+			if(forced || targetParams.differentActionParameters(actualParams)) {
+				glStencilOp(convertStencilAction(actualParams.getFailAction()),
+							convertStencilAction(actualParams.getDepthTestFailAction()),
+							convertStencilAction(actualParams.getDepthTestPassAction()));
+				++issued;
+			}
+			target.updateStencilParameters(actual);
+		} else {
+			++elided;
 		}
-		if(forced || targetParams.differentFunctionParameters(actualParams)) {
-			glStencilFunc(Comparison::functionToGL(actualParams.getFunction()), actualParams.getReferenceValue(), actualParams.getBitMask().to_ulong());
-		}
-		if(forced || targetParams.differentActionParameters(actualParams)) {
-			glStencilOp(convertStencilAction(actualParams.getFailAction()),
-						convertStencilAction(actualParams.getDepthTestFailAction()),
-						convertStencilAction(actualParams.getDepthTestPassAction()));
-		}
-		target.updateStencilParameters(actual);
+		GET_GL_ERROR();
 	}
 
-	GET_GL_ERROR();
-
 #ifdef LIB_GL
  	if(RenderingContext::getCompabilityMode()) {
 		// AlphaTest
-		if(forced || target.alphaTestParametersChanged(actual)) {
-			if(actual.getAlphaTestParameters().isEnabled()) {
-				glDisable(GL_ALPHA_TEST);
+		if(dirty & CoreRenderingStatus::ALPHA_TEST) {
+			if(forced || target.alphaTestParametersChanged(actual)) {
+				if(actual.getAlphaTestParameters().isEnabled()) {
+					glDisable(GL_ALPHA_TEST);
+				} else {
+					glEnable(GL_ALPHA_TEST);
+				}
+				glAlphaFunc(Comparison::functionToGL(actual.getAlphaTestParameters().getMode()), actual.getAlphaTestParameters().getReferenceValue());
+				issued += 2;
+				target.updateAlphaTestParameters(actual);
 			} else {
-				glEnable(GL_ALPHA_TEST);
+				++elided;
 			}
-			glAlphaFunc(Comparison::functionToGL(actual.getAlphaTestParameters().getMode()), actual.getAlphaTestParameters().getReferenceValue());
-			target.setAlphaTestParameters(actual.getAlphaTestParameters());
+			GET_GL_ERROR();
 		}
-		GET_GL_ERROR();
  	}
 #endif /* LIB_GL */
 
 	// Lighting
-	if(forced || target.lightingParametersChanged(actual)) {
+	if(dirty & CoreRenderingStatus::LIGHTING) {
+		if(forced || target.lightingParametersChanged(actual)) {
 #ifdef LIB_GL
- 		if(RenderingContext::getCompabilityMode()) {
-			if(actual.getLightingParameters().isEnabled()) {
-				glEnable(GL_LIGHTING);
-			} else {
-				glDisable(GL_LIGHTING);
-			}
- 		}
+	 		if(RenderingContext::getCompabilityMode()) {
+				if(actual.getLightingParameters().isEnabled()) {
+					glEnable(GL_LIGHTING);
+				} else {
+					glDisable(GL_LIGHTING);
+				}
+				++issued;
+	 		}
 #endif /* LIB_GL */
-		target.setLightingParameters(actual.getLightingParameters());
+			target.updateLightingParameters(actual);
+		} else {
+			++elided;
+		}
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 
 #ifdef LIB_GL
 	// polygonMode
-	if(forced || target.polygonModeParametersChanged(actual) ) {
-		glPolygonMode(GL_FRONT_AND_BACK, PolygonModeParameters::modeToGL(actual.getPolygonModeParameters().getMode()));
-		target.setPolygonModeParameters(actual.getPolygonModeParameters());
+	if(dirty & CoreRenderingStatus::POLYGON_MODE) {
+		if(forced || target.polygonModeParametersChanged(actual)) {
+			glPolygonMode(GL_FRONT_AND_BACK, PolygonModeParameters::modeToGL(actual.getPolygonModeParameters().getMode()));
+			++issued;
+			target.updatePolygonModeParameters(actual);
+		} else {
+			++elided;
+		}
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 #endif /* LIB_GL */
 
 	// PolygonOffset
-	if(forced || target.polygonOffsetParametersChanged(actual)) {
-		if(actual.getPolygonOffsetParameters().isEnabled()) {
-			glEnable(GL_POLYGON_OFFSET_FILL);
+	if(dirty & CoreRenderingStatus::POLYGON_OFFSET) {
+		if(forced || target.polygonOffsetParametersChanged(actual)) {
+			if(actual.getPolygonOffsetParameters().isEnabled()) {
+				glEnable(GL_POLYGON_OFFSET_FILL);
 #ifdef LIB_GL
-			glEnable(GL_POLYGON_OFFSET_LINE);
-			glEnable(GL_POLYGON_OFFSET_POINT);
+				glEnable(GL_POLYGON_OFFSET_LINE);
+				glEnable(GL_POLYGON_OFFSET_POINT);
+				issued += 2;
 #endif /* LIB_GL */
-			glPolygonOffset(actual.getPolygonOffsetParameters().getFactor(), actual.getPolygonOffsetParameters().getUnits());
-		} else {
-			glDisable(GL_POLYGON_OFFSET_FILL);
+				glPolygonOffset(actual.getPolygonOffsetParameters().getFactor(), actual.getPolygonOffsetParameters().getUnits());
+				issued += 2;
+			} else {
+				glDisable(GL_POLYGON_OFFSET_FILL);
 #ifdef LIB_GL
-			glDisable(GL_POLYGON_OFFSET_LINE);
-			glDisable(GL_POLYGON_OFFSET_POINT);
+				glDisable(GL_POLYGON_OFFSET_LINE);
+				glDisable(GL_POLYGON_OFFSET_POINT);
+				issued += 2;
 #endif /* LIB_GL */
+				++issued;
+			}
+			target.updatePolygonOffsetParameters(actual);
+		} else {
+			++elided;
 		}
-		target.setPolygonOffsetParameters(actual.getPolygonOffsetParameters());
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
 
 		// PrimitiveRestart
 	#ifdef LIB_GL
-		if(forced || target.primitiveRestartParametersChanged(actual)) {
-			if(actual.getPrimitiveRestartParameters().isEnabled()) {
-				glEnable(GL_PRIMITIVE_RESTART);
-				glPrimitiveRestartIndex(actual.getPrimitiveRestartParameters().getIndex());
+		if(dirty & CoreRenderingStatus::PRIMITIVE_RESTART) {
+			if(forced || target.primitiveRestartParametersChanged(actual)) {
+				if(actual.getPrimitiveRestartParameters().isEnabled()) {
+					glEnable(GL_PRIMITIVE_RESTART);
+					glPrimitiveRestartIndex(actual.getPrimitiveRestartParameters().getIndex());
+					issued += 2;
+				} else {
+					glDisable(GL_PRIMITIVE_RESTART);
+					++issued;
+				}
+				target.updatePrimitiveRestartParameters(actual);
 			} else {
-				glDisable(GL_PRIMITIVE_RESTART);
+				++elided;
 			}
-			target.setPrimitiveRestartParameters(actual.getPrimitiveRestartParameters());
+			GET_GL_ERROR();
 		}
-		GET_GL_ERROR();
 	#endif /* LIB_GL */
 
-	// Textures
-	if(forced || target.texturesChanged(actual)) {
+	// Textures (only the changed units are checked)
+	if(dirty & CoreRenderingStatus::TEXTURES) {
+		const uint32_t dirtyUnits = forced ? CoreRenderingStatus::ALL_TEXTURE_UNITS : actual.getDirtyTextureUnits();
 		for(uint_fast8_t unit = 0; unit < MAX_TEXTURES; ++unit) {
+			if((dirtyUnits & (1u << unit)) == 0)
+				continue;
 			const auto & texture = actual.getTexture(unit);
 			const auto & oldTexture = target.getTexture(unit);
 			if(forced || texture != oldTexture) {
@@ -253,19 +326,27 @@ void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, boo
 					glBindTexture(texture->getGLTextureType(), texture->getGLId());
 #if defined(LIB_GL)
 					BufferObject* buffer = texture->getBufferObject();
-					if(buffer)
+					if(buffer) {
 						glTexBuffer( GL_TEXTURE_BUFFER, texture->getFormat().pixelFormat.glInternalFormat, buffer->getGLId() );
+						++issued;
+					}
 #endif
 				} else if( oldTexture ) {
 					glBindTexture(oldTexture->getGLTextureType(), 0);
 				} else {
 					glBindTexture(GL_TEXTURE_2D, 0);
 				}
+				issued += 2;
+				target.updateTexture(unit, actual);
+			} else {
+				++elided;
 			}
 		}
-		target.updateTextures(actual);
+		GET_GL_ERROR();
 	}
-	GET_GL_ERROR();
+
+	actual.clearDirtyGroups();
+	actual.countStateCalls(issued, elided);
 }
 
 }
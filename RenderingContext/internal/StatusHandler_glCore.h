@@ -17,7 +17,10 @@ class CoreRenderingStatus;
 //! @internal
 namespace StatusHandler_glCore{
 
-void apply(CoreRenderingStatus & target, const CoreRenderingStatus & actual, bool forced);
+/*! Applies the dirty parameter groups of @p actual (all groups if @p forced is set) to OpenGL, updates @p target
+	(the applied state) and clears the dirty groups of @p actual. The issued and elided OpenGL state calls are
+	counted in @p actual. */
+void apply(CoreRenderingStatus & target, CoreRenderingStatus & actual, bool forced);
 
 }
 }
@@ -0,0 +1,249 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "StatusHandler_sgUniformBlocks.h"
+#include "RenderingStatus.h"
+#include "../../BufferObject.h"
+#include "../../GLHeader.h"
+#include "../../Helper.h"
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace Rendering {
+namespace StatusHandler_sgUniformBlocks {
+
+const char * const BLOCK_NAMES[BLOCK_COUNT] = {"sg_CameraBlock", "sg_TransformBlock", "sg_LightBlock", "sg_MaterialBlock"};
+
+// std140 layouts of the blocks (see StatusHandler_sgUniformBlocks.h)
+struct CameraBlock {
+	float worldToCamera[16];
+	float cameraToWorld[16];
+	float cameraToClipping[16];
+	float clippingToCamera[16];
+};
+struct TransformBlock {
+	float modelToCamera[16];
+	float modelToClipping[16];
+};
+struct LightSource {
+	float position[3];
+	int32_t type;
+	float direction[3];
+	float constant;
+	float ambient[4];
+	float diffuse[4];
+	float specular[4];
+	float linear, quadratic, exponent, cosCutoff;
+};
+struct LightBlock {
+	int32_t lightCount;
+	int32_t padding[3];
+	LightSource lights[RenderingStatus::MAX_LIGHTS];
+};
+struct MaterialBlock {
+	uint32_t useMaterials;
+	uint32_t padding[3];
+	float ambient[4];
+	float diffuse[4];
+	float specular[4];
+	float emission[4];
+	float shininess;
+	float padding2[3];
+};
+static_assert(sizeof(CameraBlock) == 256 && sizeof(TransformBlock) == 128, "Unexpected std140 matrix block size.");
+static_assert(sizeof(LightSource) == 96 && sizeof(LightBlock) == 16 + 96 * RenderingStatus::MAX_LIGHTS, "Unexpected std140 light block size.");
+static_assert(sizeof(MaterialBlock) == 96, "Unexpected std140 material block size.");
+
+static const std::array<size_t, BLOCK_COUNT> BLOCK_SIZES = {{sizeof(CameraBlock), sizeof(TransformBlock), sizeof(LightBlock), sizeof(MaterialBlock)}};
+
+//! (internal) Offsets of the blocks in the uniform buffer (respecting GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT); the last entry is the buffer size.
+static const std::array<size_t, BLOCK_COUNT + 1> & getBlockOffsets() {
+	static const std::array<size_t, BLOCK_COUNT + 1> offsets = []() {
+		GLint alignment = 256;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		const size_t align = static_cast<size_t>(std::max(alignment, 1));
+		std::array<size_t, BLOCK_COUNT + 1> result;
+		size_t offset = 0;
+		for(uint_fast8_t block = 0; block < BLOCK_COUNT; ++block) {
+			result[block] = offset;
+			offset = (offset + BLOCK_SIZES[block] + align - 1) / align * align;
+		}
+		result[BLOCK_COUNT] = offset;
+		return result;
+	}();
+	return offsets;
+}
+
+//! (internal) std140 matrices are column major.
+static void writeMatrix(float * target, const Geometry::Matrix4x4f & matrix) {
+	const Geometry::Matrix4x4f transposed = matrix.getTransposed();
+	std::copy(transposed.getData(), transposed.getData() + 16, target);
+}
+
+static void writeVec3(float * target, const Geometry::Vec3 & v) {
+	target[0] = v.getX();
+	target[1] = v.getY();
+	target[2] = v.getZ();
+}
+
+static void writeColor(float * target, const Util::Color4f & c) {
+	target[0] = c.getR();
+	target[1] = c.getG();
+	target[2] = c.getB();
+	target[3] = c.getA();
+}
+
+//! (internal) Writes the data of a block as given by @p actual.
+static void writeBlock(uint8_t block, const RenderingStatus & actual, uint8_t * data) {
+	switch(block) {
+		case CAMERA_BLOCK: {
+			auto camera = reinterpret_cast<CameraBlock *>(data);
+			writeMatrix(camera->worldToCamera, actual.getMatrix_worldToCamera());
+			writeMatrix(camera->cameraToWorld, actual.getMatrix_cameraToWorld());
+			writeMatrix(camera->cameraToClipping, actual.getMatrix_cameraToClipping());
+			writeMatrix(camera->clippingToCamera, actual.getMatrix_cameraToClipping().inverse());
+			break;
+		}
+		case TRANSFORM_BLOCK: {
+			auto transform = reinterpret_cast<TransformBlock *>(data);
+			writeMatrix(transform->modelToCamera, actual.getMatrix_modelToCamera());
+			writeMatrix(transform->modelToClipping, actual.getMatrix_cameraToClipping() * actual.getMatrix_modelToCamera());
+			break;
+		}
+		case LIGHT_BLOCK: {
+			auto lights = reinterpret_cast<LightBlock *>(data);
+			std::memset(lights, 0, sizeof(LightBlock));
+			const uint_fast8_t numEnabledLights = actual.getNumEnabledLights();
+			lights->lightCount = static_cast<int32_t>(numEnabledLights);
+			for(uint_fast8_t i = 0; i < numEnabledLights; ++i) {
+				const LightParameters & params = actual.getEnabledLight(i);
+				LightSource & light = lights->lights[i];
+				writeVec3(light.position, actual.getMatrix_worldToCamera().transformPosition(params.position));
+				light.type = static_cast<int32_t>(params.type);
+				writeVec3(light.direction, actual.getMatrix_worldToCamera().transformDirection(params.direction));
+				light.constant = params.constant;
+				writeColor(light.ambient, params.ambient);
+				writeColor(light.diffuse, params.diffuse);
+				writeColor(light.specular, params.specular);
+				light.linear = params.linear;
+				light.quadratic = params.quadratic;
+				light.exponent = params.exponent;
+				light.cosCutoff = params.cosCutoff;
+			}
+			break;
+		}
+		case MATERIAL_BLOCK: {
+			auto material = reinterpret_cast<MaterialBlock *>(data);
+			std::memset(material, 0, sizeof(MaterialBlock));
+			material->useMaterials = actual.isMaterialEnabled() ? 1 : 0;
+			const MaterialParameters & params = actual.getMaterialParameters();
+			writeColor(material->ambient, params.getAmbient());
+			writeColor(material->diffuse, params.getDiffuse());
+			writeColor(material->specular, params.getSpecular());
+			writeColor(material->emission, params.getEmission());
+			material->shininess = params.getShininess();
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+uint8_t initProgram(uint32_t program) {
+	uint8_t blocks = 0;
+	for(uint_fast8_t block = 0; block < BLOCK_COUNT; ++block) {
+		const GLuint index = glGetUniformBlockIndex(program, BLOCK_NAMES[block]);
+		if(index != GL_INVALID_INDEX) {
+			glUniformBlockBinding(program, index, FIRST_BINDING + block);
+			blocks |= static_cast<uint8_t>(1 << block);
+		}
+	}
+	GET_GL_ERROR();
+	return blocks;
+}
+
+void apply(RenderingStatus & target, const RenderingStatus & actual, BufferObject & buffer, bool forced) {
+	const auto & offsets = getBlockOffsets();
+
+	if(!buffer.isValid()) {
+		buffer.allocateData<uint8_t>(BufferObject::TARGET_UNIFORM_BUFFER, offsets[BLOCK_COUNT], BufferObject::USAGE_DYNAMIC_DRAW);
+		forced = true;
+	}
+	if(!target.isInitialized()) {
+		target.markInitialized();
+		forced = true;
+	}
+
+	bool dirty[BLOCK_COUNT] = {false, false, false, false};
+
+	const bool cameraChanged = forced || target.matrixCameraToWorldChanged(actual);
+	const bool projectionChanged = forced || target.matrix_cameraToClipChanged(actual);
+	if(cameraChanged || projectionChanged) {
+		target.updateMatrix_cameraToWorld(actual);
+		target.updateMatrix_cameraToClipping(actual);
+		dirty[CAMERA_BLOCK] = true;
+	}
+	if(projectionChanged || target.matrix_modelToCameraChanged(actual)) {
+		target.updateModelViewMatrix(actual);
+		dirty[TRANSFORM_BLOCK] = true;
+	}
+	// the light positions are stored in camera space
+	if(cameraChanged || target.lightsChanged(actual)) {
+		target.updateLights(actual);
+		for(uint_fast8_t i = 0; i < actual.getNumEnabledLights(); ++i)
+			target.updateLightParameter(i, actual.getEnabledLight(i));
+		dirty[LIGHT_BLOCK] = true;
+	}
+	if(forced || target.materialChanged(actual)) {
+		target.updateMaterial(actual);
+		dirty[MATERIAL_BLOCK] = true;
+	}
+
+	// upload the range from the first to the last changed block at once
+	int_fast8_t first = -1, last = -1;
+	for(int_fast8_t block = 0; block < BLOCK_COUNT; ++block) {
+		if(dirty[block]) {
+			if(first < 0)
+				first = block;
+			last = block;
+		}
+	}
+	if(first >= 0) {
+		std::array<uint8_t, 2048> localData;
+		std::vector<uint8_t> heapData;
+		const size_t size = offsets[last] + BLOCK_SIZES[last] - offsets[first];
+		uint8_t * data = localData.data();
+		if(size > localData.size()) {
+			heapData.resize(size);
+			data = heapData.data();
+		}
+		for(auto block = first; block <= last; ++block)
+			writeBlock(static_cast<uint8_t>(block), actual, data + offsets[block] - offsets[first]);
+		buffer.uploadSubData(BufferObject::TARGET_UNIFORM_BUFFER, data, size, offsets[first]);
+	}
+
+	if(forced) {
+		for(uint_fast8_t block = 0; block < BLOCK_COUNT; ++block)
+			glBindBufferRange(GL_UNIFORM_BUFFER, FIRST_BINDING + block, buffer.getGLId(), static_cast<GLintptr>(offsets[block]), static_cast<GLsizeiptr>(BLOCK_SIZES[block]));
+		GET_GL_ERROR();
+	}
+}
+
+void unbind() {
+	for(uint_fast8_t block = 0; block < BLOCK_COUNT; ++block)
+		glBindBufferBase(GL_UNIFORM_BUFFER, FIRST_BINDING + block, 0);
+	GET_GL_ERROR();
+}
+
+}
+}
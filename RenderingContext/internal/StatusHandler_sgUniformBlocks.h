@@ -0,0 +1,88 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_STATHANDLER_SGUNIBLOCKS_H_
+#define RENDERING_STATHANDLER_SGUNIBLOCKS_H_
+
+#include <cstdint>
+
+namespace Rendering {
+
+class BufferObject;
+class RenderingStatus;
+
+/*! @internal
+	std140 uniform blocks for the built-in sg_ uniforms (see RenderingContext::setSGUniformBlocksEnabled()).
+	All blocks are stored in a single buffer and bound once to the binding points FIRST_BINDING + block id.
+	A shader uses a block by declaring it with the following layout; the members of a declared block are
+	not set as loose uniforms anymore.
+
+	\code
+	layout(std140) uniform sg_CameraBlock {		// binding FIRST_BINDING + 0
+		mat4 sg_matrix_worldToCamera;
+		mat4 sg_matrix_cameraToWorld;
+		mat4 sg_matrix_cameraToClipping;
+		mat4 sg_matrix_clippingToCamera;
+	};
+	layout(std140) uniform sg_TransformBlock {	// binding FIRST_BINDING + 1
+		mat4 sg_matrix_modelToCamera;
+		mat4 sg_matrix_modelToClipping;
+	};
+	struct sg_LightSourceParameters {
+		vec3 position;		// in camera space
+		int type;
+		vec3 direction;		// in camera space
+		float constant;
+		vec4 ambient, diffuse, specular;
+		float linear, quadratic, exponent, cosCutoff;
+	};
+	layout(std140) uniform sg_LightBlock {		// binding FIRST_BINDING + 2
+		int sg_lightCount;
+		sg_LightSourceParameters sg_LightSource[8];
+	};
+	struct sg_MaterialParameters {
+		vec4 ambient, diffuse, specular, emission;
+		float shininess;
+	};
+	layout(std140) uniform sg_MaterialBlock {	// binding FIRST_BINDING + 3
+		bool sg_useMaterials;
+		sg_MaterialParameters sg_Material;
+	};
+	\endcode
+	sg_pointSize, sg_texture* and sg_textureEnabled are always set as loose uniforms.
+*/
+namespace StatusHandler_sgUniformBlocks {
+
+enum block_t : uint8_t {
+	CAMERA_BLOCK = 0,
+	TRANSFORM_BLOCK = 1,
+	LIGHT_BLOCK = 2,
+	MATERIAL_BLOCK = 3,
+	BLOCK_COUNT = 4
+};
+
+//! Binding point of the first block; the binding points FIRST_BINDING to FIRST_BINDING + BLOCK_COUNT - 1 are reserved.
+static constexpr uint32_t FIRST_BINDING = 10;
+
+//! Names of the blocks in the shader code (indexed by block_t).
+extern const char * const BLOCK_NAMES[BLOCK_COUNT];
+
+/*! Returns a bit mask (bit i = block_t i) of the blocks declared by the given linked program and
+	assigns their binding points. */
+uint8_t initProgram(uint32_t program);
+
+/*! Writes the changed parts of @p actual into the uniform buffer (one buffer update for all changed blocks)
+	and updates @p target accordingly. The buffer is created and bound on the first call or if @p forced is set. */
+void apply(RenderingStatus & target, const RenderingStatus & actual, BufferObject & buffer, bool forced);
+
+//! Unbinds the buffer from the reserved binding points.
+void unbind();
+
+}
+}
+#endif /* RENDERING_STATHANDLER_SGUNIBLOCKS_H_ */
@@ -9,6 +9,7 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "StatusHandler_sgUniforms.h"
+#include "StatusHandler_sgUniformBlocks.h"
 #include "RenderingStatus.h"
 #include "../../Shader/Shader.h"
 #include "../../Shader/UniformRegistry.h"
@@ -63,7 +64,15 @@ static const Uniform::UniformName UNIFORM_SG_MATERIAL_SPECULAR("sg_Material.spec
 static const Uniform::UniformName UNIFORM_SG_MATERIAL_EMISSION("sg_Material.emission");
 static const Uniform::UniformName UNIFORM_SG_MATERIAL_SHININESS("sg_Material.shininess");
 
-void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced){
+void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced, uint8_t uniformBlocks){
+	using namespace StatusHandler_sgUniformBlocks;
+	const bool cameraBlock = (uniformBlocks & (1 << CAMERA_BLOCK)) != 0;
+	const bool transformBlock = (uniformBlocks & (1 << TRANSFORM_BLOCK)) != 0;
+	// the status has been updated while uniforms were skipped; set all uniforms if the used blocks change
+	if(target.getSGUniformBlocks() != uniformBlocks) {
+		target.setSGUniformBlocks(uniformBlocks);
+		forced = true;
+	}
 
 	Shader * shader = target.getShader();
 	std::deque<Uniform> uniforms;
@@ -74,15 +83,17 @@ void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced
 		cc = true;
 		target.updateMatrix_cameraToWorld(actual);
 
-		uniforms.emplace_back(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA, actual.getMatrix_worldToCamera());
-		uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD, actual.getMatrix_cameraToWorld());
+		if(!cameraBlock) {
+			uniforms.emplace_back(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA, actual.getMatrix_worldToCamera());
+			uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD, actual.getMatrix_cameraToWorld());
 
-		uniforms.emplace_back(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA_OLD, actual.getMatrix_worldToCamera());
-		uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD_OLD, actual.getMatrix_cameraToWorld());
+			uniforms.emplace_back(UNIFORM_SG_MATRIX_WORLD_TO_CAMERA_OLD, actual.getMatrix_worldToCamera());
+			uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_WORLD_OLD, actual.getMatrix_cameraToWorld());
+		}
 	}
 
 	// lights
-	if (forced || cc || target.lightsChanged(actual)) {
+	if ((uniformBlocks & (1 << LIGHT_BLOCK)) == 0 && (forced || cc || target.lightsChanged(actual))) {
 
 		target.updateLights(actual);
 
@@ -128,7 +139,7 @@ void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced
 	}
 
 	// materials
-	if (forced || target.materialChanged(actual)) {
+	if ((uniformBlocks & (1 << MATERIAL_BLOCK)) == 0 && (forced || target.materialChanged(actual))) {
 		target.updateMaterial(actual);
 
 		uniforms.emplace_back(UNIFORM_SG_USE_MATERIALS, actual.isMaterialEnabled());
@@ -150,18 +161,22 @@ void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced
 		if (forced || target.matrix_modelToCameraChanged(actual)) {
 			mc = true;
 			target.updateModelViewMatrix(actual);
-			uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CAMERA, actual.getMatrix_modelToCamera());
-			uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CAMERA_OLD, actual.getMatrix_modelToCamera());
+			if(!transformBlock) {
+				uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CAMERA, actual.getMatrix_modelToCamera());
+				uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CAMERA_OLD, actual.getMatrix_modelToCamera());
+			}
 		}
 
 		if (forced || target.matrix_cameraToClipChanged(actual)) {
 			pc = true;
 			target.updateMatrix_cameraToClipping(actual);
-			uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING, actual.getMatrix_cameraToClipping());
-			uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING_OLD, actual.getMatrix_cameraToClipping());
-			uniforms.emplace_back(UNIFORM_SG_MATRIX_CLIPPING_TO_CAMERA, actual.getMatrix_cameraToClipping().inverse());
+			if(!cameraBlock) {
+				uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING, actual.getMatrix_cameraToClipping());
+				uniforms.emplace_back(UNIFORM_SG_MATRIX_CAMERA_TO_CLIPPING_OLD, actual.getMatrix_cameraToClipping());
+				uniforms.emplace_back(UNIFORM_SG_MATRIX_CLIPPING_TO_CAMERA, actual.getMatrix_cameraToClipping().inverse());
+			}
 		}
-		if (forced || pc || mc) {
+		if (!transformBlock && (forced || pc || mc)) {
 			const auto m = actual.getMatrix_cameraToClipping() * actual.getMatrix_modelToCamera();
 			uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CLIPPING, m);
 			uniforms.emplace_back(UNIFORM_SG_MATRIX_MODEL_TO_CLIPPING_OLD, m);
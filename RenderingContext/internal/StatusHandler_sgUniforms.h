@@ -10,6 +10,9 @@
 */
 #ifndef RENDERING_STATHANDLER_SGUNI_H_
 #define RENDERING_STATHANDLER_SGUNI_H_
+
+#include <cstdint>
+
 namespace Rendering {
 
 class RenderingStatus;
@@ -17,7 +20,10 @@ class RenderingStatus;
 //! @internal
 namespace StatusHandler_sgUniforms{
 
-void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced);
+/*! Sets the changed sg_ uniforms on the shader of @p target.
+	Uniforms covered by one of the sg_ uniform blocks in @p uniformBlocks (bit mask of
+	StatusHandler_sgUniformBlocks::block_t) are skipped. */
+void apply(RenderingStatus & target, const RenderingStatus & actual, bool forced, uint8_t uniformBlocks = 0);
 
 }
 }
@@ -0,0 +1,301 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ProgramBinaryCache.h"
+#include "ShaderObjectInfo.h"
+#include "../GLHeader.h"
+#include "../Helper.h"
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/Macros.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <list>
+#include <sstream>
+
+namespace Rendering {
+
+//! File header of a cached binary
+struct BinaryHeader {
+	static constexpr uint32_t MAGIC = 0x42504753; // "SGPB"
+	uint32_t magic;
+	uint32_t binaryFormat;
+};
+
+static const std::string fileEnding("bin");
+
+//! A cached binary file and its size
+struct CacheEntry {
+	std::string key;
+	uint64_t size;
+};
+
+struct CacheState {
+	bool enabled = false;
+	std::string directory;
+	uint64_t maxSize = ProgramBinaryCache::DEFAULT_MAX_SIZE;
+	ProgramBinaryCache::Statistics statistics;
+	std::list<CacheEntry> entries; //!< oldest first
+	uint64_t totalSize = 0; //!< sum of the sizes of the entries
+};
+
+static CacheState & getState() {
+	static CacheState state;
+	return state;
+}
+
+static Util::FileName getCacheFile(const std::string & key) {
+	return Util::FileName(getState().directory + key + '.' + fileEnding);
+}
+
+//! FNV-1a (64 bit)
+static void hashData(uint64_t & hash, const void * data, size_t size) {
+	const auto bytes = reinterpret_cast<const uint8_t *>(data);
+	for(size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+}
+
+static void hashString(uint64_t & hash, const std::string & str) {
+	const uint64_t length = str.length();
+	hashData(hash, &length, sizeof(length));
+	hashData(hash, str.data(), str.length());
+}
+
+//! Remove the entry of @p key (if any) from the bookkeeping.
+static void removeEntry(CacheState & state, const std::string & key) {
+	for(auto it = state.entries.begin(); it != state.entries.end(); ++it) {
+		if(it->key == key) {
+			state.totalSize -= it->size;
+			state.entries.erase(it);
+			return;
+		}
+	}
+}
+
+static std::string getGLString(uint32_t name) {
+	const auto str = reinterpret_cast<const char *>(glGetString(name));
+	return str == nullptr ? std::string() : std::string(str);
+}
+
+//! (static)
+bool ProgramBinaryCache::isSupported() {
+	#if defined(LIB_GL) && defined(GL_ARB_get_program_binary)
+		static const bool support = [] {
+			if(!isExtensionSupported("GL_ARB_get_program_binary"))
+				return false;
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+			return numFormats > 0;
+		}();
+		return support;
+	#else
+		return false;
+	#endif
+}
+
+//! (static)
+bool ProgramBinaryCache::enable(const std::string & directory, uint64_t maxSize) {
+	if(!isSupported()) {
+		WARN("ProgramBinaryCache: Program binaries are not supported.");
+		return false;
+	}
+	std::string dir = directory;
+	if(!dir.empty() && dir.back() != '/')
+		dir += '/';
+	const Util::FileName dirName(dir);
+	if(!Util::FileUtils::isDir(dirName) && !Util::FileUtils::createDir(dirName, true)) {
+		WARN("ProgramBinaryCache: Could not create directory '" + dir + "'.");
+		return false;
+	}
+	auto & state = getState();
+	state.enabled = true;
+	state.directory = dir;
+	state.maxSize = maxSize;
+
+	/* The binaries already in the directory are only listed once. The file system gives no access to their age,
+	   so they are considered older than all binaries stored from now on (in listing order). */
+	state.entries.clear();
+	state.totalSize = 0;
+	std::list<Util::FileName> files;
+	Util::FileUtils::getFiles(dirName, files, Util::FileUtils::DIR_FILES);
+	for(const auto & file : files) {
+		if(file.getEnding() != fileEnding)
+			continue;
+		const std::string name = file.getFile();
+		const uint64_t size = Util::FileUtils::fileSize(file);
+		state.entries.push_back({name.substr(0, name.length() - fileEnding.length() - 1), size});
+		state.totalSize += size;
+	}
+	return true;
+}
+
+//! (static)
+void ProgramBinaryCache::disable() {
+	getState().enabled = false;
+}
+
+//! (static)
+bool ProgramBinaryCache::isEnabled() {
+	return getState().enabled;
+}
+
+//! (static)
+void ProgramBinaryCache::clear() {
+	auto & state = getState();
+	state.entries.clear();
+	state.totalSize = 0;
+	if(state.directory.empty())
+		return;
+	std::list<Util::FileName> files;
+	Util::FileUtils::getFiles(Util::FileName(state.directory), files, Util::FileUtils::DIR_FILES);
+	for(const auto & file : files) {
+		if(file.getEnding() == fileEnding)
+			Util::FileUtils::remove(file);
+	}
+}
+
+//! (static)
+const ProgramBinaryCache::Statistics & ProgramBinaryCache::getStatistics() {
+	return getState().statistics;
+}
+
+//! (static)
+void ProgramBinaryCache::resetStatistics() {
+	getState().statistics = Statistics();
+}
+
+//! (static, internal)
+std::string ProgramBinaryCache::createKey(const std::vector<ShaderObjectInfo> & shaderObjects,
+										const std::vector<std::string> & feedbackVaryings, uint32_t feedbackVaryingType,
+										std::vector<std::string> & processedCode) {
+	processedCode.clear();
+	if(!isEnabled())
+		return "";
+	uint64_t hash = 0xcbf29ce484222325ull;
+	// binaries are only compatible with the driver that created them
+	hashString(hash, getGLString(GL_VENDOR));
+	hashString(hash, getGLString(GL_RENDERER));
+	hashString(hash, getGLString(GL_VERSION));
+
+	processedCode.reserve(shaderObjects.size());
+	for(const auto & shaderObject : shaderObjects) {
+		processedCode.emplace_back(shaderObject.getProcessedCode());
+		if(processedCode.back().empty()) { // the error is reported when compiling the sources
+			processedCode.clear();
+			return "";
+		}
+		const uint32_t type = shaderObject.getType();
+		hashData(hash, &type, sizeof(type));
+		hashString(hash, processedCode.back());
+	}
+	for(const auto & varying : feedbackVaryings)
+		hashString(hash, varying);
+	hashData(hash, &feedbackVaryingType, sizeof(feedbackVaryingType));
+
+	std::ostringstream key;
+	key << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return key.str();
+}
+
+//! (static, internal)
+uint32_t ProgramBinaryCache::loadProgram(const std::string & key) {
+	auto & state = getState();
+	#if defined(LIB_GL) && defined(GL_ARB_get_program_binary)
+	const Util::FileName file = getCacheFile(key);
+	if(!key.empty() && Util::FileUtils::isFile(file)) {
+		const std::vector<uint8_t> data = Util::FileUtils::loadFile(file);
+		BinaryHeader header;
+		if(data.size() > sizeof(header)) {
+			std::memcpy(&header, data.data(), sizeof(header));
+			if(header.magic == BinaryHeader::MAGIC) {
+				GET_GL_ERROR();
+				GLuint prog = glCreateProgram();
+				glProgramBinary(prog, header.binaryFormat, data.data() + sizeof(header), static_cast<GLsizei>(data.size() - sizeof(header)));
+				// a format that is not supported anymore (e.g. after a driver update) raises GL_INVALID_ENUM;
+				// this is expected, so the error is discarded and only the link status is checked
+				for(uint_fast8_t i = 0; i < 4; ++i) {
+					const GLenum error = glGetError();
+					if(error == GL_NO_ERROR)
+						break;
+					if(error != GL_INVALID_ENUM) {
+						std::ostringstream message;
+						message << "ProgramBinaryCache: GL error 0x" << std::hex << error << " while loading a binary.";
+						WARN(message.str());
+					}
+				}
+				GLint linkStatus = GL_FALSE;
+				glGetProgramiv(prog, GL_LINK_STATUS, &linkStatus);
+				if(linkStatus == GL_TRUE) {
+					++state.statistics.hits;
+					return prog;
+				}
+				glDeleteProgram(prog);
+			}
+		}
+		// outdated or corrupt binary
+		Util::FileUtils::remove(file);
+		removeEntry(state, key);
+	}
+	#endif
+	++state.statistics.misses;
+	return 0;
+}
+
+//! (static, internal)
+void ProgramBinaryCache::storeProgram(const std::string & key, uint32_t prog) {
+	#if defined(LIB_GL) && defined(GL_ARB_get_program_binary)
+	auto & state = getState();
+	if(key.empty() || !state.enabled)
+		return;
+	GLint length = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+
+	BinaryHeader header;
+	header.magic = BinaryHeader::MAGIC;
+	std::vector<uint8_t> data(sizeof(header) + static_cast<size_t>(length));
+	GLsizei writtenLength = 0;
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(prog, length, &writtenLength, &binaryFormat, data.data() + sizeof(header));
+	GET_GL_ERROR();
+	if(writtenLength <= 0)
+		return;
+	header.binaryFormat = binaryFormat;
+	std::memcpy(data.data(), &header, sizeof(header));
+	data.resize(sizeof(header) + static_cast<size_t>(writtenLength));
+
+	const Util::FileName file = getCacheFile(key);
+	if(!Util::FileUtils::saveFile(file, data, true)) {
+		WARN("ProgramBinaryCache: Could not write '" + file.toString() + "'.");
+		return;
+	}
+	++state.statistics.stored;
+	removeEntry(state, key);
+	state.entries.push_back({key, data.size()});
+	state.totalSize += data.size();
+
+	// enforce the size limit by removing the oldest binaries (but never the new one)
+	while(state.totalSize > state.maxSize && state.entries.size() > 1) {
+		const CacheEntry oldest = state.entries.front();
+		state.entries.pop_front();
+		state.totalSize -= oldest.size;
+		Util::FileUtils::remove(getCacheFile(oldest.key));
+		++state.statistics.evicted;
+	}
+	#else
+	(void)key;
+	(void)prog;
+	#endif
+}
+
+}
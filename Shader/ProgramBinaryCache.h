@@ -0,0 +1,77 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_PROGRAMBINARYCACHE_H_
+#define RENDERING_PROGRAMBINARYCACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+class ShaderObjectInfo;
+
+/**
+ * Persistent on-disk cache of linked shader programs (GL_ARB_get_program_binary).
+ *
+ * If the cache is enabled, Shader::init() first tries to load the program binary from the cache directory and
+ * only compiles and links the sources if no (valid) binary is found; a newly linked program is then stored in the
+ * cache. The key of a program is a hash of the processed sources (including resolved includes and defines) of all
+ * shader objects, the transform feedback varyings and the GL vendor, renderer and version strings. Binaries
+ * rejected by the driver (e.g. after a driver update) are removed and the program is compiled from source.
+ *
+ * If the total size of the cached binaries exceeds the size limit after storing a binary, the oldest other
+ * binaries are removed until the limit is met again. The sizes are tracked in memory; the directory is only
+ * listed when the cache is enabled.
+ * @ingroup shader
+ */
+class ProgramBinaryCache {
+	public:
+		struct Statistics {
+			uint32_t hits = 0;		//!< programs loaded from the cache
+			uint32_t misses = 0;	//!< programs not found in the cache or rejected by the driver
+			uint32_t stored = 0;	//!< programs written to the cache
+			uint32_t evicted = 0;	//!< binaries removed because of the size limit
+		};
+
+		static constexpr uint64_t DEFAULT_MAX_SIZE = 256 * 1024 * 1024;
+
+		//! Returns true if program binaries can be retrieved and loaded (GL_ARB_get_program_binary).
+		RENDERINGAPI static bool isSupported();
+
+		/*! Enable the cache using @p directory (which is created if necessary) for the binaries.
+			@param maxSize Maximum total size of the cached binaries in bytes.
+			@return false if program binaries are not supported or the directory could not be created. */
+		RENDERINGAPI static bool enable(const std::string & directory, uint64_t maxSize = DEFAULT_MAX_SIZE);
+		RENDERINGAPI static void disable();
+		RENDERINGAPI static bool isEnabled();
+
+		//! Remove all cached binaries from the cache directory.
+		RENDERINGAPI static void clear();
+
+		RENDERINGAPI static const Statistics & getStatistics();
+		RENDERINGAPI static void resetStatistics();
+
+		/*! (internal) Create the key for the given program description.
+			@param processedCode Set to the processed code of each shader object (see ShaderObjectInfo::getProcessedCode()),
+				which can be used to compile the program on a cache miss.
+			Returns an empty string (and leaves @p processedCode empty) if the cache is disabled or the sources could not be processed. */
+		static std::string createKey(const std::vector<ShaderObjectInfo> & shaderObjects,
+									const std::vector<std::string> & feedbackVaryings, uint32_t feedbackVaryingType,
+									std::vector<std::string> & processedCode);
+
+		//! (internal) Create a linked program from the cached binary; returns 0 if there is no valid binary.
+		static uint32_t loadProgram(const std::string & key);
+
+		//! (internal) Store the binary of the linked program @p prog.
+		static void storeProgram(const std::string & key, uint32_t prog);
+};
+
+}
+
+#endif /* RENDERING_PROGRAMBINARYCACHE_H_ */
@@ -9,9 +9,11 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "Shader.h"
+#include "ProgramBinaryCache.h"
 #include "Uniform.h"
 #include "UniformRegistry.h"
 #include "../RenderingContext/internal/RenderingStatus.h"
+#include "../RenderingContext/internal/StatusHandler_sgUniformBlocks.h"
 #include "../RenderingContext/RenderingContext.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
@@ -95,7 +97,7 @@ Shader * Shader::createShader(const std::string & vsa, const std::string & gsa,
 
 /*!	[ctor]	*/
 Shader::Shader(flag_t _usage) :
-		usageFlags(_usage), renderingData(), prog(0), status(UNKNOWN), uniforms(new UniformRegistry),glFeedbackVaryingType(0){
+		usageFlags(_usage), renderingData(), sgUniformBlocks(0), prog(0), status(UNKNOWN), uniforms(new UniformRegistry),glFeedbackVaryingType(0){
 }
 
 /*!	[dtor]	*/
@@ -104,16 +106,33 @@ Shader::~Shader() {
 }
 
 bool Shader::init() {
+	std::string cacheKey;
+	bool loadedFromCache = false;
 	while(status!=LINKED){
 		if(status == UNKNOWN){
-			status = compileProgram() ? COMPILED : INVALID;
+			std::vector<std::string> processedCode;
+			cacheKey = ProgramBinaryCache::createKey(shaderObjects, feedbackVaryings, glFeedbackVaryingType, processedCode);
+			const uint32_t cachedProg = cacheKey.empty() ? 0 : ProgramBinaryCache::loadProgram(cacheKey);
+			if(cachedProg != 0){
+				glDeleteProgram(prog);
+				prog = cachedProg;
+				loadedFromCache = true; // the program is already linked
+				status = COMPILED;
+			}else{
+				status = compileProgram(processedCode) ? COMPILED : INVALID;
+			}
 		}else if(status == COMPILED){
-			if( linkProgram() ){
+			if( loadedFromCache || linkProgram() ){
+				if(!loadedFromCache && !cacheKey.empty())
+					ProgramBinaryCache::storeProgram(cacheKey, prog);
 				status = LINKED;
 
 				// recreate renderingData
 				renderingData.reset(new RenderingStatus(this));
 
+				// bind the declared sg_ uniform blocks
+				sgUniformBlocks = StatusHandler_sgUniformBlocks::initProgram(prog);
+
 				// make sure all set uniforms are re-applied.
 				uniforms->resetCounters();
 
@@ -131,11 +150,12 @@ bool Shader::init() {
 }
 
 /*!	(internal) */
-bool Shader::compileProgram() {
+bool Shader::compileProgram(const std::vector<std::string> & processedCode) {
 	prog = glCreateProgram();
 
-	for(const auto & shaderObject : shaderObjects) {
-		GLuint handle = shaderObject.compile();
+	for(size_t i = 0; i < shaderObjects.size(); ++i) {
+		const auto & shaderObject = shaderObjects[i];
+		GLuint handle = processedCode.empty() ? shaderObject.compile() : shaderObject.compile(processedCode[i]);
 		if(handle == 0) {
 			GET_GL_ERROR();
 			return false;
@@ -164,6 +184,11 @@ bool Shader::linkProgram() {
 	#endif // GL_EXT_transform_feedback
 
 	
+	#if defined(LIB_GL) && defined(GL_ARB_get_program_binary)
+	if(ProgramBinaryCache::isEnabled())
+		glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	#endif
+
 	glLinkProgram(prog);
 	GET_GL_ERROR();
 
@@ -211,25 +236,30 @@ void Shader::applyUniforms(bool forced){
 	if( getStatus()!=LINKED && !init())
 		return;
 
-	// apply the uniforms that have been changed since the last call (or all, if forced)
-	for(auto it=uniforms->orderedList.begin();
-			it!=uniforms->orderedList.end() && ( (*it)->stepOfLastSet > uniforms->stepOfLastApply || forced ); ++it ){
-		UniformRegistry::entry_t * entry(*it);
-
+	const auto applyEntry = [this](UniformRegistry::entry_t & entry){
 		// new uniform? --> query and store the location
-		if( entry->location==-1 ){
-			entry->location = glGetUniformLocation( getShaderProg(), entry->uniform.getName().c_str());
-			if(entry->location==-1){
-				entry->valid = false;
-				if(entry->warnIfUnused)
-					WARN(std::string("No uniform named: ") + entry->uniform.getName());
-				continue;
+		if( entry.location==-1 ){
+			entry.location = glGetUniformLocation( getShaderProg(), entry.uniform.getName().c_str());
+			if(entry.location==-1){
+				entry.valid = false;
+				if(entry.warnIfUnused)
+					WARN(std::string("No uniform named: ") + entry.uniform.getName());
+				return;
 			}
 		}
 		// set the data
-		applyUniform(entry->uniform,entry->location);
+		applyUniform(entry.uniform,entry.location);
+	};
+
+	// apply the uniforms that have been changed since the last call (or all, if forced)
+	if(forced){
+		for(auto & entry : uniforms->entries)
+			applyEntry(entry);
+	}else{
+		for(const auto index : uniforms->dirtyEntries)
+			applyEntry(uniforms->entries[index]);
 	}
-	uniforms->stepOfLastApply = UniformRegistry::getNewGlobalStep();
+	uniforms->clearDirtyEntries();
 }
 
 //! (internal)
@@ -311,7 +341,7 @@ void Shader::initUniformRegistry(){
 	}
 
 	// as the uniforms are initialized with their original values, we don't need to re-apply them
-	uniforms->stepOfLastApply = UniformRegistry::getNewGlobalStep();
+	uniforms->clearDirtyEntries();
 }
 
 bool Shader::isUniform(const Util::StringIdentifier name) {
@@ -502,6 +532,19 @@ void Shader::setUniform(RenderingContext & rc,const Uniform & uniform, bool warn
 	rc._setUniformOnShader(this,uniform,warnIfUnused,forced);
 }
 
+//! (static)
+uint32_t Shader::getUniformHandle(const Util::StringIdentifier name){
+	return UniformRegistry::getHandle(name);
+}
+
+void Shader::setUniform(RenderingContext & rc,uint32_t uniformHandle,const Uniform & uniform, bool warnIfUnused, bool forced){
+	if(!init()){
+		WARN("setUniform: Shader not ready.");
+		return;
+	}
+	rc._setUniformOnShader(this,uniformHandle,uniform,warnIfUnused,forced);
+}
+
 // --------------------------------
 // vertexAttributes
 
@@ -65,9 +65,13 @@ class Shader : public Util::ReferenceCounter<Shader> {
 
 		RenderingStatus * getRenderingStatus()	{	return renderingData.get();	}
 
+		//! Bit mask of the sg_ uniform blocks declared by the shader (see RenderingContext::setSGUniformBlocksEnabled()); set when the shader is linked.
+		uint8_t getSGUniformBlocks()const	{	return sgUniformBlocks;	}
+
 	private:
 		flag_t usageFlags;
 		std::unique_ptr<RenderingStatus> renderingData; // created when the shader is successfully initialized
+		uint8_t sgUniformBlocks;
 
 		RENDERINGAPI Shader(flag_t usage = USE_GL|USE_UNIFORMS);
 		RENDERINGAPI static void printProgramInfoLog(uint32_t obj);
@@ -107,9 +111,11 @@ class Shader : public Util::ReferenceCounter<Shader> {
 		status_t status;
 
 		/*! (internal) Compile all objects and create the shader program.
+			@param processedCode Processed code of each object (see ShaderObjectInfo::getProcessedCode()),
+				or empty if the code should be processed while compiling.
 			If everything works fine, status is set to COMPILED and true is returned.
 			Otherwise, status is set to INVALID and false is returned.	*/
-		RENDERINGAPI bool compileProgram();
+		RENDERINGAPI bool compileProgram(const std::vector<std::string> & processedCode);
 
 		/*! (internal) Link the program (which must already exist).
 			If everything works fine, status is set to LINKED and true is returned.
@@ -170,6 +176,13 @@ class Shader : public Util::ReferenceCounter<Shader> {
 			\note The uniform is stored at the Shader's internal uniformRegistry.
 			\note The Shader needs not to be active.*/
 		RENDERINGAPI void setUniform(RenderingContext & rc,const Uniform & uniform, bool warnIfUnused=true, bool forced=false);
+
+		/*! Returns the handle of a uniform name. The handle is valid for all shaders and can be used to set
+			uniforms without looking up their names. */
+		RENDERINGAPI static uint32_t getUniformHandle(const Util::StringIdentifier name);
+
+		//! Like setUniform(rc, uniform, ...), but @p uniformHandle (see getUniformHandle()) is used instead of the uniform's name.
+		RENDERINGAPI void setUniform(RenderingContext & rc,uint32_t uniformHandle,const Uniform & uniform, bool warnIfUnused=true, bool forced=false);
 	// @}
 
 	// ------------------------
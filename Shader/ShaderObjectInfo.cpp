@@ -98,14 +98,13 @@ static bool resolveIncludes(std::string & code, const Util::FileName & f) {
 	return true;
 }
 
-uint32_t ShaderObjectInfo::compile() const {
-	GLuint handle = glCreateShader(getType());
+std::string ShaderObjectInfo::getProcessedCode() const {
 	// This postfix assures that the file not be empty even if everything is cut out due to an ifdef-commando.
 	// Files without content do not compile with AMD cards.
 	std::string strCode = getCode() + "\nvoid _();\n";
 	std::string header;
 	if(!resolveIncludes(strCode, filename))
-		return 0;
+		return "";
 
 	// prepend a "#define SG_shaderType" or insert it after the initial "#version..." line.
 	if(getType() == GL_FRAGMENT_SHADER) {
@@ -133,6 +132,17 @@ uint32_t ShaderObjectInfo::compile() const {
 		strCode = header + strCode;
 	}
 
+	return strCode;
+}
+
+uint32_t ShaderObjectInfo::compile() const {
+	return compile(getProcessedCode());
+}
+
+uint32_t ShaderObjectInfo::compile(const std::string & strCode) const {
+	if(strCode.empty())
+		return 0;
+	GLuint handle = glCreateShader(getType());
 	const char * str = strCode.c_str();
 	glShaderSource(handle, 1, &str, nullptr);
 	glCompileShader(handle);
@@ -62,6 +62,14 @@ class ShaderObjectInfo {
 			return *this;
 		}
 
+		/**
+		 * Returns the code as it is passed to GL: includes are resolved and the defines
+		 * (and the "#define SG_..." of the shader type) are inserted.
+		 *
+		 * @return The processed code, or an empty string if an include could not be resolved
+		 */
+		RENDERINGAPI std::string getProcessedCode() const;
+
 		/**
 		 * Use GL to compile the source stored in this shader object.
 		 * 
@@ -70,6 +78,9 @@ class ShaderObjectInfo {
 		 */
 		RENDERINGAPI uint32_t compile() const;
 
+		//! Like compile(), but uses the given result of getProcessedCode().
+		RENDERINGAPI uint32_t compile(const std::string & processedCode) const;
+
 		/**
 		 * Create a VertexShaderObject from the given code
 		 * 
@@ -344,6 +344,8 @@ Uniform::Uniform(UniformName _name, const std::vector<Geometry::Matrix4x4> & val
 	}
 }
 
+// ---------------------------------------------------------------
+
 std::string Uniform::toString() const {
 	std::stringstream s;
 	s << "Uniform: '" << getName() << "' ";
@@ -14,6 +14,7 @@
 #include <Util/StringIdentifier.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <string>
 #include <vector>
@@ -163,17 +164,91 @@ class Uniform {
 
 		uint32_t getNumValues() const 				{	return numValues;	}
 		bool operator==(const Uniform & other) const{
-			return (isNull() && other.isNull()) ||
-				(other.name == name && other.numValues == numValues && other.type == type && other.data==data);
+			if(isNull() || other.isNull())
+				return isNull() && other.isNull();
+			if(!(other.name == name && other.numValues == numValues && other.type == type))
+				return false;
+			return other.data == data;
 		}
 
 		bool isNull()const							{	return name == Util::StringIdentifier();	}
 
 	private:
+		/*! Byte storage of the uniform values. Up to INLINE_SIZE bytes (all scalars, vectors and matrices)
+			are stored inside the object; only larger arrays are allocated on the heap. */
+		class DataStorage {
+			public:
+				static constexpr size_t INLINE_SIZE = 64;
+
+				DataStorage() : numBytes(0), heapData(nullptr) {}
+				//! Zero initialized data
+				explicit DataStorage(size_t size) : numBytes(0), heapData(nullptr) {
+					allocate(size);
+					std::memset(data(), 0, numBytes);
+				}
+				DataStorage(const uint8_t * begin, const uint8_t * end) : numBytes(0), heapData(nullptr) {
+					allocate(static_cast<size_t>(end - begin));
+					if(numBytes > 0)
+						std::memcpy(data(), begin, numBytes);
+				}
+				DataStorage(const std::vector<uint8_t> & values) : DataStorage(values.data(), values.data() + values.size()) {}
+				DataStorage(const DataStorage & other) : DataStorage(other.data(), other.data() + other.numBytes) {}
+				DataStorage(DataStorage && other) noexcept : numBytes(other.numBytes), heapData(other.heapData) {
+					if(!heapData)
+						std::memcpy(inlineData, other.inlineData, numBytes);
+					other.numBytes = 0;
+					other.heapData = nullptr;
+				}
+				~DataStorage() {
+					delete [] heapData;
+				}
+				DataStorage & operator=(const DataStorage & other) {
+					if(this != &other) {
+						if(numBytes != other.numBytes) {
+							delete [] heapData;
+							allocate(other.numBytes);
+						}
+						if(numBytes > 0)
+							std::memcpy(data(), other.data(), numBytes);
+					}
+					return *this;
+				}
+				DataStorage & operator=(DataStorage && other) noexcept {
+					if(this != &other) {
+						delete [] heapData;
+						numBytes = other.numBytes;
+						heapData = other.heapData;
+						if(!heapData)
+							std::memcpy(inlineData, other.inlineData, numBytes);
+						other.numBytes = 0;
+						other.heapData = nullptr;
+					}
+					return *this;
+				}
+				bool operator==(const DataStorage & other) const {
+					return numBytes == other.numBytes && std::memcmp(data(), other.data(), numBytes) == 0;
+				}
+
+				uint8_t * data()				{	return heapData ? heapData : inlineData;	}
+				const uint8_t * data() const	{	return heapData ? heapData : inlineData;	}
+				size_t size() const				{	return numBytes;	}
+				bool isInline() const			{	return heapData == nullptr;	}
+
+			private:
+				void allocate(size_t size) {
+					numBytes = size;
+					heapData = size > INLINE_SIZE ? new uint8_t[size] : nullptr;
+				}
+
+				size_t numBytes;
+				uint8_t * heapData;
+				alignas(16) uint8_t inlineData[INLINE_SIZE];
+		};
+
 		UniformName name;
 		dataType_t type;
 		uint32_t numValues;
-		std::vector<uint8_t> data;
+		DataStorage data;
 };
 }
 
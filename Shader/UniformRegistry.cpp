@@ -10,63 +10,94 @@
 */
 #include "UniformRegistry.h"
 #include <Util/Macros.h>
+#include <unordered_map>
 
 namespace Rendering {
 
 //! (static)
 UniformRegistry::step_t UniformRegistry::globalUniformUpdateCounter(1); // start with 1 to make sure 0 means 'never' (and not 'initially')
 
+//! (internal) name -> handle; function local to be usable during the static initialization of other translation units.
+static std::unordered_map<Util::StringIdentifier,UniformRegistry::handle_t> & getHandleMap(){
+	static std::unordered_map<Util::StringIdentifier,UniformRegistry::handle_t> handles;
+	return handles;
+}
+
+//! (static)
+UniformRegistry::handle_t UniformRegistry::getHandle(const Util::StringIdentifier nameId){
+	auto & handles = getHandleMap();
+	return handles.emplace(nameId, static_cast<handle_t>(handles.size())).first->second;
+}
+
+//! (static)
+UniformRegistry::handle_t UniformRegistry::findHandle(const Util::StringIdentifier nameId){
+	const auto & handles = getHandleMap();
+	const auto it = handles.find(nameId);
+	return it == handles.end() ? INVALID_HANDLE : it->second;
+}
+
 //! (ctor)
-UniformRegistry::UniformRegistry() : stepOfLastApply(0),stepOfLastGlobalSync(0){
+UniformRegistry::UniformRegistry() : stepOfLastGlobalSync(0),stepOfLastSet(0){
 }
 
 //! (dtor)
-UniformRegistry::~UniformRegistry(){
-	clear();
-}
+UniformRegistry::~UniformRegistry() = default;
 
 
 void UniformRegistry::clear(){
-	for(auto & entry : uniforms) {
-		delete entry.second;
-	}
-	uniforms.clear();
-	orderedList.clear();
+	entries.clear();
+	entryIndices.clear();
+	dirtyEntries.clear();
+	stepOfLastSet = 0;
 	resetCounters();
 }
 
+void UniformRegistry::resetCounters(){
+	stepOfLastGlobalSync = 0;
+	for(uint32_t i = 0; i < entries.size(); ++i){
+		entries[i].location = -1;
+		markDirty(i);
+	}
+}
+
 void UniformRegistry::performGlobalSync(const UniformRegistry & globalUniforms, bool forced){
-	if(forced){
-		// set all global uniforms
-		for(auto it=globalUniforms.orderedList.begin();	it!=globalUniforms.orderedList.end() && (*it)->stepOfLastSet>stepOfLastGlobalSync; ++it )
-			setUniform( (*it)->uniform,false,true);
-	}else {
-		// set all uniforms of the globalUniforms-Set that have been changed since the last call.
-		for(auto it=globalUniforms.orderedList.begin();	it!=globalUniforms.orderedList.end() && (*it)->stepOfLastSet>stepOfLastGlobalSync; ++it )
-			setUniform( (*it)->uniform,false,false);
+	// set all uniforms of the globalUniforms-Set that have been changed since the last call (if forced, their appliance is forced).
+	if(globalUniforms.stepOfLastSet > stepOfLastGlobalSync){
+		for(const auto & entry : globalUniforms.entries){
+			if(entry.stepOfLastSet > stepOfLastGlobalSync)
+				setUniform(entry.handle,entry.uniform,false,forced);
+		}
 	}
 	stepOfLastGlobalSync = getNewGlobalStep();
 }
 
-void UniformRegistry::setUniform(const Uniform & uniform, bool warnIfUnused, bool forced){
-	entry_t * & entry = uniforms[uniform.getNameId()];
+void UniformRegistry::setUniform(handle_t handle, const Uniform & uniform, bool warnIfUnused, bool forced){
+	if(handle >= entryIndices.size())
+		entryIndices.resize(handle + 1, NO_ENTRY);
+	uint32_t & index = entryIndices[handle];
+
+	// the handle has to belong to the uniform's name (for an existing entry, the stored name is compared)
+	if( index == NO_ENTRY ? findHandle(uniform.getNameId()) != handle : entries[index].uniform.getNameId() != uniform.getNameId() ){
+		WARN("UniformRegistry::setUniform: The handle does not match the uniform's name. " + uniform.toString());
+		return;
+	}
 
-	if(entry==nullptr){ // new entry
-		entry = new entry_t( uniform,warnIfUnused,getNewGlobalStep() );
-		orderedList.push_front(entry);
-		entry->positionInUpdateList=orderedList.begin();
+	if(index == NO_ENTRY){ // new entry
+		index = static_cast<uint32_t>(entries.size());
+		entries.emplace_back(uniform,handle,warnIfUnused,getNewGlobalStep());
+		markDirty(index);
 	} // if an entry exists and appliance is forced or (uniform is valid and value has changed)
-	else if( forced || (entry->valid && !(uniform==entry->uniform)) ){
+	else {
+		entry_t & entry = entries[index];
+		if( forced || (entry.valid && !(uniform==entry.uniform)) ){
 
-		//! \note This warning should do no harm - otherwise remove it.
-		if(entry->uniform.getType()!=uniform.getType() ){
-			WARN("Type of Uniform changed; this may be a problem. "+entry->uniform.toString()+" -> "+uniform.toString());
+			//! \note This warning should do no harm - otherwise remove it.
+			if(entry.uniform.getType()!=uniform.getType() ){
+				WARN("Type of Uniform changed; this may be a problem. "+entry.uniform.toString()+" -> "+uniform.toString());
+			}
+			entry.reset(uniform,getNewGlobalStep(),warnIfUnused);
+			markDirty(index);
 		}
-		// move entry to the front of the orderedList
-		orderedList.erase(entry->positionInUpdateList);
-		orderedList.push_front(entry);
-
-		entry->reset(uniform,getNewGlobalStep(),warnIfUnused,orderedList.begin());
 	}
 	// else: if the value of an uniform has not changed or the uniform could not be set (= invalid), nothing needs to be done.
 }
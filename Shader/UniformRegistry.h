@@ -13,9 +13,9 @@
 
 #include "Uniform.h"
 #include <Util/StringIdentifier.h>
+#include <algorithm>
 #include <cstdint>
-#include <list>
-#include <unordered_map>
+#include <vector>
 
 namespace Rendering {
 class Shader;
@@ -23,47 +23,71 @@ class Shader;
 
 /*! (internal) Collection of Uniforms. Objects of this class are internally used by Shaders to track their Uniforms and
 	by the RenderingContext, which has one instance for managing global uniforms.
+	The uniform names are mapped to compact integer handles (shared by all registries); the entries are stored in a flat
+	array, which is indexed by these handles. Changed entries are tracked in a dirty list.
 	@ingroup shader */
 class UniformRegistry {
-	private:
-		struct entry_t;
+	public:
+		//! Compact integer id of a uniform name. The handles are shared by all registries.
+		typedef uint32_t handle_t;
+		static constexpr handle_t INVALID_HANDLE = 0xffffffff;
+
+		/*! Returns the handle of the given uniform name. A new handle is created for an unknown name.
+			\note Like the rest of the registry, this should only be used by the rendering thread. */
+		RENDERINGAPI static handle_t getHandle(const Util::StringIdentifier nameId);
+
+		//! Returns the handle of the given uniform name or INVALID_HANDLE if no handle has been created for the name.
+		RENDERINGAPI static handle_t findHandle(const Util::StringIdentifier nameId);
 
+	private:
 		typedef uint64_t step_t;
-		typedef std::list<entry_t *> orderedEntries_t;
-		typedef std::unordered_map<Util::StringIdentifier,entry_t *> uniformRegistry_t;
 
 		RENDERINGAPI static step_t globalUniformUpdateCounter;
 		static step_t getNewGlobalStep(){	return ++globalUniformUpdateCounter;	}
 
-		step_t stepOfLastApply; // =0
 		step_t stepOfLastGlobalSync; // =0
-
-		uniformRegistry_t uniforms; // collection of all known uniform-entries
-		orderedEntries_t orderedList; // ordered list of all entries (when an entry is updated, it is moved to the front)
+		step_t stepOfLastSet; // =0; the latest step at which an entry has been changed
 
 		struct entry_t{
 			Uniform uniform;
+			handle_t handle;
 			bool valid;
 			bool warnIfUnused;
+			bool dirty;
 			step_t stepOfLastSet;
 			int32_t location;
 
-			orderedEntries_t::iterator positionInUpdateList;
-
 			//! (ctor)
-			entry_t(Uniform u,bool _warn,step_t step) : uniform(std::move(u)),valid(true),warnIfUnused(_warn),stepOfLastSet(step),location(-1) {}
-			void reset(const Uniform & u,step_t step,bool warn,const orderedEntries_t::iterator & it) {
+			entry_t(Uniform u,handle_t _handle,bool _warn,step_t step) : uniform(std::move(u)),handle(_handle),valid(true),warnIfUnused(_warn),dirty(false),stepOfLastSet(step),location(-1) {}
+			void reset(const Uniform & u,step_t step,bool warn) {
 				uniform = u;
 				valid = true;
 				warnIfUnused = warn;
 				stepOfLastSet = step;
-				positionInUpdateList = it;
 			}
 		};
 
-		entry_t * getEntry(const Util::StringIdentifier nameId){
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return it==uniforms.end() ? nullptr : it->second;
+		static constexpr uint32_t NO_ENTRY = 0xffffffff;
+
+		std::vector<entry_t> entries; // all known uniform-entries
+		std::vector<uint32_t> entryIndices; // handle -> index in entries (or NO_ENTRY)
+		std::vector<uint32_t> dirtyEntries; // indices of the entries that have been changed since the last call of clearDirtyEntries()
+
+		const entry_t * getEntry(handle_t handle)const{
+			return (handle < entryIndices.size() && entryIndices[handle] != NO_ENTRY) ? &entries[entryIndices[handle]] : nullptr;
+		}
+		void markDirty(uint32_t index){
+			entry_t & entry = entries[index];
+			if(!entry.dirty){
+				entry.dirty = true;
+				dirtyEntries.push_back(index);
+			}
+			stepOfLastSet = std::max(stepOfLastSet, entry.stepOfLastSet);
+		}
+		void clearDirtyEntries(){
+			for(const auto index : dirtyEntries)
+				entries[index].dirty = false;
+			dirtyEntries.clear();
 		}
 
 		friend class Shader;
@@ -77,25 +101,34 @@ class UniformRegistry {
 
 		RENDERINGAPI void clear();
 
-		//! This forces all uniforms to be re-applied. Call this after the Shader has changed somehow.
-		void resetCounters()	{	stepOfLastApply=stepOfLastGlobalSync=0;	}
+		/*! This forces all uniforms to be re-applied (and their locations to be queried again).
+			Call this after the Shader has changed somehow. */
+		RENDERINGAPI void resetCounters();
 
 		const Uniform & getUniform(const Util::StringIdentifier nameId)const{
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return (it == uniforms.end() || !it->second->valid) ? Uniform::nullUniform : // no entry or invalid entry --> return nullUniform
-				it->second->uniform;
+			return getUniform(findHandle(nameId));
+		}
+		const Uniform & getUniform(handle_t handle)const{
+			const entry_t * entry = getEntry(handle);
+			return (entry == nullptr || !entry->valid) ? Uniform::nullUniform : // no entry or invalid entry --> return nullUniform
+				entry->uniform;
 		}
 
 		//! returns true if a uniform with the given name has already been set, but the appliance failed.
 		bool isInvalid(const Util::StringIdentifier nameId)const {
-			const uniformRegistry_t::const_iterator it(uniforms.find(nameId));
-			return it == uniforms.end() ? false : !it->second->valid;
+			const entry_t * entry = getEntry(findHandle(nameId));
+			return entry == nullptr ? false : !entry->valid;
 		}
 
 		//! Transfer all uniforms that have been changed in the globalUniforms since the last stepOfLastGlobalSync
 		RENDERINGAPI void performGlobalSync(const UniformRegistry & globalUniforms, bool forced);
 
-		RENDERINGAPI void setUniform(const Uniform & uniform, bool warnIfUnused=false, bool forced=false);
+		void setUniform(const Uniform & uniform, bool warnIfUnused=false, bool forced=false){
+			setUniform(getHandle(uniform.getNameId()), uniform, warnIfUnused, forced);
+		}
+		/*! Like setUniform(uniform, ...), but without the lookup of the uniform's name.
+			@param handle Handle of the uniform's name (see getHandle()); a handle of another name is reported and ignored. */
+		RENDERINGAPI void setUniform(handle_t handle, const Uniform & uniform, bool warnIfUnused=false, bool forced=false);
 };
 
 }
@@ -12,6 +12,7 @@
 #include "MeshUtils/MeshBuilder.h"
 #include "RenderingContext/RenderingParameters.h"
 #include "RenderingContext/RenderingContext.h"
+#include "RenderingContext/StateBlock.h"
 #include "Shader/Shader.h"
 #include "Shader/Uniform.h"
 #include "Texture/Texture.h"
@@ -82,8 +83,10 @@ void TextRenderer::draw(RenderingContext & context,
 	if(impl->shader.isNull()) {
 		impl->shader = Shader::createShader(vertexProgram, fragmentProgram, Shader::USE_UNIFORMS);
 	}
-	context.pushAndSetBlending(BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA));
-	context.pushAndSetDepthBuffer(DepthBufferParameters(false, false, Comparison::LESS));
+	static const StateBlock textState = StateBlock()
+			.withBlending(BlendingParameters(BlendingParameters::SRC_ALPHA, BlendingParameters::ONE_MINUS_SRC_ALPHA))
+			.withDepthBuffer(DepthBufferParameters(false, false, Comparison::LESS));
+	context.pushStateBlock(textState);
 	context.pushAndSetShader(impl->shader.get());
 	context.pushAndSetTexture(0, impl->texture.get());
 
@@ -140,8 +143,7 @@ void TextRenderer::draw(RenderingContext & context,
 
 	context.popTexture(0);
 	context.popShader();
-	context.popDepthBuffer();
-	context.popBlending();
+	context.popStateBlock();
 }
 
 Geometry::Rect_i TextRenderer::getTextSize(const std::u32string & text) const {
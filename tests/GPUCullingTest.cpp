@@ -0,0 +1,93 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include "../RenderingContext/RenderingContext.h"
+#include "../Texture/Texture.h"
+#include "../Texture/TextureUtils.h"
+#include "../BufferObject.h"
+#include "../GPUCulling.h"
+#include "../IndirectDrawBuilder.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#define REQUIRE_EQUAL(a,b) REQUIRE((a) == (b))
+
+using namespace Rendering;
+
+static std::vector<uint32_t> getVisibleDrawIds(GPUCulling & culling) {
+	const uint32_t count = culling.downloadVisibleCount();
+	std::vector<uint32_t> drawIds;
+	for(const auto & command : culling.getCulledCommands().downloadData<DrawElementsIndirectCommand>(BufferObject::TARGET_DRAW_INDIRECT_BUFFER, count))
+		drawIds.push_back(command.baseInstance);
+	std::sort(drawIds.begin(), drawIds.end());
+	return drawIds;
+}
+
+TEST_CASE("GPUCullingTest_testCulling", "[GPUCullingTest]") {
+	if(!GPUCulling::isSupported())
+		return;
+	RenderingContext context;
+
+	// unit cubes (in model space) at different positions; the identity matrix is used as worldToClipping
+	IndirectDrawBuilder builder;
+	std::vector<GPUCulling::ObjectBounds> bounds;
+	const std::vector<Geometry::Vec3> positions = {
+		{0.0f, 0.0f, 0.0f},		// inside
+		{5.0f, 0.0f, 0.0f},		// outside
+		{0.9f, 0.0f, 0.0f},		// intersecting the frustum
+		{0.0f, -3.0f, 0.0f},	// outside
+	};
+	for(const auto & position : positions) {
+		Geometry::Matrix4x4 modelMatrix;
+		modelMatrix.setIdentity();
+		modelMatrix.translate(position);
+		builder.addDraw(36, 0, 0, modelMatrix, 0);
+		bounds.push_back({{-0.5f, -0.5f, -0.5f, 0.0f}, {0.5f, 0.5f, 0.5f, 0.0f}});
+	}
+	BufferObject commandBuffer, drawDataBuffer, boundsBuffer;
+	builder.uploadCommands(commandBuffer);
+	builder.uploadDrawData(drawDataBuffer);
+	boundsBuffer.uploadData(BufferObject::TARGET_SHADER_STORAGE_BUFFER, bounds, BufferObject::USAGE_STATIC_DRAW);
+
+	Geometry::Matrix4x4 worldToClipping;
+	worldToClipping.setIdentity();
+
+	GPUCulling culling;
+	{ // frustum culling
+		culling.cull(context, worldToClipping, builder.getDrawCount(), commandBuffer, drawDataBuffer, boundsBuffer);
+		REQUIRE_EQUAL(2u, culling.downloadVisibleCount());
+		REQUIRE(getVisibleDrawIds(culling) == std::vector<uint32_t>({0, 2}));
+	}
+	{ // no culling
+		culling.setFrustumCullingEnabled(false);
+		culling.cull(context, worldToClipping, builder.getDrawCount(), commandBuffer, drawDataBuffer, boundsBuffer);
+		REQUIRE(getVisibleDrawIds(culling) == std::vector<uint32_t>({0, 1, 2, 3}));
+		culling.setFrustumCullingEnabled(true);
+	}
+	{ // occlusion culling; the nearest depth of the boxes is 0.25
+		auto depthPyramid = TextureUtils::createRedTexture(16, 16);
+		const auto fillDepth = [&](float depth) {
+			depthPyramid->allocateLocalData();
+			auto data = reinterpret_cast<float *>(depthPyramid->getLocalData());
+			std::fill(data, data + 16 * 16, depth);
+			depthPyramid->dataChanged();
+			depthPyramid->planMipmapCreation();
+		};
+		fillDepth(0.1f);
+		culling.cull(context, worldToClipping, builder.getDrawCount(), commandBuffer, drawDataBuffer, boundsBuffer, depthPyramid.get());
+		REQUIRE_EQUAL(0u, culling.downloadVisibleCount());
+
+		fillDepth(1.0f);
+		culling.cull(context, worldToClipping, builder.getDrawCount(), commandBuffer, drawDataBuffer, boundsBuffer, depthPyramid.get());
+		REQUIRE(getVisibleDrawIds(culling) == std::vector<uint32_t>({0, 2}));
+	}
+}
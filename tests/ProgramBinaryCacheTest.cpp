@@ -0,0 +1,61 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2014-2021 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+
+#include "../RenderingContext/RenderingContext.h"
+#include "../Shader/ProgramBinaryCache.h"
+#include "../Shader/Shader.h"
+#include "../Shader/ShaderObjectInfo.h"
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/References.h>
+#include <string>
+#include <utility>
+#define REQUIRE_EQUAL(a,b) REQUIRE((a) == (b))
+
+using namespace Rendering;
+
+static Util::Reference<Shader> createTestShader(const std::string & define) {
+	static const std::string vs("#version 330\nvoid main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }\n");
+	static const std::string fs("#version 330\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+	Util::Reference<Shader> shader = Shader::createShader(Shader::USE_UNIFORMS);
+	ShaderObjectInfo vertexObject = ShaderObjectInfo::createVertex(vs);
+	vertexObject.addDefine(define);
+	shader->attachShaderObject(std::move(vertexObject));
+	shader->attachShaderObject(ShaderObjectInfo::createFragment(fs));
+	return shader;
+}
+
+TEST_CASE("ProgramBinaryCacheTest_testCache", "[ProgramBinaryCacheTest]") {
+	RenderingContext context;
+	if(!ProgramBinaryCache::isSupported())
+		return;
+	REQUIRE(ProgramBinaryCache::enable("ProgramBinaryCacheTest"));
+	ProgramBinaryCache::clear();
+	ProgramBinaryCache::resetStatistics();
+
+	REQUIRE(createTestShader("A")->init());
+	REQUIRE_EQUAL(0u, ProgramBinaryCache::getStatistics().hits);
+	REQUIRE_EQUAL(1u, ProgramBinaryCache::getStatistics().misses);
+	REQUIRE_EQUAL(1u, ProgramBinaryCache::getStatistics().stored);
+
+	// same sources -> loaded from the cache
+	REQUIRE(createTestShader("A")->init());
+	REQUIRE_EQUAL(1u, ProgramBinaryCache::getStatistics().hits);
+	REQUIRE_EQUAL(1u, ProgramBinaryCache::getStatistics().stored);
+
+	// different defines -> compiled from source
+	REQUIRE(createTestShader("B")->init());
+	REQUIRE_EQUAL(2u, ProgramBinaryCache::getStatistics().misses);
+	REQUIRE_EQUAL(2u, ProgramBinaryCache::getStatistics().stored);
+
+	ProgramBinaryCache::clear();
+	ProgramBinaryCache::disable();
+	Util::FileUtils::remove(Util::FileName("ProgramBinaryCacheTest/"), true);
+}